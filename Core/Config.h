@@ -88,6 +88,9 @@ struct Config {
 	bool bIgnoreBadMemAccess;
 	bool bFastMemory;
 	int iCpuCore;
+	int iIRBackend;
+	bool bIRDiskCache;
+	bool bIRTieredCompile;
 	bool bCheckForNewVersion;
 	bool bForceLagSync;
 	bool bFuncReplacements;
@@ -101,6 +104,7 @@ struct Config {
 	int iLockedCPUSpeed;
 	bool bAutoSaveSymbolMap;
 	bool bCacheFullIsoInRam;
+	bool bMemoryMapIso;
 	int iRemoteISOPort;
 	std::string sLastRemoteISOServer;
 	int iLastRemoteISOPort;
@@ -131,6 +135,7 @@ struct Config {
 	std::string sCameraDevice;
 
 	bool bSoftwareRendering;
+	bool bSoftwareRenderingThread;
 	bool bHardwareTransform; // only used in the GLES backend
 	bool bSoftwareSkinning;  // may speed up some games
 	bool bVendorBugChecksEnabled;
@@ -164,6 +169,8 @@ struct Config {
 	bool bTextureBackoffCache;
 	bool bTextureSecondaryCache;
 	bool bVertexDecoderJit;
+	bool bAsyncShaderCompile;  // Create new pipelines on a worker thread, skipping their draws until ready.  Vulkan only.
+	bool bFragmentUbershader;  // Use uniforms instead of separate fragment shaders for texfunc and alpha/color test.  Vulkan only.
 	bool bFullScreen;
 	bool bFullScreenMulti;
 	int iInternalResolution;  // 0 = Auto (native), 1 = 1x (480x272), 2 = 2x, 3 = 3x, 4 = 4x and so on.
@@ -176,6 +183,8 @@ struct Config {
 	int iTexScalingType; // 0 = xBRZ, 1 = Hybrid
 	bool bTexDeposterize;
 	bool bTexHardwareScaling;
+	bool bTexScalingDiskCache;  // Keep scaled textures on disk between sessions.
+	int iTexScalingDiskCacheMB;
 	int iFpsLimit1;
 	int iFpsLimit2;
 	int iMaxRecent;
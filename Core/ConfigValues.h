@@ -36,6 +36,14 @@ enum class CPUCore {
 	IR_JIT = 2,
 };
 
+// What executes blocks when using CPUCore::IR_JIT.
+enum class IRBackend {
+	INTERPRETER = 0,
+	NATIVE = 1,
+	// Pre-decoded threaded code, for hosts without a native backend.
+	THREADED = 2,
+};
+
 enum {
 	ROTATION_AUTO = 0,
 	ROTATION_LOCKED_HORIZONTAL = 1,
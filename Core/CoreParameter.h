@@ -52,6 +52,7 @@ struct CoreParameter {
 
 	CPUCore cpuCore;
 	GPUCore gpuCore;
+	IRBackend irBackend = IRBackend::INTERPRETER;
 
 	GraphicsContext *graphicsContext = nullptr;  // TODO: Find a better place.
 	bool enableSound;  // there aren't multiple sound cores.
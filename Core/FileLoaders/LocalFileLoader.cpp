@@ -15,18 +15,23 @@
 // Official git repository and contact information can be found at
 // https://github.com/hrydgard/ppsspp and http://www.ppsspp.org/.
 
+#include <algorithm>
 #include <cstdio>
+#include <cstring>
 
 #include "ppsspp_config.h"
 #include "util/text/utf8.h"
 #include "file/file_util.h"
 #include "Common/FileUtil.h"
+#include "Core/Config.h"
 #include "Core/FileLoaders/LocalFileLoader.h"
 
 #ifdef _WIN32
 #include "Common/CommonWindows.h"
 #else
 #include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
 #endif
 
 LocalFileLoader::LocalFileLoader(const std::string &filename)
@@ -73,9 +78,52 @@ LocalFileLoader::LocalFileLoader(const std::string &filename)
 	filesize_ = end_offset.QuadPart;
 	SetFilePointerEx(handle_, zero, nullptr, FILE_BEGIN);
 #endif // _WIN32
+
+	if (g_Config.bMemoryMapIso) {
+		Map();
+	}
+}
+
+void LocalFileLoader::Map() {
+	if (filesize_ == 0 || filesize_ > (u64)SIZE_MAX) {
+		return;
+	}
+
+#ifdef _WIN32
+#if PPSSPP_PLATFORM(UWP)
+	HANDLE mapping = CreateFileMappingFromApp(handle_, nullptr, PAGE_READONLY, 0, nullptr);
+#else
+	HANDLE mapping = CreateFileMapping(handle_, nullptr, PAGE_READONLY, 0, 0, nullptr);
+#endif
+	if (mapping) {
+		// The view keeps the mapping alive.
+#if PPSSPP_PLATFORM(UWP)
+		mapped_ = (const u8 *)MapViewOfFileFromApp(mapping, FILE_MAP_READ, 0, 0);
+#else
+		mapped_ = (const u8 *)MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+#endif
+		CloseHandle(mapping);
+	}
+#else
+	void *base = mmap(nullptr, (size_t)filesize_, PROT_READ, MAP_SHARED, fd_, 0);
+	mapped_ = base == MAP_FAILED ? nullptr : (const u8 *)base;
+#endif
+
+	if (!mapped_) {
+		// Likely out of address space on 32-bit, reading works fine anyway.
+		WARN_LOG(FILESYS, "Unable to memory map %s, reading it instead", filename_.c_str());
+	}
 }
 
 LocalFileLoader::~LocalFileLoader() {
+	if (mapped_) {
+#ifdef _WIN32
+		UnmapViewOfFile(mapped_);
+#else
+		munmap((void *)mapped_, (size_t)filesize_);
+#endif
+	}
+
 #ifndef _WIN32
 	if (fd_ != -1) {
 		close(fd_);
@@ -116,7 +164,62 @@ std::string LocalFileLoader::Path() const {
 	return filename_;
 }
 
+const u8 *LocalFileLoader::MappedData(s64 absolutePos, size_t bytes) {
+	if (!mapped_ || absolutePos < 0 || (u64)absolutePos > filesize_ || bytes > filesize_ - (u64)absolutePos) {
+		return nullptr;
+	}
+	return mapped_ + absolutePos;
+}
+
+void LocalFileLoader::Prefetch(s64 absolutePos, s64 bytes) {
+	if (absolutePos < 0 || bytes <= 0 || (u64)absolutePos >= filesize_) {
+		return;
+	}
+	bytes = (s64)std::min((u64)bytes, filesize_ - (u64)absolutePos);
+
+#if !defined(_WIN32)
+	if (mapped_) {
+		// madvise() needs a page aligned start.
+		const uintptr_t pageMask = (uintptr_t)sysconf(_SC_PAGESIZE) - 1;
+		const uintptr_t start = (uintptr_t)(mapped_ + absolutePos) & ~pageMask;
+		const uintptr_t end = (uintptr_t)(mapped_ + absolutePos + bytes);
+		madvise((void *)start, end - start, MADV_WILLNEED);
+	}
+#if defined(__linux__) && !PPSSPP_PLATFORM(ANDROID)
+	else {
+		posix_fadvise(fd_, absolutePos, bytes, POSIX_FADV_WILLNEED);
+	}
+#endif
+#elif PPSSPP_PLATFORM(UWP)
+	if (mapped_) {
+		WIN32_MEMORY_RANGE_ENTRY range{ (PVOID)(mapped_ + absolutePos), (SIZE_T)bytes };
+		PrefetchVirtualMemory(GetCurrentProcess(), 1, &range, 0);
+	}
+#else
+	// Only on Windows 8 and up, and we build for 7, so look it up.
+	struct MemoryRange {
+		PVOID VirtualAddress;
+		SIZE_T NumberOfBytes;
+	};
+	typedef BOOL (WINAPI *prefetchVirtualMemory_f)(HANDLE hProcess, ULONG_PTR NumberOfEntries, MemoryRange *VirtualAddresses, ULONG Flags);
+	static const auto prefetchVirtualMemory = (prefetchVirtualMemory_f)GetProcAddress(GetModuleHandle(L"kernel32.dll"), "PrefetchVirtualMemory");
+	if (mapped_ && prefetchVirtualMemory) {
+		MemoryRange range{ (PVOID)(mapped_ + absolutePos), (SIZE_T)bytes };
+		prefetchVirtualMemory(GetCurrentProcess(), 1, &range, 0);
+	}
+#endif
+}
+
 size_t LocalFileLoader::ReadAt(s64 absolutePos, size_t bytes, size_t count, void *data, Flags flags) {
+	if (mapped_) {
+		if (absolutePos < 0 || (u64)absolutePos >= filesize_) {
+			return 0;
+		}
+		const size_t available = (size_t)std::min((u64)(bytes * count), filesize_ - (u64)absolutePos);
+		memcpy(data, mapped_ + absolutePos, available);
+		return available / bytes;
+	}
+
 #if PPSSPP_PLATFORM(ANDROID)
 	// pread64 doesn't appear to actually be 64-bit safe, though such ISOs are uncommon.  See #10862.
 	if (absolutePos <= 0x7FFFFFFF) {
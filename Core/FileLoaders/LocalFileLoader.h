@@ -34,8 +34,12 @@ class LocalFileLoader : public FileLoader {
 	virtual s64 FileSize() override;
 	virtual std::string Path() const override;
 	virtual size_t ReadAt(s64 absolutePos, size_t bytes, size_t count, void *data, Flags flags = Flags::NONE) override;
+	const u8 *MappedData(s64 absolutePos, size_t bytes) override;
+	void Prefetch(s64 absolutePos, s64 bytes) override;
 
 private:
+	void Map();
+
 #ifndef _WIN32
 	int fd_;
 #else
@@ -44,4 +48,6 @@ class LocalFileLoader : public FileLoader {
 	u64 filesize_;
 	std::string filename_;
 	std::mutex readLock_;
+	// The whole file, if g_Config.bMemoryMapIso and it could be mapped.
+	const u8 *mapped_ = nullptr;
 };
@@ -18,9 +18,13 @@
 #include <cstdio>
 #include <cstring>
 #include <algorithm>
+#include <snappy-c.h>
 #include "i18n/i18n.h"
+#include "thread/threadutil.h"
 #include "Common/FileUtil.h"
+#include "Common/StringUtils.h"
 #include "Common/Swap.h"
+#include "Common/ThreadPools.h"
 #include "Core/Loaders.h"
 #include "Core/Host.h"
 #include "Core/FileSystems/BlockDevices.h"
@@ -42,6 +46,8 @@ BlockDevice *constructBlockDevice(FileLoader *fileLoader) {
 	size_t size = fileLoader->ReadAt(0, 1, 4, buffer);
 	if (size == 4 && !memcmp(buffer, "CISO", 4))
 		return new CISOFileBlockDevice(fileLoader);
+	else if (size == 4 && !memcmp(buffer, "SZSO", 4))
+		return new SZSOFileBlockDevice(fileLoader);
 	else if (size == 4 && !memcmp(buffer, "\x00PBP", 4))
 		return new NPDRMDemoBlockDevice(fileLoader);
 	else
@@ -97,6 +103,10 @@ bool FileBlockDevice::ReadBlocks(u32 minBlock, int count, u8 *outPtr) {
 	return true;
 }
 
+void FileBlockDevice::Prefetch(u32 minBlock, u32 count) {
+	fileLoader_->Prefetch((u64)minBlock * GetBlockSize(), (s64)count * GetBlockSize());
+}
+
 // .CSO format
 
 // compressed ISO(9660) header format
@@ -126,6 +136,40 @@ typedef struct ciso_header
 // TODO: Need much better error handling.
 
 static const u32 CSO_READ_BUFFER_SIZE = 256 * 1024;
+// Decompressed frames to keep around, for partial frame reads and read-ahead.
+static const u32 CSO_FRAME_CACHE_SIZE = 1024 * 1024;
+static const u32 CSO_MIN_CACHED_FRAMES = 8;
+// How far to inflate ahead, once this many reads in a row have been sequential.
+static const u32 CSO_READ_AHEAD_SIZE = 256 * 1024;
+static const int CSO_READ_AHEAD_AFTER_READS = 2;
+// Fewer frames than this aren't worth spreading over threads.
+static const int CSO_MIN_PARALLEL_FRAMES = 8;
+
+static const u32 CSO_INVALID_FRAME = 0xFFFFFFFF;
+
+static bool InflateFrame(const u8 *src, u32 srcSize, u8 *dest, u32 frameSize, u32 frame) {
+	z_stream z{};
+	if (inflateInit2(&z, -15) != Z_OK) {
+		ERROR_LOG(LOADER, "Unable to initialize inflate: %s\n", (z.msg) ? z.msg : "?");
+		return false;
+	}
+	z.avail_in = srcSize;
+	z.next_in = (Bytef *)src;
+	z.avail_out = frameSize;
+	z.next_out = dest;
+
+	bool success = false;
+	int status = inflate(&z, Z_FINISH);
+	if (status != Z_STREAM_END) {
+		ERROR_LOG(LOADER, "Inflate frame %d: failed - %s[%d]\n", frame, (z.msg) ? z.msg : "error", status);
+	} else if (z.total_out != frameSize) {
+		ERROR_LOG(LOADER, "Inflate frame %d: block size error %d != %d\n", frame, (u32)z.total_out, frameSize);
+	} else {
+		success = true;
+	}
+	inflateEnd(&z);
+	return success;
+}
 
 CISOFileBlockDevice::CISOFileBlockDevice(FileLoader *fileLoader)
 	: fileLoader_(fileLoader)
@@ -159,12 +203,20 @@ CISOFileBlockDevice::CISOFileBlockDevice(FileLoader *fileLoader)
 	VERBOSE_LOG(LOADER, "CSO numBlocks=%i numFrames=%i align=%i", numBlocks, numFrames, indexShift);
 
 	// We might read a bit of alignment too, so be prepared.
-	if (frameSize + (1 << indexShift) < CSO_READ_BUFFER_SIZE)
-		readBuffer = new u8[CSO_READ_BUFFER_SIZE];
-	else
-		readBuffer = new u8[frameSize + (1 << indexShift)];
-	zlibBuffer = new u8[frameSize + (1 << indexShift)];
-	zlibBufferFrame = numFrames;
+	readBufferSize = std::max(CSO_READ_BUFFER_SIZE, frameSize + (1 << indexShift));
+	readBuffer = new u8[readBufferSize];
+
+	const u32 cachedFrames = std::max(CSO_MIN_CACHED_FRAMES, CSO_FRAME_CACHE_SIZE / frameSize);
+	cacheData_ = new u8[(size_t)cachedFrames * frameSize];
+	cache_.resize(cachedFrames);
+	for (u32 i = 0; i < cachedFrames; ++i) {
+		cache_[i].frame = CSO_INVALID_FRAME;
+		cache_[i].pending = false;
+		cache_[i].lastUse = 0;
+		cache_[i].data = cacheData_ + (size_t)i * frameSize;
+	}
+	// Leave at least half the cache for frames actually being read.
+	readAheadFrames_ = std::min(std::max(1U, CSO_READ_AHEAD_SIZE / frameSize), cachedFrames / 2);
 
 	const u32 indexSize = numFrames + 1;
 	const size_t headerEnd = hdr.ver > 1 ? (size_t)hdr.header_size : sizeof(hdr);
@@ -204,9 +256,238 @@ CISOFileBlockDevice::CISOFileBlockDevice(FileLoader *fileLoader)
 
 CISOFileBlockDevice::~CISOFileBlockDevice()
 {
+	if (readAheadThread_.joinable()) {
+		{
+			std::lock_guard<std::mutex> guard(cacheLock_);
+			readAheadExit_ = true;
+		}
+		readAheadCond_.notify_one();
+		readAheadThread_.join();
+	}
+
 	delete [] index;
 	delete [] readBuffer;
-	delete [] zlibBuffer;
+	delete [] readAheadBuffer_;
+	delete [] cacheData_;
+}
+
+bool CISOFileBlockDevice::IsFramePlain(u32 frame, u64 *readPos, u32 *readSize) const {
+	const u32 idx = index[frame];
+	const u32 indexPos = idx & 0x7FFFFFFF;
+	const u32 nextIndexPos = index[frame + 1] & 0x7FFFFFFF;
+
+	*readPos = (u64)indexPos << indexShift;
+	*readSize = (u32)(((u64)nextIndexPos << indexShift) - *readPos);
+	if (ver_ >= 2) {
+		// CSO v2+ requires blocks be uncompressed if large enough to be.  High bit means other things.
+		return *readSize >= frameSize;
+	}
+	return (idx & 0x80000000) != 0;
+}
+
+bool CISOFileBlockDevice::InflateFrameFromFile(u32 frame, u8 *dest, u8 *buffer, bool uncached) {
+	FileLoader::Flags flags = uncached ? FileLoader::Flags::HINT_UNCACHED : FileLoader::Flags::NONE;
+	u64 readPos;
+	u32 readSize;
+	IsFramePlain(frame, &readPos, &readSize);
+	if (readSize > readBufferSize) {
+		ERROR_LOG(LOADER, "Frame %d: compressed size %d too large", frame, readSize);
+		return false;
+	}
+
+	// If the file is memory mapped, inflate straight from it.
+	const u8 *mapped = fileLoader_->MappedData(readPos, readSize);
+	if (mapped) {
+		return InflateFrame(mapped, readSize, dest, frameSize, frame);
+	}
+	const u32 bytesRead = (u32)fileLoader_->ReadAt(readPos, 1, readSize, buffer, flags);
+	return InflateFrame(buffer, bytesRead, dest, frameSize, frame);
+}
+
+int CISOFileBlockDevice::FindCachedFrame(u32 frame, std::unique_lock<std::mutex> &guard) {
+	auto it = cacheMap_.find(frame);
+	// If it's still being read ahead, it'll be done soon.
+	while (it != cacheMap_.end() && cache_[it->second].pending) {
+		cacheCond_.wait(guard);
+		it = cacheMap_.find(frame);
+	}
+	if (it == cacheMap_.end()) {
+		return -1;
+	}
+	cache_[it->second].lastUse = ++cacheTick_;
+	return it->second;
+}
+
+int CISOFileBlockDevice::ReserveCachedFrame(u32 frame) {
+	int slot = -1;
+	for (int i = 0; i < (int)cache_.size(); ++i) {
+		if (!cache_[i].pending && (slot == -1 || cache_[i].lastUse < cache_[slot].lastUse)) {
+			slot = i;
+		}
+	}
+	if (slot == -1) {
+		return -1;
+	}
+
+	CachedFrame &cached = cache_[slot];
+	if (cached.frame != CSO_INVALID_FRAME) {
+		cacheMap_.erase(cached.frame);
+	}
+	cached.frame = frame;
+	cached.pending = true;
+	cached.lastUse = ++cacheTick_;
+	cacheMap_[frame] = slot;
+	return slot;
+}
+
+void CISOFileBlockDevice::FinishCachedFrame(int slot, bool success) {
+	CachedFrame &cached = cache_[slot];
+	cached.pending = false;
+	if (!success) {
+		cacheMap_.erase(cached.frame);
+		cached.frame = CSO_INVALID_FRAME;
+		cached.lastUse = 0;
+	}
+	cacheCond_.notify_all();
+}
+
+const u8 *CISOFileBlockDevice::GetCachedFrame(u32 frame, bool uncached, std::unique_lock<std::mutex> &guard) {
+	int slot = FindCachedFrame(frame, guard);
+	if (slot != -1) {
+		return cache_[slot].data;
+	}
+
+	slot = ReserveCachedFrame(frame);
+	if (slot == -1) {
+		return nullptr;
+	}
+	// The slot can't be evicted while pending, so inflate without holding the lock.
+	guard.unlock();
+	bool success = InflateFrameFromFile(frame, cache_[slot].data, readBuffer, uncached);
+	guard.lock();
+	FinishCachedFrame(slot, success);
+	return success ? cache_[slot].data : nullptr;
+}
+
+void CISOFileBlockDevice::NoteRead(u32 firstFrame, u32 lastFrame) {
+	if (firstFrame == lastReadFrame_ || firstFrame == lastReadFrame_ + 1) {
+		sequentialReads_++;
+	} else {
+		sequentialReads_ = 0;
+		readAheadRequested_ = 0;
+	}
+	lastReadFrame_ = lastFrame;
+
+	// Only top up once the reads have eaten into the last request.
+	if (sequentialReads_ < CSO_READ_AHEAD_AFTER_READS || lastFrame + readAheadFrames_ / 2 < readAheadRequested_) {
+		return;
+	}
+	const u32 start = std::max(lastFrame + 1, readAheadRequested_);
+	const u32 end = std::min(lastFrame + 1 + readAheadFrames_, numFrames);
+	if (start >= end) {
+		return;
+	}
+	readAheadRequested_ = end;
+
+	{
+		std::lock_guard<std::mutex> guard(cacheLock_);
+		readAheadStart_ = start;
+		readAheadEnd_ = end;
+	}
+	if (!readAheadThread_.joinable()) {
+		readAheadBuffer_ = new u8[readBufferSize];
+		readAheadThread_ = std::thread([this] { ReadAheadThread(); });
+	}
+	readAheadCond_.notify_one();
+}
+
+void CISOFileBlockDevice::ReadAheadThread() {
+	setCurrentThreadName("CSOReadAhead");
+
+	std::vector<int> slots;
+	std::unique_lock<std::mutex> guard(cacheLock_);
+	while (!readAheadExit_) {
+		if (readAheadStart_ >= readAheadEnd_) {
+			readAheadCond_.wait(guard);
+			continue;
+		}
+
+		// Take as many frames as fit in one read, skipping any we already have.
+		u64 batchStart = 0;
+		slots.clear();
+		for (; readAheadStart_ < readAheadEnd_; ++readAheadStart_) {
+			const u32 frame = readAheadStart_;
+			u64 readPos;
+			u32 readSize;
+			if (IsFramePlain(frame, &readPos, &readSize) || cacheMap_.count(frame) != 0) {
+				continue;
+			}
+			if (readSize > readBufferSize) {
+				// Corrupt index, this would never fit.  ReadBlock() will fail it.
+				continue;
+			}
+			if (slots.empty()) {
+				batchStart = readPos;
+			}
+			if (readPos + readSize - batchStart > readBufferSize) {
+				break;
+			}
+			int slot = ReserveCachedFrame(frame);
+			if (slot == -1) {
+				// Everything is busy, not worth waiting for.
+				readAheadStart_ = readAheadEnd_;
+				break;
+			}
+			slots.push_back(slot);
+		}
+		if (slots.empty()) {
+			continue;
+		}
+		guard.unlock();
+
+		u64 batchEnd = batchStart;
+		for (int slot : slots) {
+			u64 readPos;
+			u32 readSize;
+			IsFramePlain(cache_[slot].frame, &readPos, &readSize);
+			batchEnd = std::max(batchEnd, readPos + readSize);
+		}
+		const size_t batchSize = (size_t)(batchEnd - batchStart);
+		const u8 *batch = fileLoader_->MappedData(batchStart, batchSize);
+		if (!batch) {
+			const size_t bytesRead = fileLoader_->ReadAt(batchStart, 1, batchSize, readAheadBuffer_);
+			if (bytesRead < batchSize) {
+				memset(readAheadBuffer_ + bytesRead, 0, batchSize - bytesRead);
+			}
+			batch = readAheadBuffer_;
+		}
+
+		std::vector<bool> success(slots.size());
+		for (size_t i = 0; i < slots.size(); ++i) {
+			const u32 frame = cache_[slots[i]].frame;
+			u64 readPos;
+			u32 readSize;
+			IsFramePlain(frame, &readPos, &readSize);
+			success[i] = InflateFrame(batch + (readPos - batchStart), readSize, cache_[slots[i]].data, frameSize, frame);
+		}
+
+		guard.lock();
+		for (size_t i = 0; i < slots.size(); ++i) {
+			FinishCachedFrame(slots[i], success[i]);
+		}
+	}
+}
+
+void CISOFileBlockDevice::Prefetch(u32 minBlock, u32 count) {
+	if (minBlock >= numBlocks || count == 0) {
+		return;
+	}
+	const u32 lastBlock = (u32)std::min((u64)minBlock + count, (u64)numBlocks) - 1;
+	const u64 start = (u64)(index[minBlock >> blockShift] & 0x7FFFFFFF) << indexShift;
+	const u64 end = (u64)(index[(lastBlock >> blockShift) + 1] & 0x7FFFFFFF) << indexShift;
+	if (end > start) {
+		fileLoader_->Prefetch(start, end - start);
+	}
 }
 
 bool CISOFileBlockDevice::ReadBlock(int blockNumber, u8 *outPtr, bool uncached)
@@ -217,67 +498,29 @@ bool CISOFileBlockDevice::ReadBlock(int blockNumber, u8 *outPtr, bool uncached)
 		return false;
 	}
 
+	std::lock_guard<std::mutex> readGuard(readLock_);
 	const u32 frameNumber = blockNumber >> blockShift;
-	const u32 idx = index[frameNumber];
-	const u32 indexPos = idx & 0x7FFFFFFF;
-	const u32 nextIndexPos = index[frameNumber + 1] & 0x7FFFFFFF;
-	z_stream z;
-
-	const u64 compressedReadPos = (u64)indexPos << indexShift;
-	const u64 compressedReadEnd = (u64)nextIndexPos << indexShift;
-	const size_t compressedReadSize = (size_t)(compressedReadEnd - compressedReadPos);
 	const u32 compressedOffset = (blockNumber & ((1 << blockShift) - 1)) * GetBlockSize();
 
-	bool plain = (idx & 0x80000000) != 0;
-	if (ver_ >= 2) {
-		// CSO v2+ requires blocks be uncompressed if large enough to be.  High bit means other things.
-		plain = compressedReadSize >= frameSize;
-	}
-	if (plain) {
-		int readSize = (u32)fileLoader_->ReadAt(compressedReadPos + compressedOffset, 1, GetBlockSize(), outPtr, flags);
-		if (readSize < GetBlockSize())
-			memset(outPtr + readSize, 0, GetBlockSize() - readSize);
-	} else if (zlibBufferFrame == frameNumber) {
-		// We already have it.  Just apply the offset and copy.
-		memcpy(outPtr, zlibBuffer + compressedOffset, GetBlockSize());
+	u64 readPos;
+	u32 readSize;
+	if (IsFramePlain(frameNumber, &readPos, &readSize)) {
+		int bytesRead = (u32)fileLoader_->ReadAt(readPos + compressedOffset, 1, GetBlockSize(), outPtr, flags);
+		if (bytesRead < GetBlockSize())
+			memset(outPtr + bytesRead, 0, GetBlockSize() - bytesRead);
 	} else {
-		const u32 readSize = (u32)fileLoader_->ReadAt(compressedReadPos, 1, compressedReadSize, readBuffer, flags);
-
-		z.zalloc = Z_NULL;
-		z.zfree = Z_NULL;
-		z.opaque = Z_NULL;
-		if (inflateInit2(&z, -15) != Z_OK) {
-			ERROR_LOG(LOADER, "GetBlockSize() ERROR: %s\n", (z.msg) ? z.msg : "?");
-			NotifyReadError();
-			return false;
-		}
-		z.avail_in = readSize;
-		z.next_out = frameSize == (u32)GetBlockSize() ? outPtr : zlibBuffer;
-		z.avail_out = frameSize;
-		z.next_in = readBuffer;
-
-		int status = inflate(&z, Z_FINISH);
-		if (status != Z_STREAM_END) {
-			ERROR_LOG(LOADER, "block %d: inflate : %s[%d]\n", blockNumber, (z.msg) ? z.msg : "error", status);
+		std::unique_lock<std::mutex> guard(cacheLock_);
+		const u8 *data = GetCachedFrame(frameNumber, uncached, guard);
+		if (!data) {
+			guard.unlock();
 			NotifyReadError();
-			inflateEnd(&z);
 			memset(outPtr, 0, GetBlockSize());
 			return false;
 		}
-		if (z.total_out != frameSize) {
-			ERROR_LOG(LOADER, "block %d: block size error %d != %d\n", blockNumber, (u32)z.total_out, frameSize);
-			NotifyReadError();
-			inflateEnd(&z);
-			memset(outPtr, 0, GetBlockSize());
-			return false;
-		}
-		inflateEnd(&z);
-
-		if (frameSize != (u32)GetBlockSize()) {
-			zlibBufferFrame = frameNumber;
-			memcpy(outPtr, zlibBuffer + compressedOffset, GetBlockSize());
-		}
+		memcpy(outPtr, data + compressedOffset, GetBlockSize());
 	}
+
+	NoteRead(frameNumber, frameNumber);
 	return true;
 }
 
@@ -291,87 +534,434 @@ bool CISOFileBlockDevice::ReadBlocks(u32 minBlock, int count, u8 *outPtr) {
 	}
 
 	const u32 lastBlock = std::min(minBlock + count, numBlocks) - 1;
-	const u32 missingBlocks = (lastBlock + 1 - minBlock) - count;
-	if (lastBlock < minBlock + count) {
-		memset(outPtr + GetBlockSize() * (count - missingBlocks), 0, GetBlockSize() * missingBlocks);
+	const u32 validBlocks = lastBlock + 1 - minBlock;
+	if (validBlocks < (u32)count) {
+		memset(outPtr + GetBlockSize() * validBlocks, 0, GetBlockSize() * (count - validBlocks));
 	}
 
+	std::lock_guard<std::mutex> readGuard(readLock_);
 	const u32 minFrameNumber = minBlock >> blockShift;
 	const u32 lastFrameNumber = lastBlock >> blockShift;
 	const u32 afterLastIndexPos = index[lastFrameNumber + 1] & 0x7FFFFFFF;
 	const u64 totalReadEnd = (u64)afterLastIndexPos << indexShift;
 
-	z_stream z;
-	z.zalloc = Z_NULL;
-	z.zfree = Z_NULL;
-	z.opaque = Z_NULL;
-	if (inflateInit2(&z, -15) != Z_OK) {
-		ERROR_LOG(LOADER, "Unable to initialize inflate: %s\n", (z.msg) ? z.msg : "?");
+	struct InflateJob {
+		u32 frame;
+		const u8 *src;
+		u32 srcSize;
+		// Either the output, or a cache slot when only part of the frame is wanted.
+		u8 *dest;
+		int slot;
+		u8 *out;
+		u32 offset;
+		u32 size;
+		bool success;
+	};
+	std::vector<InflateJob> jobs;
+
+	u32 block = minBlock;
+	const u32 blocksPerFrame = 1 << blockShift;
+	u32 frame = minFrameNumber;
+	while (frame <= lastFrameNumber) {
+		// Read as many frames as fit in the buffer at once, and inflate those together.
+		u64 readBufferStart;
+		u32 frameReadSize;
+		IsFramePlain(frame, &readBufferStart, &frameReadSize);
+		const s64 maxNeeded = totalReadEnd - readBufferStart;
+		if (frameReadSize > readBufferSize || maxNeeded < (s64)frameReadSize) {
+			// Corrupt index, InflateFrameFromFile() refuses these too.
+			ERROR_LOG(LOADER, "Frame %d: compressed size %d too large", frame, frameReadSize);
+			NotifyReadError();
+			const u32 frameBlocks = std::min(lastBlock - block + 1, blocksPerFrame - (block & (blocksPerFrame - 1)));
+			memset(outPtr, 0, frameBlocks * GetBlockSize());
+			block += frameBlocks;
+			outPtr += frameBlocks * GetBlockSize();
+			++frame;
+			continue;
+		}
+		size_t chunkSize = (size_t)std::min(maxNeeded, (s64)std::max(frameReadSize, CSO_READ_BUFFER_SIZE));
+		// If the file is memory mapped, there's no need to copy, and everything fits at once.
+		const u8 *chunk = fileLoader_->MappedData(readBufferStart, (size_t)maxNeeded);
+		if (chunk) {
+			chunkSize = (size_t)maxNeeded;
+		} else {
+			const u32 bytesRead = (u32)fileLoader_->ReadAt(readBufferStart, 1, chunkSize, readBuffer);
+			if (bytesRead < chunkSize) {
+				memset(readBuffer + bytesRead, 0, chunkSize - bytesRead);
+			}
+			chunk = readBuffer;
+		}
+		const u64 readBufferEnd = readBufferStart + chunkSize;
+
+		jobs.clear();
+		for (; frame <= lastFrameNumber; ++frame) {
+			u64 frameReadPos;
+			bool plain = IsFramePlain(frame, &frameReadPos, &frameReadSize);
+			if (frameReadPos < readBufferStart || frameReadPos + frameReadSize > readBufferEnd) {
+				break;
+			}
+
+			const u32 frameBlockOffset = block & ((1 << blockShift) - 1);
+			const u32 frameBlocks = std::min(lastBlock - block + 1, blocksPerFrame - frameBlockOffset);
+			const u8 *rawBuffer = chunk + (frameReadPos - readBufferStart);
+			const u32 offset = frameBlockOffset * GetBlockSize();
+			const u32 size = frameBlocks * GetBlockSize();
+
+			if (plain) {
+				memcpy(outPtr, rawBuffer + offset, size);
+			} else {
+				std::unique_lock<std::mutex> guard(cacheLock_);
+				int slot = FindCachedFrame(frame, guard);
+				if (slot != -1) {
+					memcpy(outPtr, cache_[slot].data + offset, size);
+				} else if (frameBlocks == blocksPerFrame) {
+					jobs.push_back(InflateJob{ frame, rawBuffer, frameReadSize, outPtr, -1, outPtr, 0, size, false });
+				} else {
+					// Keep the whole frame, the rest of it is likely to be read next.
+					slot = ReserveCachedFrame(frame);
+					u8 *dest = slot != -1 ? cache_[slot].data : nullptr;
+					jobs.push_back(InflateJob{ frame, rawBuffer, frameReadSize, dest, slot, outPtr, offset, size, false });
+				}
+			}
+
+			block += frameBlocks;
+			outPtr += frameBlocks * GetBlockSize();
+		}
+
+		auto inflateJobs = [&](int l, int h) {
+			for (int i = l; i < h; ++i) {
+				InflateJob &job = jobs[i];
+				job.success = job.dest && InflateFrame(job.src, job.srcSize, job.dest, frameSize, job.frame);
+			}
+		};
+		if ((int)jobs.size() >= CSO_MIN_PARALLEL_FRAMES) {
+			GlobalThreadPool::Loop(inflateJobs, 0, (int)jobs.size());
+		} else {
+			inflateJobs(0, (int)jobs.size());
+		}
+
+		for (InflateJob &job : jobs) {
+			if (job.slot != -1) {
+				std::lock_guard<std::mutex> guard(cacheLock_);
+				FinishCachedFrame(job.slot, job.success);
+				if (job.success) {
+					memcpy(job.out, job.dest + job.offset, job.size);
+				}
+			}
+			if (!job.success) {
+				NotifyReadError();
+				memset(job.out, 0, job.size);
+			}
+		}
+	}
+
+	NoteRead(minFrameNumber, lastFrameNumber);
+	return true;
+}
+
+// .SZSO format
+
+struct SZSOHeader {
+	char magic[4];          // +00 : 'S','Z','S','O'
+	u32_le header_size;     // +04 : header size, the index starts here
+	u64_le total_bytes;     // +08 : size of the uncompressed data
+	u32_le frame_size;      // +10 : uncompressed size of each frame
+	u8 ver;                 // +14 : version 01
+	u8 codec;               // +15 : SZSO_CODEC_SNAPPY
+	u8 rsv_16[2];           // +16 : reserved
+	// Then numFrames + 1 u64 file offsets, the last one is the end of the data.
+	// The top bit marks frames that are stored uncompressed.
+};
+
+static_assert(sizeof(SZSOHeader) == 0x18, "SZSOHeader should not be padded");
+
+static const u8 SZSO_VERSION = 1;
+static const u8 SZSO_CODEC_SNAPPY = 1;
+static const u64 SZSO_INDEX_PLAIN = 0x8000000000000000ULL;
+static const u32 SZSO_MAX_FRAME_SIZE = 1024 * 1024;
+// Frames to compress at once when writing, spread over the thread pool.
+static const u32 SZSO_WRITE_BATCH_FRAMES = 64;
+
+SZSOFileBlockDevice::SZSOFileBlockDevice(FileLoader *fileLoader)
+	: fileLoader_(fileLoader), frameBufferFrame_(0xFFFFFFFF)
+{
+	SZSOHeader hdr;
+	size_t readSize = fileLoader->ReadAt(0, sizeof(hdr), 1, &hdr);
+	if (readSize != 1 || memcmp(hdr.magic, "SZSO", 4) != 0 || hdr.header_size < sizeof(hdr)) {
+		ERROR_LOG(LOADER, "Invalid SZSO!");
+		NotifyReadError();
+		return;
+	}
+	if (hdr.ver > SZSO_VERSION || hdr.codec != SZSO_CODEC_SNAPPY) {
+		ERROR_LOG(LOADER, "SZSO version %d codec %d unsupported", hdr.ver, hdr.codec);
+		NotifyReadError();
+		return;
+	}
+	const u32 frameSize = hdr.frame_size;
+	if ((frameSize & (frameSize - 1)) != 0 || frameSize < 0x800 || frameSize > SZSO_MAX_FRAME_SIZE) {
+		ERROR_LOG(LOADER, "SZSO frame size %i unsupported", frameSize);
+		NotifyReadError();
+		return;
+	}
+
+	frameSize_ = frameSize;
+	for (u32 i = frameSize_; i > 0x800; i >>= 1)
+		++blockShift_;
+
+	const u64 totalSize = hdr.total_bytes;
+	numFrames_ = (u32)((totalSize + frameSize_ - 1) / frameSize_);
+	numBlocks_ = (u32)(totalSize / GetBlockSize());
+	VERBOSE_LOG(LOADER, "SZSO numBlocks=%i numFrames=%i frameSize=%i", numBlocks_, numFrames_, frameSize_);
+
+	std::vector<u64_le> index(numFrames_ + 1);
+	if (fileLoader->ReadAt(hdr.header_size, sizeof(u64_le), index.size(), &index[0]) != index.size()) {
+		ERROR_LOG(LOADER, "Unable to read SZSO index");
+		NotifyReadError();
+		numFrames_ = 0;
+		numBlocks_ = 0;
+		return;
+	}
+	index_.resize(index.size());
+	for (size_t i = 0; i < index.size(); ++i)
+		index_[i] = index[i];
+
+	// Double check that it's not truncated.
+	u64 fileSize = fileLoader->FileSize();
+	u64 expectedFileSize = index_[numFrames_] & ~SZSO_INDEX_PLAIN;
+	if (expectedFileSize > fileSize) {
+		ERROR_LOG(LOADER, "Expected SZSO to at least be %lld bytes, but file is %lld bytes", expectedFileSize, fileSize);
+		NotifyReadError();
+	}
+
+	readBufferSize_ = std::max(CSO_READ_BUFFER_SIZE, (u32)snappy_max_compressed_length(frameSize_));
+	readBuffer_ = new u8[readBufferSize_];
+	frameBuffer_ = new u8[frameSize_];
+}
+
+SZSOFileBlockDevice::~SZSOFileBlockDevice() {
+	delete [] readBuffer_;
+	delete [] frameBuffer_;
+}
+
+bool SZSOFileBlockDevice::IsFramePlain(u32 frame, u64 *readPos, u32 *readSize) const {
+	*readPos = index_[frame] & ~SZSO_INDEX_PLAIN;
+	const u64 readEnd = index_[frame + 1] & ~SZSO_INDEX_PLAIN;
+	*readSize = readEnd > *readPos ? (u32)std::min(readEnd - *readPos, (u64)readBufferSize_) : 0;
+	return (index_[frame] & SZSO_INDEX_PLAIN) != 0;
+}
+
+bool SZSOFileBlockDevice::DecompressFrame(u32 frame, const u8 *src, u32 srcSize, u8 *dest) {
+	size_t outSize = frameSize_;
+	if (snappy_uncompress((const char *)src, srcSize, (char *)dest, &outSize) != SNAPPY_OK || outSize != frameSize_) {
+		ERROR_LOG(LOADER, "SZSO frame %d: failed to decompress", frame);
+		NotifyReadError();
 		return false;
 	}
+	return true;
+}
+
+void SZSOFileBlockDevice::Prefetch(u32 minBlock, u32 count) {
+	if (minBlock >= numBlocks_ || count == 0) {
+		return;
+	}
+	const u32 lastBlock = (u32)std::min((u64)minBlock + count, (u64)numBlocks_) - 1;
+	const u64 start = index_[minBlock >> blockShift_] & ~SZSO_INDEX_PLAIN;
+	const u64 end = index_[(lastBlock >> blockShift_) + 1] & ~SZSO_INDEX_PLAIN;
+	if (end > start) {
+		fileLoader_->Prefetch(start, end - start);
+	}
+}
+
+bool SZSOFileBlockDevice::ReadBlock(int blockNumber, u8 *outPtr, bool uncached) {
+	FileLoader::Flags flags = uncached ? FileLoader::Flags::HINT_UNCACHED : FileLoader::Flags::NONE;
+	if ((u32)blockNumber >= numBlocks_) {
+		memset(outPtr, 0, GetBlockSize());
+		return false;
+	}
+
+	std::lock_guard<std::mutex> guard(readLock_);
+	const u32 frameNumber = blockNumber >> blockShift_;
+	const u32 frameOffset = (blockNumber & ((1 << blockShift_) - 1)) * GetBlockSize();
+
+	u64 readPos;
+	u32 readSize;
+	if (IsFramePlain(frameNumber, &readPos, &readSize)) {
+		int bytesRead = (int)fileLoader_->ReadAt(readPos + frameOffset, 1, GetBlockSize(), outPtr, flags);
+		if (bytesRead < GetBlockSize())
+			memset(outPtr + bytesRead, 0, GetBlockSize() - bytesRead);
+		return true;
+	}
+
+	if (frameBufferFrame_ != frameNumber) {
+		const u8 *src = fileLoader_->MappedData(readPos, readSize);
+		if (!src) {
+			readSize = (u32)fileLoader_->ReadAt(readPos, 1, readSize, readBuffer_, flags);
+			src = readBuffer_;
+		}
+		if (!DecompressFrame(frameNumber, src, readSize, frameBuffer_)) {
+			frameBufferFrame_ = 0xFFFFFFFF;
+			memset(outPtr, 0, GetBlockSize());
+			return false;
+		}
+		frameBufferFrame_ = frameNumber;
+	}
+	memcpy(outPtr, frameBuffer_ + frameOffset, GetBlockSize());
+	return true;
+}
+
+bool SZSOFileBlockDevice::ReadBlocks(u32 minBlock, int count, u8 *outPtr) {
+	if (count == 1) {
+		return ReadBlock(minBlock, outPtr);
+	}
+	if (minBlock >= numBlocks_) {
+		memset(outPtr, 0, GetBlockSize() * count);
+		return false;
+	}
+
+	const u32 lastBlock = std::min(minBlock + count, numBlocks_) - 1;
+	const u32 validBlocks = lastBlock + 1 - minBlock;
+	if (validBlocks < (u32)count) {
+		memset(outPtr + GetBlockSize() * validBlocks, 0, GetBlockSize() * (count - validBlocks));
+	}
+
+	std::lock_guard<std::mutex> guard(readLock_);
+	const u32 lastFrameNumber = lastBlock >> blockShift_;
+	const u64 totalReadEnd = index_[lastFrameNumber + 1] & ~SZSO_INDEX_PLAIN;
+	const u32 blocksPerFrame = 1 << blockShift_;
 
 	u64 readBufferStart = 0;
 	u64 readBufferEnd = 0;
+	const u8 *chunk = nullptr;
 	u32 block = minBlock;
-	const u32 blocksPerFrame = 1 << blockShift;
-	for (u32 frame = minFrameNumber; frame <= lastFrameNumber; ++frame) {
-		const u32 idx = index[frame];
-		const u32 indexPos = idx & 0x7FFFFFFF;
-		const u32 nextIndexPos = index[frame + 1] & 0x7FFFFFFF;
-
-		const u64 frameReadPos = (u64)indexPos << indexShift;
-		const u64 frameReadEnd = (u64)nextIndexPos << indexShift;
-		const u32 frameReadSize = (u32)(frameReadEnd - frameReadPos);
-		const u32 frameBlockOffset = block & ((1 << blockShift) - 1);
+	bool success = true;
+	for (u32 frame = minBlock >> blockShift_; frame <= lastFrameNumber; ++frame) {
+		u64 frameReadPos;
+		u32 frameReadSize;
+		const bool plain = IsFramePlain(frame, &frameReadPos, &frameReadSize);
+		const u32 frameBlockOffset = block & (blocksPerFrame - 1);
 		const u32 frameBlocks = std::min(lastBlock - block + 1, blocksPerFrame - frameBlockOffset);
 
-		if (frameReadEnd > readBufferEnd) {
-			const s64 maxNeeded = totalReadEnd - frameReadPos;
-			const size_t chunkSize = (size_t)std::min(maxNeeded, (s64)std::max(frameReadSize, CSO_READ_BUFFER_SIZE));
-
-			const u32 readSize = (u32)fileLoader_->ReadAt(frameReadPos, 1, chunkSize, readBuffer);
-			if (readSize < chunkSize) {
-				memset(readBuffer + readSize, 0, chunkSize - readSize);
+		if (frameReadPos < readBufferStart || frameReadPos + frameReadSize > readBufferEnd) {
+			// If the file is memory mapped, there's no need to copy, and everything fits at once.
+			size_t chunkSize = (size_t)(totalReadEnd - frameReadPos);
+			chunk = fileLoader_->MappedData(frameReadPos, chunkSize);
+			if (!chunk) {
+				chunkSize = std::min(chunkSize, (size_t)readBufferSize_);
+				const size_t bytesRead = fileLoader_->ReadAt(frameReadPos, 1, chunkSize, readBuffer_);
+				if (bytesRead < chunkSize) {
+					memset(readBuffer_ + bytesRead, 0, chunkSize - bytesRead);
+				}
+				chunk = readBuffer_;
 			}
-
 			readBufferStart = frameReadPos;
-			readBufferEnd = frameReadPos + readSize;
+			readBufferEnd = frameReadPos + chunkSize;
 		}
 
-		u8 *rawBuffer = &readBuffer[frameReadPos - readBufferStart];
-		const int plain = idx & 0x80000000;
+		const u8 *rawBuffer = chunk + (frameReadPos - readBufferStart);
 		if (plain) {
 			memcpy(outPtr, rawBuffer + frameBlockOffset * GetBlockSize(), frameBlocks * GetBlockSize());
-		} else {
-			z.avail_in = frameReadSize;
-			z.next_out = frameBlocks == blocksPerFrame ? outPtr : zlibBuffer;
-			z.avail_out = frameSize;
-			z.next_in = rawBuffer;
-
-			int status = inflate(&z, Z_FINISH);
-			if (status != Z_STREAM_END) {
-				ERROR_LOG(LOADER, "Inflate frame %d: failed - %s[%d]\n", frame, (z.msg) ? z.msg : "error", status);
-				NotifyReadError();
+		} else if (frameBlocks == blocksPerFrame) {
+			if (!DecompressFrame(frame, rawBuffer, frameReadSize, outPtr)) {
 				memset(outPtr, 0, frameBlocks * GetBlockSize());
-			} else if (z.total_out != frameSize) {
-				ERROR_LOG(LOADER, "Inflate frame %d: block size error %d != %d\n", frame, (u32)z.total_out, frameSize);
-				NotifyReadError();
-				memset(outPtr, 0, frameBlocks * GetBlockSize());
-			} else if (frameBlocks != blocksPerFrame) {
-				memcpy(outPtr, zlibBuffer + frameBlockOffset * GetBlockSize(), frameBlocks * GetBlockSize());
-				// In case we end up reusing it in a single read later.
-				zlibBufferFrame = frame;
+				success = false;
 			}
-
-			inflateReset(&z);
+		} else if (frameBufferFrame_ == frame || DecompressFrame(frame, rawBuffer, frameReadSize, frameBuffer_)) {
+			// Keep it, since the rest of the frame is likely to be read next.
+			frameBufferFrame_ = frame;
+			memcpy(outPtr, frameBuffer_ + frameBlockOffset * GetBlockSize(), frameBlocks * GetBlockSize());
+		} else {
+			frameBufferFrame_ = 0xFFFFFFFF;
+			memset(outPtr, 0, frameBlocks * GetBlockSize());
+			success = false;
 		}
 
 		block += frameBlocks;
 		outPtr += frameBlocks * GetBlockSize();
 	}
+	return success;
+}
 
-	inflateEnd(&z);
-	return true;
+bool WriteSZSOImage(BlockDevice *src, const std::string &filename, u32 frameSize, std::string *error) {
+	if ((frameSize & (frameSize - 1)) != 0 || frameSize < 0x800 || frameSize > SZSO_MAX_FRAME_SIZE) {
+		*error = StringFromFormat("Unsupported frame size %d, must be a power of two from 2048 to %d", frameSize, SZSO_MAX_FRAME_SIZE);
+		return false;
+	}
+
+	FILE *f = File::OpenCFile(filename, "wb");
+	if (!f) {
+		*error = "Unable to create " + filename;
+		return false;
+	}
+
+	const u32 blocksPerFrame = frameSize / src->GetBlockSize();
+	const u64 totalBytes = (u64)src->GetNumBlocks() * src->GetBlockSize();
+	const u32 numFrames = (u32)((totalBytes + frameSize - 1) / frameSize);
+
+	SZSOHeader hdr{};
+	memcpy(hdr.magic, "SZSO", 4);
+	hdr.header_size = sizeof(hdr);
+	hdr.total_bytes = totalBytes;
+	hdr.frame_size = frameSize;
+	hdr.ver = SZSO_VERSION;
+	hdr.codec = SZSO_CODEC_SNAPPY;
+
+	// The index is written last, once the sizes are known.
+	std::vector<u64_le> index(numFrames + 1);
+	u64 pos = sizeof(hdr) + index.size() * sizeof(u64_le);
+	bool success = fseek(f, (long)pos, SEEK_SET) == 0;
+
+	const size_t maxCompressed = snappy_max_compressed_length(frameSize);
+	std::vector<u8> raw((size_t)SZSO_WRITE_BATCH_FRAMES * frameSize);
+	std::vector<char> compressed(SZSO_WRITE_BATCH_FRAMES * maxCompressed);
+	std::vector<size_t> compressedSizes(SZSO_WRITE_BATCH_FRAMES);
+	for (u32 first = 0; success && first < numFrames; first += SZSO_WRITE_BATCH_FRAMES) {
+		const u32 frames = std::min(SZSO_WRITE_BATCH_FRAMES, numFrames - first);
+		// The last frame is padded with zeroes.
+		const u32 blocks = std::min(frames * blocksPerFrame, src->GetNumBlocks() - first * blocksPerFrame);
+		memset(raw.data() + (size_t)blocks * src->GetBlockSize(), 0, (size_t)(frames * blocksPerFrame - blocks) * src->GetBlockSize());
+		if (!src->ReadBlocks(first * blocksPerFrame, blocks, &raw[0])) {
+			*error = "Unable to read source image";
+			success = false;
+			break;
+		}
+
+		GlobalThreadPool::Loop([&](int l, int h) {
+			for (int i = l; i < h; ++i) {
+				compressedSizes[i] = maxCompressed;
+				if (snappy_compress((const char *)&raw[(size_t)i * frameSize], frameSize, &compressed[i * maxCompressed], &compressedSizes[i]) != SNAPPY_OK) {
+					compressedSizes[i] = frameSize;
+				}
+			}
+		}, 0, (int)frames);
+
+		for (u32 i = 0; i < frames; ++i) {
+			// Not worth decompressing if it didn't get smaller.
+			const bool plain = compressedSizes[i] >= frameSize;
+			const void *data = plain ? (const void *)&raw[(size_t)i * frameSize] : (const void *)&compressed[i * maxCompressed];
+			const size_t size = plain ? frameSize : compressedSizes[i];
+			index[first + i] = pos | (plain ? SZSO_INDEX_PLAIN : 0);
+			if (fwrite(data, 1, size, f) != size) {
+				*error = "Unable to write " + filename;
+				success = false;
+				break;
+			}
+			pos += size;
+		}
+	}
+	index[numFrames] = pos;
+
+	if (success && (fseek(f, 0, SEEK_SET) != 0 || fwrite(&hdr, sizeof(hdr), 1, f) != 1 || fwrite(&index[0], sizeof(u64_le), index.size(), f) != index.size())) {
+		*error = "Unable to write " + filename;
+		success = false;
+	}
+	success = fclose(f) == 0 && success;
+	if (!success) {
+		if (error->empty()) {
+			*error = "Unable to write " + filename;
+		}
+		File::Delete(filename);
+	}
+	return success;
 }
 
 NPDRMDemoBlockDevice::NPDRMDemoBlockDevice(FileLoader *fileLoader)
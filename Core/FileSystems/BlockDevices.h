@@ -23,7 +23,12 @@
 // The ISOFileSystemReader reads from a BlockDevice, so it automatically works
 // with CISO images.
 
+#include <condition_variable>
 #include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
 
 #include "Common/CommonTypes.h"
 #include "Core/ELF/PBPReader.h"
@@ -45,6 +50,8 @@ class BlockDevice {
 	}
 	int GetBlockSize() const { return 2048;}  // forced, it cannot be changed by subclasses
 	virtual u32 GetNumBlocks() = 0;
+	// Hints that these blocks are likely to be read soon.
+	virtual void Prefetch(u32 minBlock, u32 count) {}
 
 	u32 CalculateCRC();
 	void NotifyReadError();
@@ -53,6 +60,9 @@ class BlockDevice {
 	bool reportedError_ = false;
 };
 
+// Decompressed frames are kept in a small LRU cache.  Once reads look sequential, the
+// frames after them are inflated ahead of time on a worker thread, and large reads inflate
+// their frames in parallel.
 class CISOFileBlockDevice : public BlockDevice {
 public:
 	CISOFileBlockDevice(FileLoader *fileLoader);
@@ -60,19 +70,95 @@ class CISOFileBlockDevice : public BlockDevice {
 	bool ReadBlock(int blockNumber, u8 *outPtr, bool uncached = false) override;
 	bool ReadBlocks(u32 minBlock, int count, u8 *outPtr) override;
 	u32 GetNumBlocks() override { return numBlocks; }
+	void Prefetch(u32 minBlock, u32 count) override;
 
 private:
+	struct CachedFrame {
+		u32 frame;
+		// Still being inflated, can't be read or evicted yet.
+		bool pending;
+		u64 lastUse;
+		u8 *data;
+	};
+
+	bool IsFramePlain(u32 frame, u64 *readPos, u32 *readSize) const;
+	bool InflateFrameFromFile(u32 frame, u8 *dest, u8 *buffer, bool uncached);
+
+	// These must be called with cacheLock_ held.
+	const u8 *GetCachedFrame(u32 frame, bool uncached, std::unique_lock<std::mutex> &guard);
+	int FindCachedFrame(u32 frame, std::unique_lock<std::mutex> &guard);
+	int ReserveCachedFrame(u32 frame);
+	void FinishCachedFrame(int slot, bool success);
+
+	void NoteRead(u32 firstFrame, u32 lastFrame);
+	void ReadAheadThread();
+
 	FileLoader *fileLoader_;
 	u32 *index;
 	u8 *readBuffer;
-	u8 *zlibBuffer;
-	u32 zlibBufferFrame;
+	u32 readBufferSize;
 	u8 indexShift;
 	u8 blockShift;
 	u32 frameSize;
 	u32 numBlocks;
 	u32 numFrames;
 	int ver_;
+
+	// Only one ReadBlock/ReadBlocks at a time, since they share readBuffer.
+	std::mutex readLock_;
+
+	std::mutex cacheLock_;
+	std::condition_variable cacheCond_;
+	std::vector<CachedFrame> cache_;
+	std::unordered_map<u32, int> cacheMap_;
+	u8 *cacheData_ = nullptr;
+	u64 cacheTick_ = 0;
+
+	// Sequential read detection, under readLock_.
+	u32 lastReadFrame_ = 0;
+	int sequentialReads_ = 0;
+	u32 readAheadFrames_ = 0;
+	u32 readAheadRequested_ = 0;
+
+	// Read-ahead work, under cacheLock_.
+	std::thread readAheadThread_;
+	std::condition_variable readAheadCond_;
+	u8 *readAheadBuffer_ = nullptr;
+	u32 readAheadStart_ = 0;
+	u32 readAheadEnd_ = 0;
+	bool readAheadExit_ = false;
+};
+
+
+// Compressed iso images in the SZSO format.  Like CISO, but frames are compressed with snappy,
+// which decodes several times faster than deflate, and the index is 64-bit.
+// See WriteSZSOImage() below to create them.
+class SZSOFileBlockDevice : public BlockDevice {
+public:
+	SZSOFileBlockDevice(FileLoader *fileLoader);
+	~SZSOFileBlockDevice();
+	bool ReadBlock(int blockNumber, u8 *outPtr, bool uncached = false) override;
+	bool ReadBlocks(u32 minBlock, int count, u8 *outPtr) override;
+	u32 GetNumBlocks() override { return numBlocks_; }
+	void Prefetch(u32 minBlock, u32 count) override;
+
+private:
+	bool IsFramePlain(u32 frame, u64 *readPos, u32 *readSize) const;
+	bool DecompressFrame(u32 frame, const u8 *src, u32 srcSize, u8 *dest);
+
+	FileLoader *fileLoader_;
+	std::vector<u64> index_;
+	u8 *readBuffer_ = nullptr;
+	u32 readBufferSize_ = 0;
+	u8 *frameBuffer_ = nullptr;
+	u32 frameBufferFrame_;
+	u32 frameSize_ = 0;
+	u8 blockShift_ = 0;
+	u32 numBlocks_ = 0;
+	u32 numFrames_ = 0;
+
+	// Only one ReadBlock/ReadBlocks at a time, since they share the buffers.
+	std::mutex readLock_;
 };
 
 
@@ -83,6 +169,7 @@ class FileBlockDevice : public BlockDevice {
 	bool ReadBlock(int blockNumber, u8 *outPtr, bool uncached = false) override;
 	bool ReadBlocks(u32 minBlock, int count, u8 *outPtr) override;
 	u32 GetNumBlocks() override {return (u32)(filesize_ / GetBlockSize());}
+	void Prefetch(u32 minBlock, u32 count) override;
 
 private:
 	FileLoader *fileLoader_;
@@ -129,3 +216,6 @@ class NPDRMDemoBlockDevice : public BlockDevice {
 
 
 BlockDevice *constructBlockDevice(FileLoader *fileLoader);
+
+// Compresses all of src into a new SZSO image.  frameSize must be a power of two, from 2048 up.
+bool WriteSZSOImage(BlockDevice *src, const std::string &filename, u32 frameSize, std::string *error);
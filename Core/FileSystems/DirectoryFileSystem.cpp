@@ -868,7 +868,7 @@ std::vector<PSPFileInfo> DirectoryFileSystem::GetDirListing(std::string path) {
 		entry.name = SimulateVFATBug(ConvertWStringToUTF8(findData.cFileName));
 
 		bool hideFile = false;
-		if (hideISOFiles && (endsWithNoCase(entry.name, ".cso") || endsWithNoCase(entry.name, ".iso"))) {
+		if (hideISOFiles && (endsWithNoCase(entry.name, ".cso") || endsWithNoCase(entry.name, ".szo") || endsWithNoCase(entry.name, ".iso"))) {
 			// Workaround for DJ Max Portable, see compat.ini.
 			hideFile = true;
 		}
@@ -916,7 +916,7 @@ std::vector<PSPFileInfo> DirectoryFileSystem::GetDirListing(std::string path) {
 		entry.size = s.st_size;
 
 		bool hideFile = false;
-		if (hideISOFiles && (endsWithNoCase(entry.name, ".cso") || endsWithNoCase(entry.name, ".iso"))) {
+		if (hideISOFiles && (endsWithNoCase(entry.name, ".cso") || endsWithNoCase(entry.name, ".szo") || endsWithNoCase(entry.name, ".iso"))) {
 			// Workaround for DJ Max Portable, see compat.ini.
 			hideFile = true;
 		}
@@ -103,6 +103,16 @@ struct PSPFileInfo {
 	u32 sectorSize;
 };
 
+// A read whose file position and timing were settled when it was issued, with the data read
+// later.  See IFileSystem::ReserveRead().
+struct ReservedRead {
+	// What ReadFile() would have returned.
+	size_t result = 0;
+	int usec = 0;
+	// Where to read from, in terms only the filesystem understands.
+	u64 position = 0;
+	u64 bytes = 0;
+};
 
 class IFileSystem {
 public:
@@ -128,6 +138,13 @@ class IFileSystem {
 	virtual int      DevType(u32 handle) = 0;
 	virtual int      Flags() = 0;
 	virtual u64      FreeSpace(const std::string &path) = 0;
+
+	// Async reads can be split in two, so that the timing model sees them in the order they're
+	// issued, while the data is read later on any thread (and overlapping other reserved reads.)
+	// ReserveRead() does everything ReadFile() does except reading, and returns false if the
+	// filesystem doesn't support this.
+	virtual bool     ReserveRead(u32 handle, s64 size, ReservedRead &read) { return false; }
+	virtual void     ReadReserved(u32 handle, const ReservedRead &read, u8 *pointer) {}
 };
 
 
@@ -29,6 +29,8 @@
 #include "Core/Reporting.h"
 
 const int sectorSize = 2048;
+// Opening a file prefetches at most this much of it.
+static const s64 ISO_PREFETCH_MAX_SIZE = 16 * 1024 * 1024;
 
 bool parseLBN(std::string filename, u32 *sectorStart, u32 *readSize) {
 	// The format of this is: "/sce_lbn" "0x"? HEX* ANY* "_size" "0x"? HEX* ANY*
@@ -201,6 +203,8 @@ ISOFileSystem::~ISOFileSystem() {
 }
 
 void ISOFileSystem::ReadDirectory(TreeEntry *root) {
+	// Children are indexed by full path (without the leading slash), so lookups don't need to walk the tree.
+	const std::string indexPrefix = root == treeroot ? "" : EntryFullPath(root).substr(1) + "/";
 	for (u32 secnum = root->startsector, endsector = root->startsector + (root->dirsize + 2047) / 2048; secnum < endsector; ++secnum) {
 		u8 theSector[2048];
 		if (!blockDevice->ReadBlock(secnum, theSector)) {
@@ -261,6 +265,10 @@ void ISOFileSystem::ReadDirectory(TreeEntry *root) {
 				}
 			}
 			root->children.push_back(entry);
+			if (!relative) {
+				// If a name is repeated, the first one wins, same as the walk in GetFromPath.
+				pathIndex_.emplace(indexPrefix + entry->name, entry);
+			}
 		}
 	}
 	root->valid = true;
@@ -287,6 +295,34 @@ ISOFileSystem::TreeEntry *ISOFileSystem::GetFromPath(const std::string &path, bo
 	if (pathLength <= pathIndex)
 		return treeroot;
 
+	if (!treeroot->valid) {
+		ReadDirectory(treeroot);
+	}
+
+	// Most lookups are plain paths to something in a directory already read, which the index has.
+	const std::string key = path.substr(pathIndex);
+	auto found = pathIndex_.find(key);
+	if (found != pathIndex_.end()) {
+		if (!found->second->valid)
+			ReadDirectory(found->second);
+		return found->second;
+	}
+
+	// If the parent is indexed and read, a miss on a plain name is final.  Otherwise ("." or "..",
+	// doubled or trailing slashes, or a directory not yet read), walk the tree below.
+	const size_t lastSlash = key.rfind('/');
+	const std::string leaf = lastSlash == std::string::npos ? key : key.substr(lastSlash + 1);
+	TreeEntry *parent = treeroot;
+	if (lastSlash != std::string::npos) {
+		auto parentFound = pathIndex_.find(key.substr(0, lastSlash));
+		parent = parentFound != pathIndex_.end() ? parentFound->second : nullptr;
+	}
+	if (parent && parent->valid && parent->isDirectory && !leaf.empty() && leaf != "." && leaf != "..") {
+		if (catchError)
+			ERROR_LOG(FILESYS, "File %s not found", path.c_str());
+		return nullptr;
+	}
+
 	TreeEntry *entry = treeroot;
 	while (true) {
 		if (!entry->valid) {
@@ -377,6 +413,11 @@ int ISOFileSystem::OpenFile(std::string filename, FileAccess access, const char
 
 	if (entry.file == &entireISO)
 		entry.isBlockSectorMode = true;
+	else if (!entry.file->isDirectory && entry.file->size > 0) {
+		// It's likely to be read soon, so let the OS start reading it in (or the start of it, if huge.)
+		const s64 prefetchSize = std::min(entry.file->size, (s64)ISO_PREFETCH_MAX_SIZE);
+		blockDevice->Prefetch(entry.file->startingPosition / 2048, (u32)((prefetchSize + 2047) / 2048));
+	}
 
 	entry.seekPos = 0;
 
@@ -474,25 +515,36 @@ size_t ISOFileSystem::ReadFile(u32 handle, u8 *pointer, s64 size)
 }
 
 size_t ISOFileSystem::ReadFile(u32 handle, u8 *pointer, s64 size, int &usec) {
+	ReservedRead read;
+	ReserveRead(handle, size, read);
+	ReadReserved(handle, read, pointer);
+	if (read.usec != 0)
+		usec = read.usec;
+	return read.result;
+}
+
+bool ISOFileSystem::ReserveRead(u32 handle, s64 size, ReservedRead &read) {
 	EntryMap::iterator iter = entries.find(handle);
 	if (iter != entries.end()) {
 		OpenFileEntry &e = iter->second;
 
 		if (size < 0) {
 			ERROR_LOG_REPORT(FILESYS, "Invalid read for %lld bytes from umd %s", size, e.file ? e.file->name.c_str() : "device");
-			return 0;
+			return true;
 		}
 		
 		if (e.isBlockSectorMode) {
 			// Whole sectors! Shortcut to this simple code.
-			blockDevice->ReadBlocks(e.seekPos, (int)size, pointer);
 			if (abs((int)lastReadBlock_ - (int)e.seekPos) > 100) {
 				// This is an estimate, sometimes it takes 1+ seconds, but it definitely takes time.
-				usec = 100000;
+				read.usec = 100000;
 			}
+			read.position = e.seekPos * 2048ULL;
+			read.bytes = size * 2048ULL;
+			read.result = (int)size;
 			e.seekPos += (int)size;
 			lastReadBlock_ = e.seekPos;
-			return (int)size;
+			return true;
 		}
 
 		u64 positionOnIso;
@@ -502,7 +554,7 @@ size_t ISOFileSystem::ReadFile(u32 handle, u8 *pointer, s64 size, int &usec) {
 			fileSize = (s64)e.openSize;
 		} else if (e.file == nullptr) {
 			ERROR_LOG(FILESYS, "File no longer exists (loaded savestate with different ISO?)");
-			return 0;
+			return true;
 		} else {
 			positionOnIso = e.file->startingPosition + e.seekPos;
 			fileSize = e.file->size;
@@ -510,7 +562,7 @@ size_t ISOFileSystem::ReadFile(u32 handle, u8 *pointer, s64 size, int &usec) {
 
 		if ((s64)e.seekPos > fileSize) {
 			WARN_LOG(FILESYS, "Read starting outside of file, at %lld / %lld", (s64)e.seekPos, fileSize);
-			return 0;
+			return true;
 		}
 		if ((s64)e.seekPos + size > fileSize) {
 			// Clamp to the remaining size, but read what we can.
@@ -519,46 +571,55 @@ size_t ISOFileSystem::ReadFile(u32 handle, u8 *pointer, s64 size, int &usec) {
 			size = newSize;
 		}
 
-		// Okay, we have size and position, let's rock.
-		const int firstBlockOffset = positionOnIso & 2047;
-		const int firstBlockSize = firstBlockOffset == 0 ? 0 : (int)std::min(size, 2048LL - firstBlockOffset);
-		const int lastBlockSize = (size - firstBlockSize) & 2047;
-		const s64 middleSize = size - firstBlockSize - lastBlockSize;
-		u32 secNum = (u32)(positionOnIso / 2048);
-		u8 theSector[2048];
-
-		_dbg_assert_msg_(FILESYS, (middleSize & 2047) == 0, "Remaining size should be aligned");
-
-		const u8 *const start = pointer;
-		if (firstBlockSize > 0) {
-			blockDevice->ReadBlock(secNum++, theSector);
-			memcpy(pointer, theSector + firstBlockOffset, firstBlockSize);
-			pointer += firstBlockSize;
-		}
-		if (middleSize > 0) {
-			const u32 sectors = (u32)(middleSize / 2048);
-			blockDevice->ReadBlocks(secNum, sectors, pointer);
-			secNum += sectors;
-			pointer += middleSize;
-		}
-		if (lastBlockSize > 0) {
-			blockDevice->ReadBlock(secNum++, theSector);
-			memcpy(pointer, theSector, lastBlockSize);
-			pointer += lastBlockSize;
-		}
-
-		size_t totalBytes = pointer - start;
-		if (abs((int)lastReadBlock_ - (int)secNum) > 100) {
+		// Where the read will leave the drive.
+		const u32 endSecNum = (u32)(size == 0 ? positionOnIso / 2048 : (positionOnIso + size + 2047) / 2048);
+		if (abs((int)lastReadBlock_ - (int)endSecNum) > 100) {
 			// This is an estimate, sometimes it takes 1+ seconds, but it definitely takes time.
-			usec = 100000;
+			read.usec = 100000;
 		}
-		lastReadBlock_ = secNum;
-		e.seekPos += (unsigned int)totalBytes;
-		return (size_t)totalBytes;
+		lastReadBlock_ = endSecNum;
+
+		read.position = positionOnIso;
+		read.bytes = size;
+		read.result = (size_t)size;
+		e.seekPos += (unsigned int)size;
+		return true;
 	} else {
 		//This shouldn't happen...
 		ERROR_LOG(FILESYS, "Hey, what are you doing? Reading non-open files?");
-		return 0;
+		return true;
+	}
+}
+
+// Only touches the block device, so this is safe to call from any thread.
+void ISOFileSystem::ReadReserved(u32 handle, const ReservedRead &read, u8 *pointer) {
+	// Okay, we have size and position, let's rock.
+	const u64 positionOnIso = read.position;
+	const s64 size = (s64)read.bytes;
+	const int firstBlockOffset = positionOnIso & 2047;
+	const int firstBlockSize = firstBlockOffset == 0 ? 0 : (int)std::min(size, 2048LL - firstBlockOffset);
+	const int lastBlockSize = (size - firstBlockSize) & 2047;
+	const s64 middleSize = size - firstBlockSize - lastBlockSize;
+	u32 secNum = (u32)(positionOnIso / 2048);
+	u8 theSector[2048];
+
+	_dbg_assert_msg_(FILESYS, (middleSize & 2047) == 0, "Remaining size should be aligned");
+
+	if (firstBlockSize > 0) {
+		blockDevice->ReadBlock(secNum++, theSector);
+		memcpy(pointer, theSector + firstBlockOffset, firstBlockSize);
+		pointer += firstBlockSize;
+	}
+	if (middleSize > 0) {
+		const u32 sectors = (u32)(middleSize / 2048);
+		blockDevice->ReadBlocks(secNum, sectors, pointer);
+		secNum += sectors;
+		pointer += middleSize;
+	}
+	if (lastBlockSize > 0) {
+		blockDevice->ReadBlock(secNum++, theSector);
+		memcpy(pointer, theSector, lastBlockSize);
+		pointer += lastBlockSize;
 	}
 }
 
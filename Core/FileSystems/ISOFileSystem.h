@@ -19,6 +19,7 @@
 
 #include <map>
 #include <list>
+#include <unordered_map>
 
 #include "FileSystem.h"
 
@@ -44,6 +45,8 @@ class ISOFileSystem : public IFileSystem {
 	int      DevType(u32 handle) override;
 	int      Flags() override { return 0; }
 	u64      FreeSpace(const std::string &path) override { return 0; }
+	bool     ReserveRead(u32 handle, s64 size, ReservedRead &read) override;
+	void     ReadReserved(u32 handle, const ReservedRead &read, u8 *pointer) override;
 
 	size_t WriteFile(u32 handle, const u8 *pointer, s64 size) override;
 	size_t WriteFile(u32 handle, const u8 *pointer, s64 size, int &usec) override;
@@ -91,6 +94,8 @@ class ISOFileSystem : public IFileSystem {
 	u32 lastReadBlock_;
 
 	TreeEntry entireISO;
+	// Every entry in a directory read so far, by full path without the leading slash.
+	std::unordered_map<std::string, TreeEntry *> pathIndex_;
 
 	void ReadDirectory(TreeEntry *root);
 	TreeEntry *GetFromPath(const std::string &path, bool catchError = true);
@@ -138,6 +143,12 @@ class ISOBlockSystem : public IFileSystem {
 		return isoFileSystem_->DevType(handle);
 	}
 	int      Flags() override { return isoFileSystem_->Flags(); }
+	bool     ReserveRead(u32 handle, s64 size, ReservedRead &read) override {
+		return isoFileSystem_->ReserveRead(handle, size, read);
+	}
+	void     ReadReserved(u32 handle, const ReservedRead &read, u8 *pointer) override {
+		isoFileSystem_->ReadReserved(handle, read, pointer);
+	}
 	u64      FreeSpace(const std::string &path) override { return isoFileSystem_->FreeSpace(path); }
 
 	size_t WriteFile(u32 handle, const u8 *pointer, s64 size) override {
@@ -287,7 +287,10 @@ void MetaFileSystem::Unmount(std::string prefix, IFileSystem *system) {
 }
 
 void MetaFileSystem::Remount(std::string prefix, IFileSystem *newSystem) {
-	std::lock_guard<std::recursive_mutex> guard(lock);
+	std::unique_lock<std::recursive_mutex> guard(lock);
+	while (unlockedReads_ > 0)
+		unlockedReadsDone_.wait(guard);
+
 	IFileSystem *oldSystem = nullptr;
 	for (auto &it : fileSystems) {
 		if (it.prefix == prefix) {
@@ -324,7 +327,9 @@ IFileSystem *MetaFileSystem::GetSystem(const std::string &prefix) {
 
 void MetaFileSystem::Shutdown()
 {
-	std::lock_guard<std::recursive_mutex> guard(lock);
+	std::unique_lock<std::recursive_mutex> guard(lock);
+	while (unlockedReads_ > 0)
+		unlockedReadsDone_.wait(guard);
 	current = 6;
 
 	// Ownership is a bit convoluted. Let's just delete everything once.
@@ -583,6 +588,32 @@ size_t MetaFileSystem::ReadFile(u32 handle, u8 *pointer, s64 size, int &usec)
 		return 0;
 }
 
+bool MetaFileSystem::ReserveRead(u32 handle, s64 size, ReservedRead &read)
+{
+	std::lock_guard<std::recursive_mutex> guard(lock);
+	IFileSystem *sys = GetHandleOwner(handle);
+	if (sys)
+		return sys->ReserveRead(handle, size, read);
+	else
+		return false;
+}
+
+void MetaFileSystem::ReadReserved(u32 handle, const ReservedRead &read, u8 *pointer)
+{
+	std::unique_lock<std::recursive_mutex> guard(lock);
+	IFileSystem *sys = GetHandleOwner(handle);
+	if (!sys)
+		return;
+
+	// Let other reads (and everything else) proceed meanwhile.
+	unlockedReads_++;
+	guard.unlock();
+	sys->ReadReserved(handle, read, pointer);
+	guard.lock();
+	if (--unlockedReads_ == 0)
+		unlockedReadsDone_.notify_all();
+}
+
 size_t MetaFileSystem::WriteFile(u32 handle, const u8 *pointer, s64 size, int &usec)
 {
 	std::lock_guard<std::recursive_mutex> guard(lock);
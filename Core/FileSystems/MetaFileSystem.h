@@ -20,6 +20,7 @@
 #include <string>
 #include <vector>
 #include <mutex>
+#include <condition_variable>
 
 #include "Core/FileSystems/FileSystem.h"
 
@@ -42,6 +43,9 @@ class MetaFileSystem : public IHandleAllocator, public IFileSystem {
 
 	std::string startingDirectory;
 	std::recursive_mutex lock;  // must be recursive
+	// Reserved reads run without the lock.  Filesystems are only deleted once none are in progress.
+	int unlockedReads_ = 0;
+	std::condition_variable_any unlockedReadsDone_;
 
 public:
 	MetaFileSystem() {
@@ -117,6 +121,9 @@ class MetaFileSystem : public IHandleAllocator, public IFileSystem {
 	int  DevType(u32 handle) override;
 	int  Flags() override { return 0; }
 	u64  FreeSpace(const std::string &path) override;
+	bool ReserveRead(u32 handle, s64 size, ReservedRead &read) override;
+	// Runs without the lock, so reserved reads can overlap.
+	void ReadReserved(u32 handle, const ReservedRead &read, u8 *pointer) override;
 
 	// Convenience helper - returns < 0 on failure.
 	int ReadEntireFile(const std::string &filename, std::vector<u8> &data);
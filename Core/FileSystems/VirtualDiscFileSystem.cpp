@@ -152,6 +152,7 @@ void VirtualDiscFileSystem::LoadFileListIndex() {
 			currentBlockIndex = nextBlock;
 		}
 
+		fileListIndex_.emplace(entry.fileName, (int)fileList.size());
 		fileList.push_back(entry);
 	}
 
@@ -183,6 +184,10 @@ void VirtualDiscFileSystem::DoState(PointerWrap &p)
 
 	if (p.mode == p.MODE_READ)
 	{
+		fileListIndex_.clear();
+		for (int i = 0; i < fileListSize; i++)
+			fileListIndex_.emplace(fileList[i].fileName, i);
+
 		entries.clear();
 
 		for (int i = 0; i < entryCount; i++)
@@ -265,11 +270,9 @@ int VirtualDiscFileSystem::getFileListIndex(std::string &fileName)
 		normalized = fileName;
 	}
 
-	for (size_t i = 0; i < fileList.size(); i++)
-	{
-		if (fileList[i].fileName == normalized)
-			return (int)i;
-	}
+	auto found = fileListIndex_.find(normalized);
+	if (found != fileListIndex_.end())
+		return found->second;
 
 	// unknown file - add it
 	std::string fullName = GetLocalPath(fileName);
@@ -296,6 +299,7 @@ int VirtualDiscFileSystem::getFileListIndex(std::string &fileName)
 	entry.firstBlock = currentBlockIndex;
 	currentBlockIndex += (entry.totalSize+2047)/2048;
 
+	fileListIndex_.emplace(entry.fileName, (int)fileList.size());
 	fileList.push_back(entry);
 
 	return (int)fileList.size()-1;
@@ -20,6 +20,7 @@
 // TODO: Remove the Windows-specific code, FILE is fine there too.
 
 #include <map>
+#include <unordered_map>
 
 #include "Core/FileSystems/FileSystem.h"
 #include "Core/FileSystems/DirectoryFileSystem.h"
@@ -180,6 +181,8 @@ class VirtualDiscFileSystem: public IFileSystem {
 	};
 
 	std::vector<FileListEntry> fileList;
+	// Index into fileList by fileName, so opens don't scan the whole list.
+	std::unordered_map<std::string, int> fileListIndex_;
 	u32 currentBlockIndex;
 	u32 lastReadBlock_;
 
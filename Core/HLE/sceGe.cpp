@@ -509,10 +509,10 @@ u32 sceGeRestoreContext(u32 ctxAddr) {
 	}
 
 	if (Memory::IsValidAddress(ctxAddr)) {
-		gstate.Restore((u32_le *)Memory::GetPointer(ctxAddr));
+		gpu->RestoreContext((u32_le *)Memory::GetPointer(ctxAddr));
+	} else {
+		gpu->ReapplyGfxState();
 	}
-
-	gpu->ReapplyGfxState();
 	return 0;
 }
 
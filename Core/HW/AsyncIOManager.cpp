@@ -18,6 +18,7 @@
 #include <condition_variable>
 #include <mutex>
 
+#include "thread/threadutil.h"
 #include "Common/ChunkFile.h"
 #include "Core/MIPS/MIPS.h"
 #include "Core/Reporting.h"
@@ -25,6 +26,13 @@
 #include "Core/HW/AsyncIOManager.h"
 #include "Core/FileSystems/MetaFileSystem.h"
 
+// Reads are mostly waiting on the disk, so this doesn't need to track the core count.
+static const int IO_WORKER_COUNT = 4;
+
+AsyncIOManager::~AsyncIOManager() {
+	StopWorkers();
+}
+
 bool AsyncIOManager::HasOperation(u32 handle) {
 	if (resultsPending_.find(handle) != resultsPending_.end()) {
 		return true;
@@ -42,10 +50,27 @@ void AsyncIOManager::ScheduleOperation(AsyncIOEvent ev) {
 			ERROR_LOG_REPORT(SCEIO, "Scheduling operation for file %d while one is pending (type %d)", ev.handle, ev.type);
 		}
 	}
+	ev.startTicks = CoreTiming::GetTicks();
+	if (ev.type == IO_EVENT_READ) {
+		// Settle the result and timing now, in order, so they don't depend on which worker gets there first.
+		ev.reserved = pspFileSystem.ReserveRead(ev.handle, ev.bytes, ev.reservation);
+	}
 	ScheduleEvent(ev);
 }
 
+void AsyncIOManager::SyncThread(bool force) {
+	IOThreadEventQueue::SyncThread(force);
+
+	// The IO thread may have handed operations to the workers that are still running.
+	std::unique_lock<std::mutex> guard(workLock_);
+	while (!work_.empty() || workRunning_ > 0) {
+		workDone_.wait(guard);
+	}
+}
+
 void AsyncIOManager::Shutdown() {
+	StopWorkers();
+
 	std::lock_guard<std::mutex> guard(resultsLock_);
 	resultsPending_.clear();
 	results_.clear();
@@ -83,7 +108,7 @@ bool AsyncIOManager::ReadResult(u32 handle, AsyncIOResult &result) {
 bool AsyncIOManager::WaitResult(u32 handle, AsyncIOResult &result) {
 	std::unique_lock<std::mutex> guard(resultsLock_);
 	ScheduleEvent(IO_EVENT_SYNC);
-	while (HasEvents() && ThreadEnabled() && resultsPending_.find(handle) != resultsPending_.end()) {
+	while ((HasEvents() || WorkersBusy()) && ThreadEnabled() && resultsPending_.find(handle) != resultsPending_.end()) {
 		if (PopResult(handle, result)) {
 			return true;
 		}
@@ -97,7 +122,7 @@ u64 AsyncIOManager::ResultFinishTicks(u32 handle) {
 
 	std::unique_lock<std::mutex> guard(resultsLock_);
 	ScheduleEvent(IO_EVENT_SYNC);
-	while (HasEvents() && ThreadEnabled() && resultsPending_.find(handle) != resultsPending_.end()) {
+	while ((HasEvents() || WorkersBusy()) && ThreadEnabled() && resultsPending_.find(handle) != resultsPending_.end()) {
 		if (ReadResult(handle, result)) {
 			return result.finishTicks;
 		}
@@ -111,13 +136,34 @@ u64 AsyncIOManager::ResultFinishTicks(u32 handle) {
 }
 
 void AsyncIOManager::ProcessEvent(AsyncIOEvent ev) {
+	if (!ThreadEnabled() || !ev.reserved) {
+		// Unreserved operations must stay in order, so they run right here.
+		RunOperation(ev);
+		return;
+	}
+
+	std::lock_guard<std::mutex> guard(workLock_);
+	if (workers_.empty()) {
+		for (int i = 0; i < IO_WORKER_COUNT; ++i) {
+			workers_.push_back(std::thread([this] { WorkerThread(); }));
+		}
+	}
+	work_.push_back(ev);
+	workWait_.notify_one();
+}
+
+void AsyncIOManager::RunOperation(const AsyncIOEvent &ev) {
 	switch (ev.type) {
 	case IO_EVENT_READ:
-		Read(ev.handle, ev.buf, ev.bytes, ev.invalidateAddr);
+		if (ev.reserved) {
+			ReadReserved(ev);
+		} else {
+			Read(ev.handle, ev.buf, ev.bytes, ev.invalidateAddr, ev.startTicks);
+		}
 		break;
 
 	case IO_EVENT_WRITE:
-		Write(ev.handle, ev.buf, ev.bytes);
+		Write(ev.handle, ev.buf, ev.bytes, ev.startTicks);
 		break;
 
 	default:
@@ -125,16 +171,65 @@ void AsyncIOManager::ProcessEvent(AsyncIOEvent ev) {
 	}
 }
 
-void AsyncIOManager::Read(u32 handle, u8 *buf, size_t bytes, u32 invalidateAddr) {
+bool AsyncIOManager::WorkersBusy() {
+	std::lock_guard<std::mutex> guard(workLock_);
+	return !work_.empty() || workRunning_ > 0;
+}
+
+void AsyncIOManager::StopWorkers() {
+	std::unique_lock<std::mutex> guard(workLock_);
+	workersExiting_ = true;
+	workWait_.notify_all();
+	guard.unlock();
+
+	for (std::thread &worker : workers_) {
+		worker.join();
+	}
+
+	guard.lock();
+	workers_.clear();
+	work_.clear();
+	workersExiting_ = false;
+}
+
+void AsyncIOManager::WorkerThread() {
+	setCurrentThreadName("IOWorker");
+
+	std::unique_lock<std::mutex> guard(workLock_);
+	while (!workersExiting_) {
+		if (work_.empty()) {
+			workWait_.wait(guard);
+			continue;
+		}
+
+		AsyncIOEvent ev = work_.front();
+		work_.pop_front();
+		workRunning_++;
+		guard.unlock();
+
+		RunOperation(ev);
+
+		guard.lock();
+		workRunning_--;
+		workDone_.notify_all();
+	}
+}
+
+void AsyncIOManager::Read(u32 handle, u8 *buf, size_t bytes, u32 invalidateAddr, u64 startTicks) {
 	int usec = 0;
 	s64 result = pspFileSystem.ReadFile(handle, buf, bytes, usec);
-	EventResult(handle, AsyncIOResult(result, usec, invalidateAddr));
+	EventResult(handle, AsyncIOResult(result, startTicks, usec, invalidateAddr));
+}
+
+void AsyncIOManager::ReadReserved(const AsyncIOEvent &ev) {
+	pspFileSystem.ReadReserved(ev.handle, ev.reservation, ev.buf);
+	EventResult(ev.handle, AsyncIOResult(ev.reservation.result, ev.startTicks, ev.reservation.usec, ev.invalidateAddr));
 }
 
-void AsyncIOManager::Write(u32 handle, u8 *buf, size_t bytes) {
+void AsyncIOManager::Write(u32 handle, u8 *buf, size_t bytes, u64 startTicks) {
 	int usec = 0;
 	s64 result = pspFileSystem.WriteFile(handle, buf, bytes, usec);
-	EventResult(handle, AsyncIOResult(result, usec));
+	EventResult(handle, AsyncIOResult(result, startTicks, usec));
 }
 
 void AsyncIOManager::EventResult(u32 handle, AsyncIOResult result) {
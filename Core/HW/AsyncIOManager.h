@@ -15,11 +15,16 @@
 // Official git repository and contact information can be found at
 // https://github.com/hrydgard/ppsspp and http://www.ppsspp.org/.
 
+#include <condition_variable>
+#include <deque>
 #include <map>
 #include <set>
 #include <mutex>
+#include <thread>
+#include <vector>
 
 #include "Core/ThreadEventQueue.h"
+#include "Core/FileSystems/FileSystem.h"
 
 class NoBase {
 };
@@ -33,12 +38,17 @@ enum AsyncIOEventType {
 };
 
 struct AsyncIOEvent {
-	AsyncIOEvent(AsyncIOEventType t) : type(t) {}
+	AsyncIOEvent(AsyncIOEventType t) : type(t), startTicks(0), reserved(false) {}
 	AsyncIOEventType type;
 	u32 handle;
 	u8 *buf;
 	size_t bytes;
 	u32 invalidateAddr;
+	// Emulated time when it was scheduled, which the finish time is based on.
+	u64 startTicks;
+	// Reads are reserved when scheduled, if the filesystem supports it, see IFileSystem::ReserveRead().
+	bool reserved;
+	ReservedRead reservation;
 
 	operator AsyncIOEventType() const {
 		return type;
@@ -52,8 +62,8 @@ struct AsyncIOResult {
 	explicit AsyncIOResult(s64 r) : result(r), finishTicks(0), invalidateAddr(0) {
 	}
 
-	AsyncIOResult(s64 r, int usec, u32 addr = 0) : result(r), invalidateAddr(addr) {
-		finishTicks = CoreTiming::GetTicks() + usToCycles(usec);
+	AsyncIOResult(s64 r, u64 startTicks, int usec, u32 addr = 0) : result(r), invalidateAddr(addr) {
+		finishTicks = startTicks + usToCycles(usec);
 	}
 
 	void DoState(PointerWrap &p) {
@@ -76,9 +86,21 @@ struct AsyncIOResult {
 };
 
 typedef ThreadEventQueue<NoBase, AsyncIOEvent, AsyncIOEventType, IO_EVENT_INVALID, IO_EVENT_SYNC, IO_EVENT_FINISH> IOThreadEventQueue;
+
+// Reads are reserved when they're scheduled, on the emu thread, which settles their result and
+// timing in order.  The IO thread then hands the actual reading to a small set of workers, so
+// reads of different files (say music, voice and video streams) overlap on the host.  Anything
+// else still runs in order on the IO thread.  There's only ever one operation per file handle.
+//
+// Finish times are based on the emulated time each operation was scheduled, not on when the
+// host got to it, so they don't depend on host timing.
 class AsyncIOManager : public IOThreadEventQueue {
 public:
+	~AsyncIOManager();
+
 	void DoState(PointerWrap &p);
+	// Also waits for operations already handed to the workers.
+	void SyncThread(bool force = false);
 
 	bool HasOperation(u32 handle);
 	void ScheduleOperation(AsyncIOEvent ev);
@@ -97,13 +119,27 @@ class AsyncIOManager : public IOThreadEventQueue {
 private:
 	bool PopResult(u32 handle, AsyncIOResult &result);
 	bool ReadResult(u32 handle, AsyncIOResult &result);
-	void Read(u32 handle, u8 *buf, size_t bytes, u32 invalidateAddr);
-	void Write(u32 handle, u8 *buf, size_t bytes);
+	void Read(u32 handle, u8 *buf, size_t bytes, u32 invalidateAddr, u64 startTicks);
+	void ReadReserved(const AsyncIOEvent &ev);
+	void Write(u32 handle, u8 *buf, size_t bytes, u64 startTicks);
 
 	void EventResult(u32 handle, AsyncIOResult result);
 
+	void RunOperation(const AsyncIOEvent &ev);
+	bool WorkersBusy();
+	void StopWorkers();
+	void WorkerThread();
+
 	std::mutex resultsLock_;
 	std::condition_variable resultsWait_;
 	std::set<u32> resultsPending_;
 	std::map<u32, AsyncIOResult> results_;
+
+	std::vector<std::thread> workers_;
+	std::mutex workLock_;
+	std::condition_variable workWait_;
+	std::condition_variable workDone_;
+	std::deque<AsyncIOEvent> work_;
+	int workRunning_ = 0;
+	bool workersExiting_ = false;
 };
\ No newline at end of file
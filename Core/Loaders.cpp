@@ -83,7 +83,7 @@ IdentifiedFileType Identify_File(FileLoader *fileLoader) {
 			// maybe it also just happened to have that size, 
 		}
 		return IdentifiedFileType::PSP_ISO;
-	} else if (!strcasecmp(extension.c_str(), ".cso")) {
+	} else if (!strcasecmp(extension.c_str(), ".cso") || !strcasecmp(extension.c_str(), ".szo")) {
 		return IdentifiedFileType::PSP_ISO;
 	} else if (!strcasecmp(extension.c_str(), ".ppst")) {
 		return IdentifiedFileType::PPSSPP_SAVESTATE;
@@ -89,6 +89,15 @@ class FileLoader {
 		return ReadAt(absolutePos, 1, bytes, data, flags);
 	}
 
+	// Returns a pointer straight to the data when the file is memory mapped, otherwise nullptr.
+	// It stays valid as long as the loader does.
+	virtual const u8 *MappedData(s64 absolutePos, size_t bytes) {
+		return nullptr;
+	}
+	// Hints that this range is likely to be read soon.
+	virtual void Prefetch(s64 absolutePos, s64 bytes) {
+	}
+
 	// Cancel any operations that might block, if possible.
 	virtual void Cancel() {
 	}
@@ -125,6 +134,12 @@ class ProxiedFileLoader : public FileLoader {
 	std::string Path() const override {
 		return backend_->Path();
 	}
+	const u8 *MappedData(s64 absolutePos, size_t bytes) override {
+		return backend_->MappedData(absolutePos, bytes);
+	}
+	void Prefetch(s64 absolutePos, s64 bytes) override {
+		backend_->Prefetch(absolutePos, bytes);
+	}
 	void Cancel() override {
 		backend_->Cancel();
 	}
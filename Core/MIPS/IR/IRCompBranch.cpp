@@ -15,6 +15,8 @@
 // Official git repository and contact information can be found at
 // https://github.com/hrydgard/ppsspp and http://www.ppsspp.org/.
 
+#include <algorithm>
+
 #include "profiler/profiler.h"
 
 #include "Core/Reporting.h"
@@ -102,6 +104,10 @@ void IRFrontend::BranchRSRTComp(MIPSOpcode op, IRComparison cc, bool likely) {
 		CompileDelaySlot();
 
 	FlushAll();
+	if (CanContinueTo(targetAddr)) {
+		ContinueAt(targetAddr);
+		return;
+	}
 	ir.Write(IROp::ExitToConst, ir.AddConstant(targetAddr));
 
 	// Account for the delay slot.
@@ -142,6 +148,11 @@ void IRFrontend::BranchRSZeroComp(MIPSOpcode op, IRComparison cc, bool andLink,
 		CompileDelaySlot();
 	// Taken
 	FlushAll();
+	// With link, ra points back into the block, so it's not worth it.
+	if (!andLink && CanContinueTo(targetAddr)) {
+		ContinueAt(targetAddr);
+		return;
+	}
 	ir.Write(IROp::ExitToConst, ir.AddConstant(targetAddr));
 
 	// Account for the delay slot.
@@ -210,6 +221,10 @@ void IRFrontend::BranchFPFlag(MIPSOpcode op, IRComparison cc, bool likely) {
 	if (likely)
 		CompileDelaySlot();
 	FlushAll();
+	if (CanContinueTo(targetAddr)) {
+		ContinueAt(targetAddr);
+		return;
+	}
 	ir.Write(IROp::ExitToConst, ir.AddConstant(targetAddr));
 
 	// Account for the delay slot.
@@ -268,6 +283,11 @@ void IRFrontend::BranchVFPUFlag(MIPSOpcode op, IRComparison cc, bool likely) {
 
 	// Taken
 	FlushAll();
+	// The second branch in the delay slot still needs to run, so exit normally there.
+	if (!delaySlotIsBranch && CanContinueTo(targetAddr)) {
+		ContinueAt(targetAddr);
+		return;
+	}
 	ir.Write(IROp::ExitToConst, ir.AddConstant(targetAddr));
 
 	// Account for the delay slot.
@@ -308,11 +328,23 @@ void IRFrontend::Comp_Jump(MIPSOpcode op) {
 	switch (op >> 26) {
 	case 2: //j
 		CompileDelaySlot();
+		if (CanContinueTo(targetAddr)) {
+			ContinueAt(targetAddr);
+			return;
+		}
 		break;
 
 	case 3: //jal
 		ir.WriteSetConstant(MIPS_REG_RA, GetCompilerPC() + 8);
 		CompileDelaySlot();
+		if (CanInlineCall(targetAddr)) {
+			// Compile the callee right here, Comp_JumpReg() brings us back at its jr ra.
+			traceEnd_ = std::max(traceEnd_, GetCompilerPC() + 8);
+			inlineReturnAddr_ = GetCompilerPC() + 8;
+			inlineStart_ = targetAddr;
+			js.compilerPC = targetAddr - 4;
+			return;
+		}
 		break;
 
 	default:
@@ -346,6 +378,15 @@ void IRFrontend::Comp_JumpReg(MIPSOpcode op) {
 	if (andLink && rs == rd)
 		delaySlotIsNice = false;
 
+	if (inlineReturnAddr_ != 0 && rs == MIPS_REG_RA && (op & 0x3f) == 8) {
+		// Return from an inlined leaf.  It doesn't write ra, so this is always taken.
+		CompileDelaySlot();
+		inlinedRanges_.push_back(IRCodeRange{ inlineStart_, GetCompilerPC() + 8 - inlineStart_ });
+		js.compilerPC = inlineReturnAddr_ - 4;
+		inlineReturnAddr_ = 0;
+		return;
+	}
+
 	int destReg;
 	if (IsSyscall(delaySlotOp)) {
 		ir.Write(IROp::SetPC, 0, rs);
@@ -0,0 +1,228 @@
+// Copyright (c) 2012- PPSSPP Project.
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, version 2.0 or later versions.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License 2.0 for more details.
+
+// A copy of the GPL 2.0 should have been included with the program.
+// If not, see http://www.gnu.org/licenses/
+
+// Official git repository and contact information can be found at
+// https://github.com/hrydgard/ppsspp and http://www.ppsspp.org/.
+
+#include <cstring>
+
+#include "base/logging.h"
+#include "ext/xxhash.h"
+#include "Common/FileUtil.h"
+#include "Core/Config.h"
+#include "Core/MIPS/IR/IRDiskCache.h"
+#include "Core/MIPS/IR/IRJit.h"
+
+namespace MIPSComp {
+
+// The IROp numbering and the frontend output change between builds, so the cache is tied to
+// the exact version that wrote it, as well as to the options that affect the passes.
+
+#define IR_CACHE_HEADER_MAGIC 0x43524950
+#define IR_CACHE_VERSION 1
+
+// Games that overlay code can have a few versions of a block at the same address.
+static const size_t MAX_ENTRIES_PER_ADDRESS = 4;
+// Just a sanity limit, so a corrupt file can't make us allocate forever.
+static const u32 MAX_STORED_BLOCKS = 0x00400000;
+
+struct IRCacheHeader {
+	u32 magic;
+	u32 version;
+	u64 buildHash;
+	u32 disableFlags;
+	u32 numBlocks;
+	u32 numInstructions;
+	u32 reserved;
+};
+
+struct IRCacheBlockHeader {
+	u32 address;
+	u32 mipsBytes;
+	u32 frontendFlags;
+	u32 numInstructions;
+	u64 hash;
+};
+
+static_assert(sizeof(IRInst) == 8, "IRInst is written to disk as-is");
+
+static u64 BuildHash() {
+	return XXH64(PPSSPP_GIT_VERSION, strlen(PPSSPP_GIT_VERSION), 0);
+}
+
+bool IRDiskCache::Load(const std::string &filename, const IROptions &opts) {
+	Clear();
+
+	File::IOFile f(filename, "rb");
+	if (!f.IsOpen()) {
+		return false;
+	}
+	u64 sz = f.GetSize();
+	IRCacheHeader header;
+	if (!f.ReadArray(&header, 1)) {
+		return false;
+	}
+	if (header.magic != IR_CACHE_HEADER_MAGIC || header.version != IR_CACHE_VERSION || header.buildHash != BuildHash() || header.disableFlags != opts.disableFlags) {
+		INFO_LOG(JIT, "IR cache '%s' is from a different build or config, ignoring", filename.c_str());
+		return false;
+	}
+	if (header.numBlocks > MAX_STORED_BLOCKS || header.numInstructions > MAX_STORED_BLOCKS * 64) {
+		ERROR_LOG(JIT, "Corrupt IR cache file header, ignoring");
+		return false;
+	}
+
+	u64 expectedSize = sizeof(header);
+	expectedSize += (u64)header.numBlocks * sizeof(IRCacheBlockHeader);
+	expectedSize += (u64)header.numInstructions * sizeof(IRInst);
+	if (sz != expectedSize) {
+		ERROR_LOG(JIT, "IR cache file is wrong size: %lld instead of %lld", sz, expectedSize);
+		return false;
+	}
+
+	std::vector<IRCacheBlockHeader> blocks;
+	blocks.resize(header.numBlocks);
+	pool_.resize(header.numInstructions);
+	if (header.numBlocks != 0 && !f.ReadArray(&blocks[0], blocks.size())) {
+		Clear();
+		return false;
+	}
+	if (header.numInstructions != 0 && !f.ReadArray(&pool_[0], pool_.size())) {
+		Clear();
+		return false;
+	}
+
+	for (const IRInst &inst : pool_) {
+		if (!GetIRMeta(inst.op)) {
+			ERROR_LOG(JIT, "IR cache file contains unknown op %d, ignoring", (int)inst.op);
+			Clear();
+			return false;
+		}
+	}
+
+	u32 pos = 0;
+	for (const IRCacheBlockHeader &block : blocks) {
+		if (block.numInstructions == 0 || block.numInstructions > header.numInstructions - pos) {
+			ERROR_LOG(JIT, "IR cache file has bad block at %08x, ignoring", block.address);
+			Clear();
+			return false;
+		}
+
+		Entry entry{ block.mipsBytes, block.frontendFlags, block.hash, pos, block.numInstructions };
+		entries_[block.address].push_back(entry);
+		pos += block.numInstructions;
+	}
+
+	numEntries_ = blocks.size();
+	dirty_ = false;
+	INFO_LOG(JIT, "Loaded %d IR blocks from '%s'", (int)numEntries_, filename.c_str());
+	return true;
+}
+
+void IRDiskCache::Save(const std::string &filename, const IROptions &opts) {
+	if (!dirty_ || numEntries_ == 0) {
+		return;
+	}
+
+	INFO_LOG(JIT, "Saving %d IR blocks to '%s'", (int)numEntries_, filename.c_str());
+	FILE *f = File::OpenCFile(filename, "wb");
+	if (!f) {
+		// Can't save, give up for now.
+		dirty_ = false;
+		return;
+	}
+
+	// Replaced entries leave holes in the pool, so compact as we write.
+	std::vector<IRCacheBlockHeader> blocks;
+	blocks.reserve(numEntries_);
+	u32 numInstructions = 0;
+	for (const auto &iter : entries_) {
+		for (const Entry &entry : iter.second) {
+			IRCacheBlockHeader block{ iter.first, entry.mipsBytes, entry.frontendFlags, entry.numInstructions, entry.hash };
+			blocks.push_back(block);
+			numInstructions += entry.numInstructions;
+		}
+	}
+
+	IRCacheHeader header;
+	header.magic = IR_CACHE_HEADER_MAGIC;
+	header.version = IR_CACHE_VERSION;
+	header.buildHash = BuildHash();
+	header.disableFlags = opts.disableFlags;
+	header.numBlocks = (u32)blocks.size();
+	header.numInstructions = numInstructions;
+	header.reserved = 0;
+	fwrite(&header, 1, sizeof(header), f);
+	fwrite(&blocks[0], sizeof(IRCacheBlockHeader), blocks.size(), f);
+	for (const auto &iter : entries_) {
+		for (const Entry &entry : iter.second) {
+			fwrite(&pool_[entry.firstInst], sizeof(IRInst), entry.numInstructions, f);
+		}
+	}
+	fclose(f);
+	dirty_ = false;
+}
+
+void IRDiskCache::Clear() {
+	entries_.clear();
+	pool_.clear();
+	numEntries_ = 0;
+	dirty_ = false;
+}
+
+bool IRDiskCache::Lookup(u32 em_address, u32 frontendFlags, std::vector<IRInst> &instructions, u32 &mipsBytes) const {
+	auto iter = entries_.find(em_address);
+	if (iter == entries_.end())
+		return false;
+
+	// Newest first, it's the most likely to match if the game has overlays.
+	const std::vector<Entry> &candidates = iter->second;
+	for (auto it = candidates.rbegin(); it != candidates.rend(); ++it) {
+		const Entry &entry = *it;
+		if (entry.frontendFlags != frontendFlags)
+			continue;
+		if (IRBlock::CalculateHash(em_address, entry.mipsBytes) != entry.hash)
+			continue;
+
+		instructions.assign(pool_.begin() + entry.firstInst, pool_.begin() + entry.firstInst + entry.numInstructions);
+		mipsBytes = entry.mipsBytes;
+		return true;
+	}
+
+	return false;
+}
+
+void IRDiskCache::Add(u32 em_address, u32 frontendFlags, u32 mipsBytes, u64 hash, const std::vector<IRInst> &instructions) {
+	if (instructions.empty() || numEntries_ >= MAX_STORED_BLOCKS)
+		return;
+
+	std::vector<Entry> &candidates = entries_[em_address];
+	for (size_t i = 0; i < candidates.size(); ++i) {
+		if (candidates[i].hash == hash && candidates[i].mipsBytes == mipsBytes && candidates[i].frontendFlags == frontendFlags) {
+			// Already have it, this happens after an icache invalidation or a state load.
+			return;
+		}
+	}
+	if (candidates.size() >= MAX_ENTRIES_PER_ADDRESS) {
+		candidates.erase(candidates.begin());
+		numEntries_--;
+	}
+
+	Entry entry{ mipsBytes, frontendFlags, hash, (u32)pool_.size(), (u32)instructions.size() };
+	pool_.insert(pool_.end(), instructions.begin(), instructions.end());
+	candidates.push_back(entry);
+	numEntries_++;
+	dirty_ = true;
+}
+
+}  // namespace MIPSComp
@@ -0,0 +1,62 @@
+// Copyright (c) 2012- PPSSPP Project.
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, version 2.0 or later versions.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License 2.0 for more details.
+
+// A copy of the GPL 2.0 should have been included with the program.
+// If not, see http://www.gnu.org/licenses/
+
+// Official git repository and contact information can be found at
+// https://github.com/hrydgard/ppsspp and http://www.ppsspp.org/.
+
+#pragma once
+
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "Common/CommonTypes.h"
+#include "Core/MIPS/IR/IRInst.h"
+
+namespace MIPSComp {
+
+// Per-game store of optimized IR, so blocks seen in earlier sessions can skip the frontend.
+// Entries are keyed by address and validated against a hash of the MIPS code before use.
+// IR is stored rather than native code, since the native backends are cheap to run and
+// their output depends on where the code space was allocated.
+class IRDiskCache {
+public:
+	bool Load(const std::string &filename, const IROptions &opts);
+	void Save(const std::string &filename, const IROptions &opts);
+	void Clear();
+
+	// Returns true if IR compiled from identical code under the same frontend state is stored.
+	bool Lookup(u32 em_address, u32 frontendFlags, std::vector<IRInst> &instructions, u32 &mipsBytes) const;
+	void Add(u32 em_address, u32 frontendFlags, u32 mipsBytes, u64 hash, const std::vector<IRInst> &instructions);
+
+	size_t GetNumBlocks() const {
+		return numEntries_;
+	}
+
+private:
+	struct Entry {
+		u32 mipsBytes;
+		u32 frontendFlags;
+		u64 hash;
+		u32 firstInst;
+		u32 numInstructions;
+	};
+
+	std::unordered_map<u32, std::vector<Entry>> entries_;
+	std::vector<IRInst> pool_;
+	size_t numEntries_ = 0;
+	bool dirty_ = false;
+};
+
+}  // namespace MIPSComp
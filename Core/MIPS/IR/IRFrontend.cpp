@@ -15,6 +15,8 @@
 // Official git repository and contact information can be found at
 // https://github.com/hrydgard/ppsspp and http://www.ppsspp.org/.
 
+#include <algorithm>
+
 #include "base/logging.h"
 
 #include "Common/ChunkFile.h"
@@ -23,6 +25,7 @@
 #include "Core/Reporting.h"
 #include "Core/HLE/ReplaceTables.h"
 #include "Core/MemMap.h"
+#include "Core/MIPS/MIPSAnalyst.h"
 #include "Core/MIPS/MIPSTables.h"
 #include "Core/MIPS/IR/IRFrontend.h"
 #include "Core/MIPS/IR/IRRegCache.h"
@@ -217,11 +220,65 @@ u32 IRFrontend::GetCompilerPC() {
 	return js.compilerPC;
 }
 
+u32 IRFrontend::GetCompileFlags() const {
+	u32 flags = 0;
+	if (js.hasSetRounding)
+		flags |= 1;
+	if (js.startDefaultPrefix)
+		flags |= 2;
+	return flags;
+}
+
+// Superblocks only follow branches forward, so the block still covers one contiguous range.
+static const u32 IR_SUPERBLOCK_MAX_SPAN = 0x1000;
+static const int IR_SUPERBLOCK_MAX_INSTRUCTIONS = 256;
+static const int IR_INLINE_MAX_INSTRUCTIONS = 16;
+
+bool IRFrontend::CanContinueTo(u32 targetAddr) {
+	if ((opts.disableFlags & (uint32_t)JitDisable::SUPERBLOCKS) != 0 || inlineReturnAddr_ != 0)
+		return false;
+	if (js.numInstructions >= IR_SUPERBLOCK_MAX_INSTRUCTIONS)
+		return false;
+	// Any branch past its delay slot and within the span is followed, likely or not.
+	// The not-taken path gets a side exit.  Backward branches would break the range.
+	if (targetAddr < GetCompilerPC() + 8 || targetAddr - js.blockStart >= IR_SUPERBLOCK_MAX_SPAN)
+		return false;
+	return Memory::IsValidAddress(targetAddr);
+}
+
+void IRFrontend::ContinueAt(u32 targetAddr) {
+	// The not-taken path already has its side exit, and everything was flushed for it.
+	traceEnd_ = std::max(traceEnd_, GetCompilerPC() + 8);
+	// The loop in DoJit() adds 4.
+	js.compilerPC = targetAddr - 4;
+}
+
+bool IRFrontend::CanInlineCall(u32 targetAddr) {
+	if ((opts.disableFlags & (uint32_t)JitDisable::SUPERBLOCKS) != 0 || inlineReturnAddr_ != 0)
+		return false;
+	if (js.numInstructions + IR_INLINE_MAX_INSTRUCTIONS >= IR_SUPERBLOCK_MAX_INSTRUCTIONS)
+		return false;
+	return MIPSAnalyst::GetStraightLeafSize(targetAddr, IR_INLINE_MAX_INSTRUCTIONS) != 0;
+}
+
 MIPSOpcode IRFrontend::GetOffsetInstruction(int offset) {
 	return Memory::Read_Instruction(GetCompilerPC() + 4 * offset);
 }
 
-void IRFrontend::DoJit(u32 em_address, std::vector<IRInst> &instructions, u32 &mipsBytes, bool preload) {
+bool IRFrontend::OptimizeIR(const IRWriter &in, IRWriter &out, const IROptions &opts) {
+	static const IRPassFunc passes[] = {
+		&RemoveLoadStoreLeftRight,
+		&OptimizeFPMoves,
+		&PropagateConstants,
+		&PurgeTemps,
+		// &ReorderLoadStore,
+		// &MergeLoadStore,
+		// &ThreeOpToTwoOp,
+	};
+	return IRApplyPasses(passes, ARRAY_SIZE(passes), in, out, opts);
+}
+
+void IRFrontend::DoJit(u32 em_address, std::vector<IRInst> &instructions, u32 &mipsBytes, bool preload, bool optimize) {
 	js.cancel = false;
 	js.preloading = preload;
 	js.blockStart = em_address;
@@ -236,6 +293,10 @@ void IRFrontend::DoJit(u32 em_address, std::vector<IRInst> &instructions, u32 &m
 	js.inDelaySlot = false;
 	js.PrefixStart();
 	ir.Clear();
+	traceEnd_ = em_address;
+	inlineReturnAddr_ = 0;
+	inlineStart_ = 0;
+	inlinedRanges_.clear();
 
 	js.numInstructions = 0;
 	while (js.compiling) {
@@ -254,21 +315,19 @@ void IRFrontend::DoJit(u32 em_address, std::vector<IRInst> &instructions, u32 &m
 		ir.Clear();
 	}
 
-	mipsBytes = js.compilerPC - em_address;
+	if (inlineReturnAddr_ != 0) {
+		// Ended inside an inlined call, so the rest of the caller wasn't compiled.
+		inlinedRanges_.push_back(IRCodeRange{ inlineStart_, js.compilerPC - inlineStart_ });
+		inlineReturnAddr_ = 0;
+	} else {
+		traceEnd_ = std::max(traceEnd_, js.compilerPC);
+	}
+	mipsBytes = traceEnd_ - em_address;
 
 	IRWriter simplified;
 	IRWriter *code = &ir;
-	if (!js.hadBreakpoints) {
-		static const IRPassFunc passes[] = {
-			&RemoveLoadStoreLeftRight,
-			&OptimizeFPMoves,
-			&PropagateConstants,
-			&PurgeTemps,
-			// &ReorderLoadStore,
-			// &MergeLoadStore,
-			// &ThreeOpToTwoOp,
-		};
-		if (IRApplyPasses(passes, ARRAY_SIZE(passes), ir, simplified, opts))
+	if (!js.hadBreakpoints && optimize) {
+		if (OptimizeIR(ir, simplified, opts))
 			logBlocks = 1;
 		code = &simplified;
 		//if (ir.GetInstructions().size() >= 24)
@@ -280,7 +339,7 @@ void IRFrontend::DoJit(u32 em_address, std::vector<IRInst> &instructions, u32 &m
 	if (logBlocks > 0 && dontLogBlocks == 0) {
 		char temp2[256];
 		NOTICE_LOG(JIT, "=============== mips %08x ===============", em_address);
-		for (u32 cpc = em_address; cpc != GetCompilerPC(); cpc += 4) {
+		for (u32 cpc = em_address; cpc != em_address + mipsBytes; cpc += 4) {
 			temp2[0] = 0;
 			MIPSDisAsm(Memory::Read_Opcode_JIT(cpc), cpc, temp2, true);
 			NOTICE_LOG(JIT, "M: %08x   %s", cpc, temp2);
@@ -1,5 +1,7 @@
 #pragma once
 
+#include <vector>
+
 #include "Common/CommonTypes.h"
 #include "Core/MIPS/JitCommon/JitCommon.h"
 #include "Core/MIPS/JitCommon/JitState.h"
@@ -8,6 +10,11 @@
 
 namespace MIPSComp {
 
+struct IRCodeRange {
+	u32 start;
+	u32 size;
+};
+
 class IRFrontend : public MIPSFrontendInterface {
 public:
 	IRFrontend(bool startDefaultPrefix);
@@ -88,7 +95,10 @@ class IRFrontend : public MIPSFrontendInterface {
 	void DoState(PointerWrap &p);
 	bool CheckRounding(u32 blockAddress);  // returns true if we need a do-over
 
-	void DoJit(u32 em_address, std::vector<IRInst> &instructions, u32 &mipsBytes, bool preload);
+	// Without optimize, the raw IR is returned, which is cheaper to produce but slower to run.
+	void DoJit(u32 em_address, std::vector<IRInst> &instructions, u32 &mipsBytes, bool preload, bool optimize);
+	// Runs the same passes as DoJit().  Doesn't touch any frontend state, so it's safe from other threads.
+	static bool OptimizeIR(const IRWriter &in, IRWriter &out, const IROptions &opts);
 
 	void EatPrefix() override {
 		js.EatPrefix();
@@ -97,6 +107,16 @@ class IRFrontend : public MIPSFrontendInterface {
 	void SetOptions(const IROptions &o) {
 		opts = o;
 	}
+	const IROptions &GetOptions() const {
+		return opts;
+	}
+
+	// Compile-time assumptions that change the IR we generate, see CheckRounding().
+	u32 GetCompileFlags() const;
+	// Leaf functions the last DoJit() compiled inline.  These are outside its mipsBytes range.
+	const std::vector<IRCodeRange> &GetInlinedRanges() const {
+		return inlinedRanges_;
+	}
 
 private:
 	void RestoreRoundingMode(bool force = false);
@@ -114,6 +134,11 @@ class IRFrontend : public MIPSFrontendInterface {
 	void CheckBreakpoint(u32 addr);
 	void CheckMemoryBreakpoint(int rs, int offset);
 
+	// Superblocks: instead of exiting at a branch, keep compiling at its target.
+	bool CanContinueTo(u32 targetAddr);
+	void ContinueAt(u32 targetAddr);
+	bool CanInlineCall(u32 targetAddr);
+
 	// Utility compilation functions
 	void BranchFPFlag(MIPSOpcode op, IRComparison cc, bool likely);
 	void BranchVFPUFlag(MIPSOpcode op, IRComparison cc, bool likely);
@@ -139,6 +164,13 @@ class IRFrontend : public MIPSFrontendInterface {
 
 	int dontLogBlocks = 0;
 	int logBlocks = 0;
+
+	// End of the contiguous code covered by the block, which continuing can skip parts of.
+	u32 traceEnd_ = 0;
+	// Set while compiling the body of an inlined leaf call.
+	u32 inlineReturnAddr_ = 0;
+	u32 inlineStart_ = 0;
+	std::vector<IRCodeRange> inlinedRanges_;
 };
 
 }  // namespace
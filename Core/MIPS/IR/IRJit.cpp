@@ -15,14 +15,20 @@
 // Official git repository and contact information can be found at
 // https://github.com/hrydgard/ppsspp and http://www.ppsspp.org/.
 
+#include <algorithm>
+
 #include "base/logging.h"
 #include "ext/xxhash.h"
 #include "profiler/profiler.h"
 #include "Common/ChunkFile.h"
+#include "Common/FileUtil.h"
 #include "Common/StringUtils.h"
 
 #include "Core/Core.h"
+#include "Core/CoreParameter.h"
 #include "Core/CoreTiming.h"
+#include "Core/Debugger/Breakpoints.h"
+#include "Core/ELF/ParamSFO.h"
 #include "Core/HLE/sceKernelMemory.h"
 #include "Core/MemMap.h"
 #include "Core/MIPS/MIPS.h"
@@ -33,11 +39,37 @@
 #include "Core/MIPS/IR/IRJit.h"
 #include "Core/MIPS/IR/IRPassSimplify.h"
 #include "Core/MIPS/IR/IRInterpreter.h"
+#include "Core/MIPS/IR/IRThreadedInterpreter.h"
 #include "Core/MIPS/JitCommon/JitCommon.h"
 #include "Core/Reporting.h"
+#include "Core/System.h"
+
+#if PPSSPP_ARCH(AMD64)
+#include "Core/MIPS/x86/IRToX86.h"
+#endif
 
 namespace MIPSComp {
 
+// With tiered compilation, blocks run unoptimized until they've been entered this many times.
+static const u32 IR_OPTIMIZE_THRESHOLD = 32;
+
+// Blocks with these depend on breakpoints at compile time, so we don't optimize or store them.
+static bool HasDebugOps(const std::vector<IRInst> &instructions) {
+	for (const IRInst &inst : instructions) {
+		if (inst.op == IROp::Breakpoint || inst.op == IROp::MemoryCheck)
+			return true;
+	}
+	return false;
+}
+
+static IRToNativeInterface *CreateIRToNative(MIPSState *mips) {
+#if PPSSPP_ARCH(AMD64)
+	return new IRToX86(mips);
+#else
+	return nullptr;
+#endif
+}
+
 IRJit::IRJit(MIPSState *mips) : frontend_(mips->HasDefaultPrefix()), mips_(mips) {
 	u32 size = 128 * 1024;
 	// blTrampolines_ = kernelMemory.Alloc(size, true, "trampoline");
@@ -47,9 +79,36 @@ IRJit::IRJit(MIPSState *mips) : frontend_(mips->HasDefaultPrefix()), mips_(mips)
 	opts.disableFlags = g_Config.uJitDisableFlags;
 	opts.unalignedLoadStore = opts.disableFlags & (uint32_t)JitDisable::LSU_UNALIGNED;
 	frontend_.SetOptions(opts);
+
+	if (PSP_CoreParameter().irBackend == IRBackend::NATIVE) {
+		native_ = CreateIRToNative(mips);
+		if (!native_) {
+			WARN_LOG(JIT, "IRJit: No native backend for this platform, using the interpreter");
+		}
+		blocks_.SetNativeBackend(native_);
+	} else if (PSP_CoreParameter().irBackend == IRBackend::THREADED) {
+		native_ = new IRThreadedInterpreter(mips);
+		blocks_.SetNativeBackend(native_);
+	}
+
+	std::string discID = g_paramSFO.GetDiscID();
+	if (g_Config.bIRDiskCache && !discID.empty()) {
+		File::CreateFullPath(GetSysDirectory(DIRECTORY_APP_CACHE));
+		diskCachePath_ = GetSysDirectory(DIRECTORY_APP_CACHE) + "/" + discID + ".ircache";
+		diskCache_.Load(diskCachePath_, opts);
+	}
+
+	if (g_Config.bIRTieredCompile) {
+		optimizer_.Start(opts);
+	}
 }
 
 IRJit::~IRJit() {
+	optimizer_.Stop();
+	if (!diskCachePath_.empty()) {
+		diskCache_.Save(diskCachePath_, frontend_.GetOptions());
+	}
+	delete native_;
 }
 
 void IRJit::DoState(PointerWrap &p) {
@@ -62,6 +121,11 @@ void IRJit::UpdateFCR31() {
 void IRJit::ClearCache() {
 	ILOG("IRJit: Clearing the cache!");
 	blocks_.Clear();
+	if (native_)
+		native_->ClearCache();
+	// Anything the optimizer is working on refers to the old block numbers.
+	optimizer_.Clear();
+	generation_++;
 }
 
 void IRJit::InvalidateCacheAt(u32 em_address, int length) {
@@ -71,6 +135,10 @@ void IRJit::InvalidateCacheAt(u32 em_address, int length) {
 void IRJit::Compile(u32 em_address) {
 	PROFILE_THIS_SCOPE("jitc");
 
+	if (native_ && native_->IsFull()) {
+		ClearCache();
+	}
+
 	if (g_Config.bPreloadFunctions) {
 		// Look to see if we've preloaded this block.
 		int block_num = blocks_.FindPreloadBlock(em_address);
@@ -80,6 +148,8 @@ void IRJit::Compile(u32 em_address) {
 			b->Finalize(block_num);
 			if (b->IsValid()) {
 				// Success, we're done.
+				if (b->GetNativeEntry())
+					native_->AddLinkTarget(em_address, b->GetNativeEntry());
 				return;
 			}
 		}
@@ -102,11 +172,32 @@ void IRJit::Compile(u32 em_address) {
 }
 
 bool IRJit::CompileBlock(u32 em_address, std::vector<IRInst> &instructions, u32 &mipsBytes, bool preload) {
-	frontend_.DoJit(em_address, instructions, mipsBytes, preload);
-	if (instructions.empty()) {
-		_dbg_assert_(JIT, preload);
-		// We return true when preloading so it doesn't abort.
-		return preload;
+	// Preloaded blocks may be cut short, so we only use the disk cache for real compiles.
+	bool useDiskCache = !preload && !diskCachePath_.empty() && !CBreakPoints::HasMemChecks();
+	u32 compileFlags = frontend_.GetCompileFlags();
+	// When tiered, new blocks start out unoptimized and get optimized on the worker once hot.
+	bool optimize = preload || !optimizer_.IsRunning();
+	bool tierUp = false;
+	std::vector<IRCodeRange> inlined;
+	if (!useDiskCache || !diskCache_.Lookup(em_address, compileFlags, instructions, mipsBytes) || CBreakPoints::RangeContainsBreakPoint(em_address, mipsBytes)) {
+		frontend_.DoJit(em_address, instructions, mipsBytes, preload, optimize);
+		if (instructions.empty()) {
+			_dbg_assert_(JIT, preload);
+			// We return true when preloading so it doesn't abort.
+			return preload;
+		}
+
+		inlined = frontend_.GetInlinedRanges();
+		// Stored blocks are only checked against their main range, so inlined calls can't be stored.
+		if (!inlined.empty())
+			useDiskCache = false;
+
+		// If the frontend changed its assumptions, CheckRounding() will have us recompile anyway.
+		if (optimize && useDiskCache && compileFlags == frontend_.GetCompileFlags() && !HasDebugOps(instructions)) {
+			diskCache_.Add(em_address, compileFlags, mipsBytes, IRBlock::CalculateHash(em_address, mipsBytes), instructions);
+		}
+		// The frontend skips the passes for blocks with breakpoints, so we must too.
+		tierUp = !optimize && !HasDebugOps(instructions);
 	}
 
 	int block_num = blocks_.AllocateBlock(em_address);
@@ -118,6 +209,17 @@ bool IRJit::CompileBlock(u32 em_address, std::vector<IRInst> &instructions, u32
 	IRBlock *b = blocks_.GetBlock(block_num);
 	b->SetInstructions(instructions);
 	b->SetOriginalSize(mipsBytes);
+	b->SetInlinedRanges(inlined);
+	b->SetCompileFlags(compileFlags);
+	if (tierUp) {
+		b->SetOptimizeCountdown(IR_OPTIMIZE_THRESHOLD);
+		// Used to check the code didn't change before we store the optimized version.
+		if (useDiskCache)
+			b->UpdateHash();
+	} else if (native_) {
+		// May fail, in which case we'll just interpret this block.
+		b->SetNativeEntry(native_->ConvertIRToNative(b->GetInstructions(), b->GetNumInstructions()));
+	}
 	if (preload) {
 		// Hash, then only update page stats, don't link yet.
 		b->UpdateHash();
@@ -126,11 +228,51 @@ bool IRJit::CompileBlock(u32 em_address, std::vector<IRInst> &instructions, u32
 		// Overwrites the first instruction, and also updates stats.
 		// TODO: Should we always hash?  Then we can reuse blocks.
 		blocks_.FinalizeBlock(block_num);
+		if (b->GetNativeEntry())
+			native_->AddLinkTarget(em_address, b->GetNativeEntry());
 	}
 
 	return true;
 }
 
+void IRJit::QueueOptimize(int block_num) {
+	IRBlock *b = blocks_.GetBlock(block_num);
+	IROptimizeThread::Job job;
+	job.blockNum = block_num;
+	job.generation = generation_;
+	job.instructions.assign(b->GetInstructions(), b->GetInstructions() + b->GetNumInstructions());
+	optimizer_.Enqueue(std::move(job));
+}
+
+void IRJit::InstallOptimizedBlocks() {
+	std::vector<IROptimizeThread::Job> results;
+	optimizer_.TakeResults(results);
+
+	for (IROptimizeThread::Job &job : results) {
+		IRBlock *b = blocks_.GetBlock(job.blockNum);
+		// The block may have been invalidated while the worker was busy.
+		if (job.generation != generation_ || !b || !b->IsValid() || job.instructions.empty())
+			continue;
+
+		// We're between blocks, so nothing is running the old instructions.
+		b->SetInstructions(job.instructions);
+		if (native_ && !native_->IsFull()) {
+			b->SetNativeEntry(native_->ConvertIRToNative(b->GetInstructions(), b->GetNumInstructions()));
+			u32 start, size;
+			b->GetRange(start, size);
+			if (b->GetNativeEntry())
+				native_->AddLinkTarget(start, b->GetNativeEntry());
+		}
+
+		bool canStore = b->GetInlinedRanges().empty() && b->GetCompileFlags() == frontend_.GetCompileFlags();
+		if (!diskCachePath_.empty() && canStore && b->HashMatches()) {
+			u32 start, size;
+			b->GetRange(start, size);
+			diskCache_.Add(start, b->GetCompileFlags(), size, b->GetHash(), job.instructions);
+		}
+	}
+}
+
 void IRJit::CompileFunction(u32 start_address, u32 length) {
 	PROFILE_THIS_SCOPE("jitc");
 
@@ -217,13 +359,24 @@ void IRJit::RunLoopUntil(u64 globalticks) {
 		if (coreState != 0) {
 			break;
 		}
+		if (optimizer_.HasResults()) {
+			InstallOptimizedBlocks();
+		}
 		while (mips_->downcount >= 0) {
 			u32 inst = Memory::ReadUnchecked_U32(mips_->pc);
 			u32 opcode = inst & 0xFF000000;
 			if (opcode == MIPS_EMUHACK_OPCODE) {
 				u32 data = inst & 0xFFFFFF;
 				IRBlock *block = blocks_.GetBlock(data);
-				mips_->pc = IRInterpret(mips_, block->GetInstructions(), block->GetNumInstructions());
+				if (block->TickOptimizeCountdown()) {
+					QueueOptimize(data);
+				}
+				const u8 *nativeEntry = block->GetNativeEntry();
+				if (nativeEntry) {
+					mips_->pc = native_->RunBlock(nativeEntry);
+				} else {
+					mips_->pc = IRInterpret(mips_, block->GetInstructions(), block->GetNumInstructions());
+				}
 			} else {
 				// RestoreRoundingMode(true);
 				Compile(mips_->pc);
@@ -237,6 +390,8 @@ void IRJit::RunLoopUntil(u64 globalticks) {
 
 bool IRJit::DescribeCodePtr(const u8 *ptr, std::string &name) {
 	// Used in target disassembly viewer.
+	if (native_)
+		return native_->DescribeCodePtr(ptr, name);
 	return false;
 }
 
@@ -273,6 +428,12 @@ void IRBlockCache::InvalidateICache(u32 address, u32 length) {
 		const std::vector<int> &blocksInPage = iter->second;
 		for (int i : blocksInPage) {
 			if (blocks_[i].OverlapsRange(address, length)) {
+				// Other native blocks may jump straight in, so stop that first.
+				if (native_ && blocks_[i].GetNativeEntry()) {
+					u32 start, size;
+					blocks_[i].GetRange(start, size);
+					native_->RemoveLinkTarget(start);
+				}
 				// Not removing from the page, hopefully doesn't build up with small recompiles.
 				blocks_[i].Destroy(i);
 			}
@@ -294,6 +455,18 @@ void IRBlockCache::FinalizeBlock(int i, bool preload) {
 	for (u32 page = startPage; page <= endPage; ++page) {
 		byPage_[page].push_back(i);
 	}
+
+	// Inlined calls must invalidate the block too.
+	for (const IRCodeRange &range : blocks_[i].GetInlinedRanges()) {
+		u32 inlineEndPage = AddressToPage(range.start + range.size);
+		for (u32 page = AddressToPage(range.start); page <= inlineEndPage; ++page) {
+			if (page >= startPage && page <= endPage)
+				continue;
+			std::vector<int> &blocksInPage = byPage_[page];
+			if (std::find(blocksInPage.begin(), blocksInPage.end(), i) == blocksInPage.end())
+				blocksInPage.push_back(i);
+		}
+	}
 }
 
 u32 IRBlockCache::AddressToPage(u32 addr) const {
@@ -459,31 +632,48 @@ void IRBlock::Destroy(int number) {
 
 		// Let's mark this invalid so we don't try to clear it again.
 		origAddr_ = 0;
+		nativeEntry_ = nullptr;
 	}
 }
 
 u64 IRBlock::CalculateHash() const {
 	if (origAddr_) {
-		// This is unfortunate.  In case of emuhacks, we have to make a copy.
-		std::vector<u32> buffer;
-		buffer.resize(origSize_ / 4);
-		size_t pos = 0;
-		for (u32 off = 0; off < origSize_; off += 4) {
-			// Let's actually hash the replacement, if any.
-			MIPSOpcode instr = Memory::ReadUnchecked_Instruction(origAddr_ + off, false);
-			buffer[pos++] = instr.encoding;
+		u64 hash = CalculateHash(origAddr_, origSize_);
+		for (const IRCodeRange &range : inlined_) {
+			u64 rangeHash[2] = { hash, CalculateHash(range.start, range.size) };
+			hash = XXH64(rangeHash, sizeof(rangeHash), 0x9A5C33B8);
 		}
-
-		return XXH64(&buffer[0], origSize_, 0x9A5C33B8);
+		return hash;
 	}
 
 	return 0;
 }
 
+u64 IRBlock::CalculateHash(u32 addr, u32 size) {
+	// This is unfortunate.  In case of emuhacks, we have to make a copy.
+	std::vector<u32> buffer;
+	buffer.resize(size / 4);
+	size_t pos = 0;
+	for (u32 off = 0; off < size; off += 4) {
+		// Let's actually hash the replacement, if any.
+		MIPSOpcode instr = Memory::ReadUnchecked_Instruction(addr + off, false);
+		buffer[pos++] = instr.encoding;
+	}
+
+	return XXH64(buffer.data(), size, 0x9A5C33B8);
+}
+
 bool IRBlock::OverlapsRange(u32 addr, u32 size) const {
 	addr &= 0x3FFFFFFF;
 	u32 origAddr = origAddr_ & 0x3FFFFFFF;
-	return addr + size > origAddr && addr < origAddr + origSize_;
+	if (addr + size > origAddr && addr < origAddr + origSize_)
+		return true;
+	for (const IRCodeRange &range : inlined_) {
+		u32 start = range.start & 0x3FFFFFFF;
+		if (addr + size > start && addr < start + range.size)
+			return true;
+	}
+	return false;
 }
 
 MIPSOpcode IRJit::GetOriginalOp(MIPSOpcode op) {
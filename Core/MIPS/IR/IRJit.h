@@ -18,12 +18,15 @@
 #pragma once
 
 #include <cstring>
+#include <string>
 #include <unordered_map>
 
 #include "Common/Common.h"
 #include "Common/CPUDetect.h"
 #include "Core/MIPS/JitCommon/JitBlockCache.h"
 #include "Core/MIPS/JitCommon/JitCommon.h"
+#include "Core/MIPS/IR/IRDiskCache.h"
+#include "Core/MIPS/IR/IROptimizeThread.h"
 #include "Core/MIPS/IR/IRRegCache.h"
 #include "Core/MIPS/IR/IRInst.h"
 #include "Core/MIPS/IR/IRFrontend.h"
@@ -35,6 +38,23 @@
 
 namespace MIPSComp {
 
+// Optional backend that turns optimized IR blocks into host code.
+class IRToNativeInterface {
+public:
+	virtual ~IRToNativeInterface() {}
+
+	// Returns the entry point, or nullptr if the block has to stay on the interpreter.
+	virtual const u8 *ConvertIRToNative(const IRInst *instructions, int count) = 0;
+	// Runs a block returned by ConvertIRToNative, and returns the new PC like IRInterpret.
+	virtual u32 RunBlock(const u8 *entry) = 0;
+	// Lets other native blocks exit directly into entry.  Only for finalized, valid blocks.
+	virtual void AddLinkTarget(u32 em_address, const u8 *entry) = 0;
+	virtual void RemoveLinkTarget(u32 em_address) = 0;
+	virtual void ClearCache() = 0;
+	virtual bool IsFull() const = 0;
+	virtual bool DescribeCodePtr(const u8 *ptr, std::string &name) = 0;
+};
+
 // TODO : Use arena allocators. For now let's just malloc.
 class IRBlock {
 public:
@@ -47,6 +67,10 @@ class IRBlock {
 		origSize_ = b.origSize_;
 		origFirstOpcode_ = b.origFirstOpcode_;
 		hash_ = b.hash_;
+		nativeEntry_ = b.nativeEntry_;
+		optimizeCountdown_ = b.optimizeCountdown_;
+		compileFlags_ = b.compileFlags_;
+		inlined_ = std::move(b.inlined_);
 		b.instr_ = nullptr;
 	}
 
@@ -55,6 +79,7 @@ class IRBlock {
 	}
 
 	void SetInstructions(const std::vector<IRInst> &inst) {
+		delete[] instr_;
 		instr_ = new IRInst[inst.size()];
 		numInstructions_ = (u16)inst.size();
 		if (!inst.empty()) {
@@ -63,6 +88,16 @@ class IRBlock {
 	}
 
 	const IRInst *GetInstructions() const { return instr_; }
+	const u8 *GetNativeEntry() const { return nativeEntry_; }
+	void SetNativeEntry(const u8 *entry) { nativeEntry_ = entry; }
+	// For tiered compilation: returns true once, when the block has run count times.
+	void SetOptimizeCountdown(u32 count) { optimizeCountdown_ = count; }
+	bool TickOptimizeCountdown() {
+		return optimizeCountdown_ != 0 && --optimizeCountdown_ == 0;
+	}
+	// The frontend assumptions the instructions were generated under.
+	void SetCompileFlags(u32 flags) { compileFlags_ = flags; }
+	u32 GetCompileFlags() const { return compileFlags_; }
 	int GetNumInstructions() const { return numInstructions_; }
 	MIPSOpcode GetOriginalFirstOp() const { return origFirstOpcode_; }
 	bool HasOriginalFirstOp() const;
@@ -71,12 +106,21 @@ class IRBlock {
 	void SetOriginalSize(u32 size) {
 		origSize_ = size;
 	}
+	// Code outside the main range the block depends on, from inlined calls.
+	void SetInlinedRanges(const std::vector<IRCodeRange> &ranges) {
+		inlined_ = ranges;
+	}
+	const std::vector<IRCodeRange> &GetInlinedRanges() const {
+		return inlined_;
+	}
 	void UpdateHash() {
 		hash_ = CalculateHash();
 	}
 	bool HashMatches() const {
 		return origAddr_ && hash_ == CalculateHash();
 	}
+	u64 GetHash() const { return hash_; }
+	static u64 CalculateHash(u32 addr, u32 size);
 	bool OverlapsRange(u32 addr, u32 size) const;
 
 	void GetRange(u32 &start, u32 &size) const {
@@ -95,12 +139,19 @@ class IRBlock {
 	u32 origAddr_;
 	u32 origSize_;
 	u64 hash_ = 0;
+	const u8 *nativeEntry_ = nullptr;
+	u32 optimizeCountdown_ = 0;
+	u32 compileFlags_ = 0;
+	std::vector<IRCodeRange> inlined_;
 	MIPSOpcode origFirstOpcode_ = MIPSOpcode(0x68FFFFFF);
 };
 
 class IRBlockCache : public JitBlockCacheDebugInterface {
 public:
 	IRBlockCache() {}
+	void SetNativeBackend(IRToNativeInterface *native) {
+		native_ = native;
+	}
 	void Clear();
 	void InvalidateICache(u32 address, u32 length);
 	void FinalizeBlock(int i, bool preload = false);
@@ -131,6 +182,7 @@ class IRBlockCache : public JitBlockCacheDebugInterface {
 
 	std::vector<IRBlock> blocks_;
 	std::unordered_map<u32, std::vector<int>> byPage_;
+	IRToNativeInterface *native_ = nullptr;
 };
 
 class IRJit : public JitInterface {
@@ -167,12 +219,20 @@ class IRJit : public JitInterface {
 
 private:
 	bool CompileBlock(u32 em_address, std::vector<IRInst> &instructions, u32 &mipsBytes, bool preload);
+	void QueueOptimize(int block_num);
+	void InstallOptimizedBlocks();
 	bool ReplaceJalTo(u32 dest);
 
 	JitOptions jo;
 
 	IRFrontend frontend_;
 	IRBlockCache blocks_;
+	IRToNativeInterface *native_ = nullptr;
+	IRDiskCache diskCache_;
+	std::string diskCachePath_;
+	IROptimizeThread optimizer_;
+	// Bumped on every ClearCache(), since block numbers get reused.
+	u32 generation_ = 0;
 
 	MIPSState *mips_;
 
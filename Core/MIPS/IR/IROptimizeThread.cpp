@@ -0,0 +1,95 @@
+// Copyright (c) 2012- PPSSPP Project.
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, version 2.0 or later versions.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License 2.0 for more details.
+
+// A copy of the GPL 2.0 should have been included with the program.
+// If not, see http://www.gnu.org/licenses/
+
+// Official git repository and contact information can be found at
+// https://github.com/hrydgard/ppsspp and http://www.ppsspp.org/.
+
+#include "thread/threadutil.h"
+#include "Core/MIPS/IR/IRFrontend.h"
+#include "Core/MIPS/IR/IROptimizeThread.h"
+
+namespace MIPSComp {
+
+void IROptimizeThread::Start(const IROptions &opts) {
+	if (IsRunning())
+		return;
+
+	opts_ = opts;
+	stop_ = false;
+	thread_ = std::thread(&IROptimizeThread::Run, this);
+}
+
+void IROptimizeThread::Stop() {
+	if (!IsRunning())
+		return;
+
+	{
+		std::lock_guard<std::mutex> guard(mutex_);
+		stop_ = true;
+		wake_.notify_one();
+	}
+	thread_.join();
+	Clear();
+}
+
+void IROptimizeThread::Enqueue(Job &&job) {
+	std::lock_guard<std::mutex> guard(mutex_);
+	pending_.push_back(std::move(job));
+	wake_.notify_one();
+}
+
+void IROptimizeThread::Clear() {
+	std::lock_guard<std::mutex> guard(mutex_);
+	pending_.clear();
+	results_.clear();
+	hasResults_ = false;
+}
+
+void IROptimizeThread::TakeResults(std::vector<Job> &results) {
+	std::lock_guard<std::mutex> guard(mutex_);
+	results.swap(results_);
+	results_.clear();
+	hasResults_ = false;
+}
+
+void IROptimizeThread::Run() {
+	setCurrentThreadName("IROptimize");
+
+	std::unique_lock<std::mutex> guard(mutex_);
+	while (!stop_) {
+		if (pending_.empty()) {
+			wake_.wait(guard);
+			continue;
+		}
+
+		Job job = std::move(pending_.front());
+		pending_.pop_front();
+
+		// The passes only look at the instructions, so we can let the emu thread keep going.
+		guard.unlock();
+		IRWriter in, out;
+		for (const IRInst &inst : job.instructions) {
+			in.Write(inst);
+		}
+		IRFrontend::OptimizeIR(in, out, opts_);
+		job.instructions = out.GetInstructions();
+		guard.lock();
+
+		// If Clear() was called meanwhile, the generation check will catch this one.
+		results_.push_back(std::move(job));
+		hasResults_ = true;
+	}
+}
+
+}  // namespace MIPSComp
@@ -0,0 +1,76 @@
+// Copyright (c) 2012- PPSSPP Project.
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, version 2.0 or later versions.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License 2.0 for more details.
+
+// A copy of the GPL 2.0 should have been included with the program.
+// If not, see http://www.gnu.org/licenses/
+
+// Official git repository and contact information can be found at
+// https://github.com/hrydgard/ppsspp and http://www.ppsspp.org/.
+
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "Common/CommonTypes.h"
+#include "Core/MIPS/IR/IRInst.h"
+
+namespace MIPSComp {
+
+// Runs the IR passes for hot blocks on a worker thread, for the tiered IRJit mode.
+// The worker never touches blocks directly: the emu thread installs the results itself,
+// between blocks, after checking they still apply.
+class IROptimizeThread {
+public:
+	struct Job {
+		int blockNum;
+		// IRJit bumps this on every cache clear, so we can drop results for reused block numbers.
+		u32 generation;
+		std::vector<IRInst> instructions;
+	};
+
+	~IROptimizeThread() {
+		Stop();
+	}
+
+	void Start(const IROptions &opts);
+	void Stop();
+	bool IsRunning() const {
+		return thread_.joinable();
+	}
+
+	void Enqueue(Job &&job);
+	// Drops both pending jobs and finished results.
+	void Clear();
+
+	bool HasResults() const {
+		return hasResults_;
+	}
+	void TakeResults(std::vector<Job> &results);
+
+private:
+	void Run();
+
+	IROptions opts_{};
+	std::thread thread_;
+	std::mutex mutex_;
+	std::condition_variable wake_;
+	std::deque<Job> pending_;
+	std::vector<Job> results_;
+	std::atomic<bool> hasResults_{ false };
+	bool stop_ = false;
+};
+
+}  // namespace MIPSComp
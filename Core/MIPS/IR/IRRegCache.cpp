@@ -66,3 +66,39 @@ void IRRegCache::MapDirtyInIn(int rd, int rs, int rt) {
 	Flush(rt);
 }
 
+
+bool IRLiveness::IsTemp(int r) {
+	return r >= IRTEMP_0 && r <= IRTEMP_LR_SHIFT;
+}
+
+void IRLiveness::Analyze(const IRInst *instructions, int count) {
+	std::bitset<TOTAL_MAPPABLE_MIPSREGS> context;
+	for (int r = 0; r < TOTAL_MAPPABLE_MIPSREGS; ++r) {
+		context[r] = !IsTemp(r);
+	}
+
+	liveBefore_.resize(count);
+	// Blocks always end with an exit, so nothing is live after the last instruction.
+	std::bitset<TOTAL_MAPPABLE_MIPSREGS> live;
+	for (int i = count - 1; i >= 0; --i) {
+		const IRInst &inst = instructions[i];
+		const IRMeta *m = GetIRMeta(inst.op);
+
+		if ((m->flags & IRFLAG_EXIT) != 0 || inst.op == IROp::Interpret || inst.op == IROp::CallReplacement) {
+			live |= context;
+		}
+		if (m->types[0] == 'G') {
+			if ((m->flags & (IRFLAG_SRC3 | IRFLAG_SRC3DST)) != 0) {
+				live[inst.src3] = true;
+			} else {
+				live[inst.dest] = false;
+			}
+		}
+		if (m->types[0] && m->types[1] == 'G')
+			live[inst.src1] = true;
+		if (m->types[0] && m->types[1] && m->types[2] == 'G')
+			live[inst.src2] = true;
+
+		liveBefore_[i] = live;
+	}
+}
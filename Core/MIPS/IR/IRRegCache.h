@@ -3,6 +3,9 @@
 // IRRegCache is only to perform pre-constant folding. This is worth it to get cleaner
 // IR.
 
+#include <bitset>
+#include <vector>
+
 #include "Common/CommonTypes.h"
 #include "Core/MIPS/MIPS.h"
 
@@ -16,6 +19,7 @@ struct RegIR {
 };
 
 class IRWriter;
+struct IRInst;
 
 // Transient
 class IRRegCache {
@@ -45,3 +49,20 @@ class IRRegCache {
 	RegIR reg_[TOTAL_MAPPABLE_MIPSREGS];
 	IRWriter *ir_;
 };
+
+// Backwards liveness of IR GPRs within one block, for register allocators.
+// Exits and interpreted ops read the whole context, so everything except temps is live there.
+// Temps never survive an exit, which is what lets allocators skip writing them back.
+class IRLiveness {
+public:
+	void Analyze(const IRInst *instructions, int count);
+
+	// Whether the value of r before instruction i may still be read.
+	bool IsLiveBefore(int i, int r) const {
+		return liveBefore_[i][r];
+	}
+	static bool IsTemp(int r);
+
+private:
+	std::vector<std::bitset<TOTAL_MAPPABLE_MIPSREGS>> liveBefore_;
+};
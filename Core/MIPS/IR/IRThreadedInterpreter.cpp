@@ -0,0 +1,474 @@
+// Copyright (c) 2012- PPSSPP Project.
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, version 2.0 or later versions.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License 2.0 for more details.
+
+// A copy of the GPL 2.0 should have been included with the program.
+// If not, see http://www.gnu.org/licenses/
+
+// Official git repository and contact information can be found at
+// https://github.com/hrydgard/ppsspp and http://www.ppsspp.org/.
+
+#include <cstring>
+
+#include "Common/Log.h"
+#include "Core/MemMap.h"
+#include "Core/MIPS/MIPS.h"
+#include "Core/MIPS/IR/IRInterpreter.h"
+#include "Core/MIPS/IR/IRThreadedInterpreter.h"
+
+// Labels as values make each handler jump directly to the next one, which branch predictors like
+// far better than the single indirect jump of a switch.  MSVC doesn't have them, so it gets a switch.
+#if defined(__GNUC__) || defined(__clang__)
+#define IR_THREADED_COMPUTED_GOTO 1
+#endif
+
+namespace MIPSComp {
+
+// Blocks are decoded into chunks, so entry pointers stay valid until ClearCache().
+static const size_t CHUNK_OPS = 0x10000;
+static const size_t MAX_CHUNKS = 8;
+
+#define IR_THREADED_HANDLERS(X) \
+	X(Generic) X(Skip) \
+	X(SetConst) X(SetConstF) X(Mov) \
+	X(Add) X(Sub) X(Neg) X(Not) X(And) X(Or) X(Xor) \
+	X(AddConst) X(SubConst) X(AndConst) X(OrConst) X(XorConst) \
+	X(Shl) X(Shr) X(Sar) X(ShlImm) X(ShrImm) X(SarImm) \
+	X(Slt) X(SltConst) X(SltU) X(SltUConst) \
+	X(MovZ) X(MovNZ) X(Max) X(Min) X(Ext8to32) X(Ext16to32) \
+	X(MtLo) X(MtHi) X(MfLo) X(MfHi) \
+	X(Load8) X(Load8Ext) X(Load16) X(Load16Ext) X(Load32) X(LoadFloat) \
+	X(Store8) X(Store16) X(Store32) X(StoreFloat) \
+	X(FAdd) X(FSub) X(FMul) X(FDiv) X(FMov) X(FMovFromGPR) X(FMovToGPR) \
+	X(Downcount) X(SetPC) X(SetPCConst) \
+	X(ExitToConst) X(ExitToReg) X(ExitToPC) \
+	X(ExitIfEq) X(ExitIfNeq) X(ExitIfGtZ) X(ExitIfGeZ) X(ExitIfLtZ) X(ExitIfLeZ)
+
+enum class IRThreadedHandler {
+#define IR_THREADED_ENUM(name) name,
+	IR_THREADED_HANDLERS(IR_THREADED_ENUM)
+#undef IR_THREADED_ENUM
+	COUNT,
+};
+
+static const void *handlerLabels[(int)IRThreadedHandler::COUNT];
+
+// With labels non-null, just fills them in with the handler addresses.
+static u32 Execute(MIPSState *mips, const IRThreadedOp *op, const void **labels) {
+#ifdef IR_THREADED_COMPUTED_GOTO
+	if (labels) {
+#define IR_THREADED_LABEL(name) labels[(int)IRThreadedHandler::name] = &&L_##name;
+		IR_THREADED_HANDLERS(IR_THREADED_LABEL)
+#undef IR_THREADED_LABEL
+		return 0;
+	}
+
+#define HANDLER(name) L_##name:
+#define NEXT() do { ++op; goto *op->handler; } while (false)
+	goto *op->handler;
+	{
+#else
+#define HANDLER(name) case IRThreadedHandler::name:
+#define NEXT() do { ++op; goto dispatch; } while (false)
+dispatch:
+	switch ((IRThreadedHandler)(uintptr_t)op->handler) {
+#endif
+
+	HANDLER(Generic)
+	{
+		u32 pc = IRInterpret(mips, op->generic, 2);
+		if (pc != 0)
+			return pc;
+		NEXT();
+	}
+	HANDLER(Skip)
+		NEXT();
+
+	HANDLER(SetConst)
+		*op->dest.r = op->constant;
+		NEXT();
+	HANDLER(SetConstF)
+		memcpy(op->dest.f, &op->constant, 4);
+		NEXT();
+	HANDLER(Mov)
+		*op->dest.r = *op->src1.r;
+		NEXT();
+
+	HANDLER(Add)
+		*op->dest.r = *op->src1.r + *op->src2.r;
+		NEXT();
+	HANDLER(Sub)
+		*op->dest.r = *op->src1.r - *op->src2.r;
+		NEXT();
+	HANDLER(Neg)
+		*op->dest.r = -(s32)*op->src1.r;
+		NEXT();
+	HANDLER(Not)
+		*op->dest.r = ~*op->src1.r;
+		NEXT();
+	HANDLER(And)
+		*op->dest.r = *op->src1.r & *op->src2.r;
+		NEXT();
+	HANDLER(Or)
+		*op->dest.r = *op->src1.r | *op->src2.r;
+		NEXT();
+	HANDLER(Xor)
+		*op->dest.r = *op->src1.r ^ *op->src2.r;
+		NEXT();
+
+	HANDLER(AddConst)
+		*op->dest.r = *op->src1.r + op->constant;
+		NEXT();
+	HANDLER(SubConst)
+		*op->dest.r = *op->src1.r - op->constant;
+		NEXT();
+	HANDLER(AndConst)
+		*op->dest.r = *op->src1.r & op->constant;
+		NEXT();
+	HANDLER(OrConst)
+		*op->dest.r = *op->src1.r | op->constant;
+		NEXT();
+	HANDLER(XorConst)
+		*op->dest.r = *op->src1.r ^ op->constant;
+		NEXT();
+
+	HANDLER(Shl)
+		*op->dest.r = *op->src1.r << (*op->src2.r & 31);
+		NEXT();
+	HANDLER(Shr)
+		*op->dest.r = *op->src1.r >> (*op->src2.r & 31);
+		NEXT();
+	HANDLER(Sar)
+		*op->dest.r = (s32)*op->src1.r >> (*op->src2.r & 31);
+		NEXT();
+	// For these, the shift amount was moved to constant.
+	HANDLER(ShlImm)
+		*op->dest.r = *op->src1.r << op->constant;
+		NEXT();
+	HANDLER(ShrImm)
+		*op->dest.r = *op->src1.r >> op->constant;
+		NEXT();
+	HANDLER(SarImm)
+		*op->dest.r = (s32)*op->src1.r >> op->constant;
+		NEXT();
+
+	HANDLER(Slt)
+		*op->dest.r = (s32)*op->src1.r < (s32)*op->src2.r;
+		NEXT();
+	HANDLER(SltConst)
+		*op->dest.r = (s32)*op->src1.r < (s32)op->constant;
+		NEXT();
+	HANDLER(SltU)
+		*op->dest.r = *op->src1.r < *op->src2.r;
+		NEXT();
+	HANDLER(SltUConst)
+		*op->dest.r = *op->src1.r < op->constant;
+		NEXT();
+
+	HANDLER(MovZ)
+		if (*op->src1.r == 0)
+			*op->dest.r = *op->src2.r;
+		NEXT();
+	HANDLER(MovNZ)
+		if (*op->src1.r != 0)
+			*op->dest.r = *op->src2.r;
+		NEXT();
+	HANDLER(Max)
+		*op->dest.r = (s32)*op->src1.r > (s32)*op->src2.r ? *op->src1.r : *op->src2.r;
+		NEXT();
+	HANDLER(Min)
+		*op->dest.r = (s32)*op->src1.r < (s32)*op->src2.r ? *op->src1.r : *op->src2.r;
+		NEXT();
+	HANDLER(Ext8to32)
+		*op->dest.r = (s32)(s8)*op->src1.r;
+		NEXT();
+	HANDLER(Ext16to32)
+		*op->dest.r = (s32)(s16)*op->src1.r;
+		NEXT();
+
+	HANDLER(MtLo)
+		mips->lo = *op->src1.r;
+		NEXT();
+	HANDLER(MtHi)
+		mips->hi = *op->src1.r;
+		NEXT();
+	HANDLER(MfLo)
+		*op->dest.r = mips->lo;
+		NEXT();
+	HANDLER(MfHi)
+		*op->dest.r = mips->hi;
+		NEXT();
+
+	HANDLER(Load8)
+		*op->dest.r = Memory::ReadUnchecked_U8(*op->src1.r + op->constant);
+		NEXT();
+	HANDLER(Load8Ext)
+		*op->dest.r = (s32)(s8)Memory::ReadUnchecked_U8(*op->src1.r + op->constant);
+		NEXT();
+	HANDLER(Load16)
+		*op->dest.r = Memory::ReadUnchecked_U16(*op->src1.r + op->constant);
+		NEXT();
+	HANDLER(Load16Ext)
+		*op->dest.r = (s32)(s16)Memory::ReadUnchecked_U16(*op->src1.r + op->constant);
+		NEXT();
+	HANDLER(Load32)
+		*op->dest.r = Memory::ReadUnchecked_U32(*op->src1.r + op->constant);
+		NEXT();
+	HANDLER(LoadFloat)
+		*op->dest.f = Memory::ReadUnchecked_Float(*op->src1.r + op->constant);
+		NEXT();
+
+	// Stores keep src3 in dest.
+	HANDLER(Store8)
+		Memory::WriteUnchecked_U8(*op->dest.r, *op->src1.r + op->constant);
+		NEXT();
+	HANDLER(Store16)
+		Memory::WriteUnchecked_U16(*op->dest.r, *op->src1.r + op->constant);
+		NEXT();
+	HANDLER(Store32)
+		Memory::WriteUnchecked_U32(*op->dest.r, *op->src1.r + op->constant);
+		NEXT();
+	HANDLER(StoreFloat)
+		Memory::WriteUnchecked_Float(*op->dest.f, *op->src1.r + op->constant);
+		NEXT();
+
+	HANDLER(FAdd)
+		*op->dest.f = *op->src1.f + *op->src2.f;
+		NEXT();
+	HANDLER(FSub)
+		*op->dest.f = *op->src1.f - *op->src2.f;
+		NEXT();
+	HANDLER(FMul)
+		*op->dest.f = *op->src1.f * *op->src2.f;
+		NEXT();
+	HANDLER(FDiv)
+		*op->dest.f = *op->src1.f / *op->src2.f;
+		NEXT();
+	HANDLER(FMov)
+		*op->dest.f = *op->src1.f;
+		NEXT();
+	HANDLER(FMovFromGPR)
+		memcpy(op->dest.f, op->src1.r, 4);
+		NEXT();
+	HANDLER(FMovToGPR)
+		memcpy(op->dest.r, op->src1.f, 4);
+		NEXT();
+
+	HANDLER(Downcount)
+		mips->downcount -= op->constant;
+		NEXT();
+	HANDLER(SetPC)
+		mips->pc = *op->src1.r;
+		NEXT();
+	HANDLER(SetPCConst)
+		mips->pc = op->constant;
+		NEXT();
+
+	HANDLER(ExitToConst)
+		return op->constant;
+	HANDLER(ExitToReg)
+		return *op->src1.r;
+	HANDLER(ExitToPC)
+		return mips->pc;
+
+	HANDLER(ExitIfEq)
+		if (*op->src1.r == *op->src2.r)
+			return op->constant;
+		NEXT();
+	HANDLER(ExitIfNeq)
+		if (*op->src1.r != *op->src2.r)
+			return op->constant;
+		NEXT();
+	HANDLER(ExitIfGtZ)
+		if ((s32)*op->src1.r > 0)
+			return op->constant;
+		NEXT();
+	HANDLER(ExitIfGeZ)
+		if ((s32)*op->src1.r >= 0)
+			return op->constant;
+		NEXT();
+	HANDLER(ExitIfLtZ)
+		if ((s32)*op->src1.r < 0)
+			return op->constant;
+		NEXT();
+	HANDLER(ExitIfLeZ)
+		if ((s32)*op->src1.r <= 0)
+			return op->constant;
+		NEXT();
+
+#ifndef IR_THREADED_COMPUTED_GOTO
+	default:
+		break;
+#endif
+	}
+#undef HANDLER
+#undef NEXT
+
+	// Blocks always end with an exit.
+	_assert_msg_(JIT, false, "IRThreadedInterpreter: ran off the end of a block");
+	return 0;
+}
+
+static IRThreadedHandler HandlerForOp(IROp op) {
+	switch (op) {
+	case IROp::SetConst: return IRThreadedHandler::SetConst;
+	case IROp::SetConstF: return IRThreadedHandler::SetConstF;
+	case IROp::Mov: return IRThreadedHandler::Mov;
+	case IROp::Add: return IRThreadedHandler::Add;
+	case IROp::Sub: return IRThreadedHandler::Sub;
+	case IROp::Neg: return IRThreadedHandler::Neg;
+	case IROp::Not: return IRThreadedHandler::Not;
+	case IROp::And: return IRThreadedHandler::And;
+	case IROp::Or: return IRThreadedHandler::Or;
+	case IROp::Xor: return IRThreadedHandler::Xor;
+	case IROp::AddConst: return IRThreadedHandler::AddConst;
+	case IROp::SubConst: return IRThreadedHandler::SubConst;
+	case IROp::AndConst: return IRThreadedHandler::AndConst;
+	case IROp::OrConst: return IRThreadedHandler::OrConst;
+	case IROp::XorConst: return IRThreadedHandler::XorConst;
+	case IROp::Shl: return IRThreadedHandler::Shl;
+	case IROp::Shr: return IRThreadedHandler::Shr;
+	case IROp::Sar: return IRThreadedHandler::Sar;
+	case IROp::ShlImm: return IRThreadedHandler::ShlImm;
+	case IROp::ShrImm: return IRThreadedHandler::ShrImm;
+	case IROp::SarImm: return IRThreadedHandler::SarImm;
+	case IROp::Slt: return IRThreadedHandler::Slt;
+	case IROp::SltConst: return IRThreadedHandler::SltConst;
+	case IROp::SltU: return IRThreadedHandler::SltU;
+	case IROp::SltUConst: return IRThreadedHandler::SltUConst;
+	case IROp::MovZ: return IRThreadedHandler::MovZ;
+	case IROp::MovNZ: return IRThreadedHandler::MovNZ;
+	case IROp::Max: return IRThreadedHandler::Max;
+	case IROp::Min: return IRThreadedHandler::Min;
+	case IROp::Ext8to32: return IRThreadedHandler::Ext8to32;
+	case IROp::Ext16to32: return IRThreadedHandler::Ext16to32;
+	case IROp::MtLo: return IRThreadedHandler::MtLo;
+	case IROp::MtHi: return IRThreadedHandler::MtHi;
+	case IROp::MfLo: return IRThreadedHandler::MfLo;
+	case IROp::MfHi: return IRThreadedHandler::MfHi;
+	case IROp::Load8: return IRThreadedHandler::Load8;
+	case IROp::Load8Ext: return IRThreadedHandler::Load8Ext;
+	case IROp::Load16: return IRThreadedHandler::Load16;
+	case IROp::Load16Ext: return IRThreadedHandler::Load16Ext;
+	case IROp::Load32: return IRThreadedHandler::Load32;
+	case IROp::LoadFloat: return IRThreadedHandler::LoadFloat;
+	case IROp::Store8: return IRThreadedHandler::Store8;
+	case IROp::Store16: return IRThreadedHandler::Store16;
+	case IROp::Store32: return IRThreadedHandler::Store32;
+	case IROp::StoreFloat: return IRThreadedHandler::StoreFloat;
+	case IROp::FAdd: return IRThreadedHandler::FAdd;
+	case IROp::FSub: return IRThreadedHandler::FSub;
+	case IROp::FMul: return IRThreadedHandler::FMul;
+	case IROp::FDiv: return IRThreadedHandler::FDiv;
+	case IROp::FMov: return IRThreadedHandler::FMov;
+	case IROp::FMovFromGPR: return IRThreadedHandler::FMovFromGPR;
+	case IROp::FMovToGPR: return IRThreadedHandler::FMovToGPR;
+	case IROp::Downcount: return IRThreadedHandler::Downcount;
+	case IROp::SetPC: return IRThreadedHandler::SetPC;
+	case IROp::SetPCConst: return IRThreadedHandler::SetPCConst;
+	case IROp::ExitToConst: return IRThreadedHandler::ExitToConst;
+	case IROp::ExitToReg: return IRThreadedHandler::ExitToReg;
+	case IROp::ExitToPC: return IRThreadedHandler::ExitToPC;
+	case IROp::ExitToConstIfEq: return IRThreadedHandler::ExitIfEq;
+	case IROp::ExitToConstIfNeq: return IRThreadedHandler::ExitIfNeq;
+	case IROp::ExitToConstIfGtZ: return IRThreadedHandler::ExitIfGtZ;
+	case IROp::ExitToConstIfGeZ: return IRThreadedHandler::ExitIfGeZ;
+	case IROp::ExitToConstIfLtZ: return IRThreadedHandler::ExitIfLtZ;
+	case IROp::ExitToConstIfLeZ: return IRThreadedHandler::ExitIfLeZ;
+
+	case IROp::ApplyRoundingMode:
+	case IROp::RestoreRoundingMode:
+	case IROp::UpdateRoundingMode:
+		// Not implemented by the interpreter either.
+		return IRThreadedHandler::Skip;
+
+	default:
+		return IRThreadedHandler::Generic;
+	}
+}
+
+IRThreadedInterpreter::IRThreadedInterpreter(MIPSState *mips) : mips_(mips) {
+#ifdef IR_THREADED_COMPUTED_GOTO
+	Execute(nullptr, nullptr, handlerLabels);
+#endif
+}
+
+void IRThreadedInterpreter::Decode(const IRInst &inst, IRThreadedOp &op) {
+	IRThreadedHandler handler = HandlerForOp(inst.op);
+#ifdef IR_THREADED_COMPUTED_GOTO
+	op.handler = handlerLabels[(int)handler];
+#else
+	op.handler = (const void *)(uintptr_t)handler;
+#endif
+
+	const IRMeta *meta = GetIRMeta(inst.op);
+	auto resolve = [&](char type, u8 reg) -> u32 * {
+		switch (type) {
+		case 'G': return &mips_->r[reg];
+		case 'F': return (u32 *)&mips_->f[reg];
+		default: return nullptr;
+		}
+	};
+	// For stores, dest is actually src3, but it resolves the same way.
+	op.dest.r = resolve(meta->types[0], inst.dest);
+	op.src1.r = meta->types[0] ? resolve(meta->types[1], inst.src1) : nullptr;
+	op.src2.r = meta->types[0] && meta->types[1] ? resolve(meta->types[2], inst.src2) : nullptr;
+	op.constant = inst.constant;
+
+	switch (inst.op) {
+	case IROp::ShlImm:
+	case IROp::ShrImm:
+	case IROp::SarImm:
+		op.constant = inst.src2;
+		break;
+	default:
+		break;
+	}
+
+	op.generic[0] = inst;
+	op.generic[1] = IRInst{};
+	op.generic[1].op = IROp::ExitToConst;
+	op.generic[1].constant = 0;
+}
+
+const u8 *IRThreadedInterpreter::ConvertIRToNative(const IRInst *instructions, int count) {
+	if (count == 0 || (size_t)count > CHUNK_OPS)
+		return nullptr;
+
+	if (chunks_.empty() || chunkUsed_ + count > CHUNK_OPS) {
+		if (chunks_.size() >= MAX_CHUNKS)
+			return nullptr;
+		chunks_.push_back(std::unique_ptr<IRThreadedOp[]>(new IRThreadedOp[CHUNK_OPS]));
+		chunkUsed_ = 0;
+	}
+
+	IRThreadedOp *ops = chunks_.back().get() + chunkUsed_;
+	for (int i = 0; i < count; ++i) {
+		Decode(instructions[i], ops[i]);
+	}
+	chunkUsed_ += count;
+	return (const u8 *)ops;
+}
+
+u32 IRThreadedInterpreter::RunBlock(const u8 *entry) {
+	return Execute(mips_, (const IRThreadedOp *)entry, nullptr);
+}
+
+void IRThreadedInterpreter::ClearCache() {
+	chunks_.clear();
+	chunkUsed_ = 0;
+}
+
+bool IRThreadedInterpreter::IsFull() const {
+	// Leave room for at least a big block.
+	return chunks_.size() >= MAX_CHUNKS && chunkUsed_ + 0x1000 > CHUNK_OPS;
+}
+
+}  // namespace MIPSComp
@@ -0,0 +1,70 @@
+// Copyright (c) 2012- PPSSPP Project.
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, version 2.0 or later versions.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License 2.0 for more details.
+
+// A copy of the GPL 2.0 should have been included with the program.
+// If not, see http://www.gnu.org/licenses/
+
+// Official git repository and contact information can be found at
+// https://github.com/hrydgard/ppsspp and http://www.ppsspp.org/.
+
+#pragma once
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "Common/CommonTypes.h"
+#include "Core/MIPS/IR/IRInst.h"
+#include "Core/MIPS/IR/IRJit.h"
+
+class MIPSState;
+
+namespace MIPSComp {
+
+// Pre-decoded form of one IRInst.  Register operands are resolved to pointers into the context,
+// so the handlers don't have to look anything up.
+struct IRThreadedOp {
+	// A label address with computed goto, otherwise an index into the handler switch.
+	const void *handler;
+	union {
+		u32 *r;
+		float *f;
+	} dest, src1, src2;
+	u32 constant;
+	// Ops without a handler run through IRInterpret(), followed by an exit to 0 to signal fall through.
+	IRInst generic[2];
+};
+
+// Backend for hosts where we can't generate code.  Each block is decoded once into threaded code,
+// which skips the decode and the big switch IRInterpret() does for every instruction.
+class IRThreadedInterpreter : public IRToNativeInterface {
+public:
+	IRThreadedInterpreter(MIPSState *mips);
+
+	const u8 *ConvertIRToNative(const IRInst *instructions, int count) override;
+	u32 RunBlock(const u8 *entry) override;
+	void AddLinkTarget(u32 em_address, const u8 *entry) override {}
+	void RemoveLinkTarget(u32 em_address) override {}
+	void ClearCache() override;
+	bool IsFull() const override;
+	bool DescribeCodePtr(const u8 *ptr, std::string &name) override {
+		return false;
+	}
+
+private:
+	void Decode(const IRInst &inst, IRThreadedOp &op);
+
+	MIPSState *mips_;
+	std::vector<std::unique_ptr<IRThreadedOp[]>> chunks_;
+	size_t chunkUsed_ = 0;
+};
+
+}  // namespace MIPSComp
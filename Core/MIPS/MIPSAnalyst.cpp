@@ -631,6 +631,34 @@ namespace MIPSAnalyst {
 		return (info & DELAYSLOT) != 0;
 	}
 
+	static bool IsStraightLeafOp(MIPSOpcode op) {
+		// Replacements and such.  Jit blocks were already resolved by Read_Opcode_JIT().
+		if (MIPS_IS_EMUHACK(op.encoding))
+			return false;
+		MIPSInfo info = MIPSGetInfo(op);
+		if ((info & (BAD_INSTRUCTION | IS_CONDBRANCH | IS_JUMP | DELAYSLOT)) != 0)
+			return false;
+		// Syscalls and breaks leave the block, and we need ra intact to return.
+		bool isBreak = (op & 0xFC00003F) == 13;
+		return !IsSyscall(op) && !isBreak && GetOutGPReg(op) != MIPS_REG_RA;
+	}
+
+	u32 GetStraightLeafSize(u32 addr, int maxInstructions) {
+		for (int i = 0; i < maxInstructions; ++i) {
+			u32 pc = addr + i * 4;
+			if (!Memory::IsValidAddress(pc + 4))
+				return 0;
+
+			MIPSOpcode op = Memory::Read_Opcode_JIT(pc);
+			if (op == MIPS_MAKE_JR_RA()) {
+				return IsStraightLeafOp(Memory::Read_Opcode_JIT(pc + 4)) ? (i + 2) * 4 : 0;
+			}
+			if (!IsStraightLeafOp(op))
+				return 0;
+		}
+		return 0;
+	}
+
 	bool OpWouldChangeMemory(u32 pc, u32 addr, u32 size) {
 		const auto op = Memory::Read_Instruction(pc, true);
 
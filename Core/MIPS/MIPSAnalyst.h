@@ -137,6 +137,9 @@ namespace MIPSAnalyst
 	int OpMemoryAccessSize(u32 pc);
 	bool IsOpMemoryWrite(u32 pc);
 	bool OpHasDelaySlot(u32 pc);
+	// Returns the size in bytes (including the delay slot) of a function at addr that has no
+	// branches, calls, or syscalls and ends with jr ra, or 0 if it isn't one or is too long.
+	u32 GetStraightLeafSize(u32 addr, int maxInstructions);
 
 	typedef struct {
 		DebugInterface* cpu;
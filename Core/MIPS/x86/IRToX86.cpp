@@ -1,162 +1,438 @@
 #include "ppsspp_config.h"
-#if PPSSPP_ARCH(X86) || PPSSPP_ARCH(AMD64)
+#if PPSSPP_ARCH(AMD64)
 
+#include <cstring>
+
+#include "Common/ABI.h"
+#include "Common/CPUDetect.h"
+#include "Core/MemMap.h"
+#include "Core/MIPS/MIPS.h"
 #include "Core/MIPS/x86/IRToX86.h"
+#include "Core/MIPS/x86/RegCache.h"
+
+using namespace Gen;
+using namespace X64JitConstants;
 
 namespace MIPSComp {
 
-// Initial attempt at converting IR directly to x86.
-// This is intended to be an easy way to benefit from the IR with the current infrastructure.
-// Later tries may go across multiple blocks and a different representation.
+// Converts optimized IR blocks directly to x86-64.
+// Each block is its own function, entered through a common stub that sets up the context and memory
+// base registers, and it returns the new PC in EAX just like IRInterpret() does.
+// Anything we don't have a native implementation for yet goes through the interpreter one op at a time.
+//
+// The most used MIPS registers are pinned to host registers for all blocks.  The enter stub loads
+// them and the exit stub writes them back, so blocks that link directly to each other never spill them.
 
-struct GPRMapping {
-	Gen::OpArg dest;
-	Gen::OpArg src1;
-	Gen::OpArg src2;
+alignas(16) static const float vec4InitValues[8][4] = {
+	{ 0.0f, 0.0f, 0.0f, 0.0f },
+	{ 1.0f, 1.0f, 1.0f, 1.0f },
+	{ -1.0f, -1.0f, -1.0f, -1.0f },
+	{ 1.0f, 0.0f, 0.0f, 0.0f },
+	{ 0.0f, 1.0f, 0.0f, 0.0f },
+	{ 0.0f, 0.0f, 1.0f, 0.0f },
+	{ 0.0f, 0.0f, 0.0f, 1.0f },
 };
 
-struct FPRMapping {
-	Gen::OpArg dest;
-	Gen::OpArg src1;
-	Gen::OpArg src2;
+alignas(16) static const u32 signBits[4] = {
+	0x80000000, 0x80000000, 0x80000000, 0x80000000,
 };
 
+alignas(16) static const u32 noSignMask[4] = {
+	0x7FFFFFFF, 0x7FFFFFFF, 0x7FFFFFFF, 0x7FFFFFFF,
+};
+
+// CTXREG points at f[0], so GPRs are at negative offsets.
+static inline OpArg CtxGPR(int r) {
+	return MDisp(CTXREG, (r - 32) * 4);
+}
+
+static inline OpArg CtxFPR(int f) {
+	return MDisp(CTXREG, f * 4);
+}
+
+static void IRX86InterpretSingle(u64 packed) {
+	IRInst inst[2]{};
+	memcpy(&inst[0], &packed, sizeof(IRInst));
+	inst[1].op = IROp::ExitToConst;
+	IRInterpret(currentMIPS, inst, 2);
+}
+
+static u32 IRX86InterpretExit(u64 packed) {
+	IRInst inst;
+	memcpy(&inst, &packed, sizeof(IRInst));
+	return IRInterpret(currentMIPS, &inst, 1);
+}
 
-class GreedyRegallocGPR {
-public:
-	GPRMapping Map(IRInst inst, const IRMeta &meta);
+static u64 PackInst(const IRInst &inst) {
+	static_assert(sizeof(IRInst) == sizeof(u64), "IRInst should fit in a register");
+	u64 packed;
+	memcpy(&packed, &inst, sizeof(packed));
+	return packed;
+}
 
-private:
-	
+static bool UsesGPR(const IRInst &inst, int r) {
+	const IRMeta *meta = GetIRMeta(inst.op);
+	if (meta->types[0] == 'G' && inst.dest == r)
+		return true;
+	if (meta->types[0] && meta->types[1] == 'G' && inst.src1 == r)
+		return true;
+	if (meta->types[0] && meta->types[1] && meta->types[2] == 'G' && inst.src2 == r)
+		return true;
+	return false;
+}
+
+// The pinned ones come first, and must be callee saved so calls out of the jit keep them.
+static const X64Reg allocOrder[IRX86_NUM_ALLOC_REGS] = {
+	R12, R13, R15, RBP, RSI, RDI, R8, R9, R10, R11,
 };
 
+// Used until we've seen some code.
+static const u8 defaultPinned[IRX86_NUM_PINNED_REGS] = {
+	MIPS_REG_SP, MIPS_REG_V0, MIPS_REG_A0, MIPS_REG_A1,
+};
 
-GPRMapping GreedyRegallocGPR::Map(IRInst inst, const IRMeta &meta) {
-	GPRMapping mapping;
-	if (meta.types[0] == 'G') {
+bool IRX86RegCache::IsMappable(int r) {
+	return r < 32 || (r >= IRTEMP_0 && r <= IRTEMP_LR_SHIFT);
+}
 
+void IRX86RegCache::Start(XEmitter *emit, const IRInst *instructions, int count, const u8 *pinned) {
+	emit_ = emit;
+	instructions_ = instructions;
+	count_ = count;
+	curInst_ = 0;
+	liveness_.Analyze(instructions, count);
+	for (int i = 0; i < 256; ++i) {
+		slot_[i] = -1;
+	}
+	for (int i = 0; i < IRX86_NUM_ALLOC_REGS; ++i) {
+		host_[i].reg = allocOrder[i];
+		host_[i].mipsReg = -1;
+		host_[i].dirty = false;
+		host_[i].locked = false;
+		if (i < IRX86_NUM_PINNED_REGS) {
+			host_[i].mipsReg = pinned[i];
+			slot_[pinned[i]] = i;
+		}
 	}
-	// etc..
-	return mapping;
 }
 
-// Every 4 registers can also be mapped into an SSE register.
-// When changing from single to vec4 mapping, we'll just flush, for now.
-class GreedyRegallocFPR {
-public:
-	FPRMapping Map(IRInst inst, const IRMeta &meta);
-};
+X64Reg IRX86RegCache::MapReg(int r, int flags) {
+	_dbg_assert_msg_(JIT, IsMappable(r), "Register %d is not a mappable GPR", r);
+
+	int slot = slot_[r];
+	if (slot == -1) {
+		slot = AllocateSlot();
+		host_[slot].mipsReg = r;
+		host_[slot].dirty = false;
+		slot_[r] = slot;
+		if ((flags & MAP_NOINIT) == 0) {
+			emit_->MOV(32, R(host_[slot].reg), CtxGPR(r));
+		}
+	}
+
+	// The zero register is never written by IR, no need to ever store it.
+	if ((flags & MAP_DIRTY) != 0 && r != MIPS_REG_ZERO) {
+		host_[slot].dirty = true;
+	}
+	host_[slot].locked = true;
+	return host_[slot].reg;
+}
+
+OpArg IRX86RegCache::Operand(int r) const {
+	if (IsMapped(r)) {
+		return R(host_[slot_[r]].reg);
+	}
+	return CtxGPR(r);
+}
+
+int IRX86RegCache::NextUse(int r) const {
+	// If it's overwritten before being read, nothing will need the value.
+	if (!liveness_.IsLiveBefore(curInst_, r))
+		return count_ + 2;
+	for (int i = curInst_; i < count_; ++i) {
+		if (UsesGPR(instructions_[i], r))
+			return i - curInst_;
+	}
+	return count_ + 1;
+}
+
+int IRX86RegCache::AllocateSlot() {
+	for (int i = IRX86_NUM_PINNED_REGS; i < IRX86_NUM_ALLOC_REGS; ++i) {
+		if (host_[i].mipsReg == -1)
+			return i;
+	}
+
+	// Evict whatever we'll need again last.
+	int best = -1;
+	int bestDistance = -1;
+	for (int i = IRX86_NUM_PINNED_REGS; i < IRX86_NUM_ALLOC_REGS; ++i) {
+		if (host_[i].locked)
+			continue;
+		int distance = NextUse(host_[i].mipsReg);
+		if (distance > bestDistance) {
+			best = i;
+			bestDistance = distance;
+		}
+	}
+
+	_assert_msg_(JIT, best != -1, "IRX86RegCache: all registers locked");
+	// A dead value doesn't need to be written back.
+	if (!liveness_.IsLiveBefore(curInst_, host_[best].mipsReg))
+		host_[best].dirty = false;
+	Flush(best, true);
+	return best;
+}
+
+void IRX86RegCache::Flush(int slot, bool discard) {
+	HostReg &h = host_[slot];
+	if (h.mipsReg == -1)
+		return;
+	if (h.dirty) {
+		emit_->MOV(32, CtxGPR(h.mipsReg), R(h.reg));
+		h.dirty = false;
+	}
+	if (discard) {
+		slot_[h.mipsReg] = -1;
+		h.mipsReg = -1;
+		h.locked = false;
+	}
+}
+
+void IRX86RegCache::FlushAll(bool discard) {
+	for (int i = 0; i < IRX86_NUM_PINNED_REGS; ++i) {
+		// We don't track whether they're dirty, since a linked block may have changed them.
+		if (discard)
+			emit_->MOV(32, CtxGPR(host_[i].mipsReg), R(host_[i].reg));
+		host_[i].dirty = false;
+	}
+	for (int i = IRX86_NUM_PINNED_REGS; i < IRX86_NUM_ALLOC_REGS; ++i) {
+		// Temps don't survive exits, but stay dirty in case a later op reads them from the context.
+		if (!discard && host_[i].mipsReg != -1 && IRLiveness::IsTemp(host_[i].mipsReg))
+			continue;
+		Flush(i, discard);
+	}
+}
+
+void IRX86RegCache::ReloadPinned() {
+	for (int i = 0; i < IRX86_NUM_PINNED_REGS; ++i) {
+		emit_->MOV(32, R(host_[i].reg), CtxGPR(host_[i].mipsReg));
+	}
+}
+
+void IRX86RegCache::ReleaseSpillLocks() {
+	for (int i = 0; i < IRX86_NUM_ALLOC_REGS; ++i) {
+		host_[i].locked = false;
+	}
+}
+
+IRToX86::IRToX86(MIPSState *mips) : mips_(mips) {
+	AllocCodeSpace(1024 * 1024 * 16);
+	memcpy(pinned_, defaultPinned, sizeof(pinned_));
+	GenerateFixedCode();
+}
+
+void IRToX86::ChoosePinnedRegs() {
+	u32 total = 0;
+	for (int r = 0; r < 32; ++r)
+		total += gprUses_[r];
+	if (total == 0)
+		return;
+
+	// Take the most used ones in the code we're throwing away, it's likely to run again.
+	// Zero is never written, so it's never worth pinning.
+	bool chosen[32]{};
+	chosen[MIPS_REG_ZERO] = true;
+	for (int i = 0; i < IRX86_NUM_PINNED_REGS; ++i) {
+		int best = -1;
+		for (int r = 0; r < 32; ++r) {
+			if (!chosen[r] && (best == -1 || gprUses_[r] > gprUses_[best]))
+				best = r;
+		}
+		pinned_[i] = (u8)best;
+		chosen[best] = true;
+	}
+	memset(gprUses_, 0, sizeof(gprUses_));
+}
+
+void IRToX86::GenerateFixedCode() {
+	BeginWrite();
 
-FPRMapping GreedyRegallocFPR::Map(IRInst inst, const IRMeta &meta) {
-	FPRMapping mapping;
+	enter_ = (EnterFunc)AlignCode16();
+	ABI_PushAllCalleeSavedRegsAndAdjustStack();
+	MOV(64, R(MEMBASEREG), ImmPtr(Memory::base));
+	MOV(PTRBITS, R(CTXREG), ImmPtr(&mips_->f[0]));
+	for (int i = 0; i < IRX86_NUM_PINNED_REGS; ++i) {
+		MOV(32, R(allocOrder[i]), CtxGPR(pinned_[i]));
+	}
+	// Blocks don't return, they jump to exit_ with the new PC in EAX.
+	JMPptr(R(ABI_PARAM1));
+
+	exit_ = AlignCode16();
+	for (int i = 0; i < IRX86_NUM_PINNED_REGS; ++i) {
+		MOV(32, CtxGPR(pinned_[i]), R(allocOrder[i]));
+	}
+	exitNoStore_ = GetCodePtr();
+	ABI_PopAllCalleeSavedRegsAndAdjustStack();
+	RET();
+
+	endOfFixedCode_ = GetCodePtr();
+	EndWrite();
+}
+
+void IRToX86::ClearCache() {
+	ClearCodeSpace(0);
+	linkTargets_.clear();
+	linkSites_.clear();
+	ChoosePinnedRegs();
+	GenerateFixedCode();
+}
+
+bool IRToX86::IsFull() const {
+	return GetSpaceLeft() < 0x10000;
+}
+
+u32 IRToX86::RunBlock(const u8 *entry) {
+	return enter_(entry);
+}
 
-	return mapping;
+void IRToX86::AddLinkTarget(u32 em_address, const u8 *entry) {
+	linkTargets_[em_address] = entry;
+	PatchLinks(em_address, entry);
 }
 
+void IRToX86::RemoveLinkTarget(u32 em_address) {
+	if (linkTargets_.erase(em_address) != 0) {
+		// The sites already have the PC in EAX, so they can just exit.
+		PatchLinks(em_address, exit_);
+	}
+}
+
+void IRToX86::PatchLinks(u32 em_address, const u8 *target) {
+	auto range = linkSites_.equal_range(em_address);
+	for (auto it = range.first; it != range.second; ++it) {
+		u8 *site = it->second;
+		if (PlatformIsWXExclusive()) {
+			ProtectMemoryPages(site, 5, MEM_PROT_READ | MEM_PROT_WRITE);
+		}
+		XEmitter emit(site);
+		emit.JMP(target, true);
+		if (PlatformIsWXExclusive()) {
+			ProtectMemoryPages(site, 5, MEM_PROT_READ | MEM_PROT_EXEC);
+		}
+	}
+}
 
-// This requires that ThreeOpToTwoOp has been run as the last pass.
-void IRToX86::ConvertIRToNative(const IRInst *instructions, int count, const u32 *constants) {
-	// Set up regcaches
-	using namespace Gen;
+bool IRToX86::DescribeCodePtr(const u8 *ptr, std::string &name) {
+	if (ptr == (const u8 *)enter_) {
+		name = "IRToX86 enter";
+	} else if (ptr == exit_ || ptr == exitNoStore_) {
+		name = "IRToX86 exit";
+	} else if (IsInSpace(ptr)) {
+		name = ptr < endOfFixedCode_ ? "IRToX86 fixed code" : "IRToX86 block";
+	} else {
+		return false;
+	}
+	return true;
+}
 
-	GreedyRegallocGPR gprAlloc;
-	GreedyRegallocFPR fprAlloc;
+bool IRToX86::CanCompile(const IRInst *instructions, int count) const {
+	for (int i = 0; i < count; ++i) {
+		const IRInst &inst = instructions[i];
+		const IRMeta *meta = GetIRMeta(inst.op);
+		if (!meta)
+			return false;
 
-	// Loop through all the instructions, emitting code as we go.
-	// Note that we do need to implement them all - fallbacks are not permitted.
-	for (int i = 0; i < count; i++) {
-		const IRInst *inst = &instructions[i];
-		const IRMeta &meta = *GetIRMeta(inst->op);
-		GPRMapping gpr = gprAlloc.Map(*inst, meta);
-		FPRMapping fpr = fprAlloc.Map(*inst, meta);
+		// These may or may not exit, which we can't tell from the outside.  Leave them to the interpreter.
+		if (inst.op == IROp::Breakpoint || inst.op == IROp::MemoryCheck)
+			return false;
 
-		bool symmetric = false;
-		switch (inst->op) {
+		// FPR ops go straight to memory, so they must not alias anything the GPR cache might hold.
+		const u8 regs[3] = { inst.dest, inst.src1, inst.src2 };
+		for (int j = 0; j < 3 && meta->types[j]; ++j) {
+			char type = meta->types[j];
+			int width = type == 'F' ? 1 : (type == '2' ? 2 : (type == 'V' ? 4 : 0));
+			for (int k = 0; k < width; ++k) {
+				if (regs[j] + k + 32 < 256 && IRX86RegCache::IsMappable(regs[j] + k + 32))
+					return false;
+			}
+		}
+	}
+	return true;
+}
+
+const u8 *IRToX86::ConvertIRToNative(const IRInst *instructions, int count) {
+	if (count == 0 || !CanCompile(instructions, count))
+		return nullptr;
+	// Very generous, the worst case is a generic op after all registers are dirty.
+	if (GetSpaceLeft() < 0x1000 + (size_t)count * 256)
+		return nullptr;
+
+	for (int i = 0; i < count; ++i) {
+		const IRInst &inst = instructions[i];
+		const IRMeta *meta = GetIRMeta(inst.op);
+		const u8 regs[3] = { inst.dest, inst.src1, inst.src2 };
+		for (int j = 0; j < 3 && meta->types[j]; ++j) {
+			if (meta->types[j] == 'G' && regs[j] < 32)
+				gprUses_[regs[j]]++;
+		}
+	}
+
+	BeginWrite();
+	const u8 *start = AlignCode16();
+	gpr.Start(this, instructions, count, pinned_);
+
+	for (int i = 0; i < count; ++i) {
+		const IRInst &inst = instructions[i];
+		gpr.SetCurrentInst(i);
+
+		switch (inst.op) {
 		case IROp::Nop:
-			_assert_(false);
 			break;
 
-			// Output-only
 		case IROp::SetConst:
-			code_->MOV(32, gpr.dest, Imm32(constants[inst->src1]));
-			break;
-		case IROp::SetConstF:
-			code_->MOV(32, gpr.dest, Imm32(constants[inst->src1]));
-			break;
-
-			// Add gets to be special cased because we have LEA.
+		case IROp::Mov:
 		case IROp::Add:
-			if (gpr.dest.IsSimpleReg() && gpr.src1.IsSimpleReg() && gpr.src2.IsSimpleReg()) {
-				code_->LEA(32, gpr.dest.GetSimpleReg(), MRegSum(gpr.src1.GetSimpleReg(), gpr.src2.GetSimpleReg()));
-				break;
-			}
-			// Else fall through.
-			// 3-op arithmetic that directly corresponds to x86
-			// (often 2-op in practice if src1 == dst). x86 only does 2-op though so some of these will need splitting.
 		case IROp::Sub:
+		case IROp::Neg:
+		case IROp::Not:
 		case IROp::And:
 		case IROp::Or:
 		case IROp::Xor:
-			if (inst->src1 != inst->dest) {
-				code_->MOV(32, gpr.dest, gpr.src1);
-			}
-			// Emit directly
-			switch (inst->op) {
-			case IROp::Add: code_->ADD(32, gpr.dest, gpr.src2); break;
-			case IROp::Sub: code_->SUB(32, gpr.dest, gpr.src2); break;
-			case IROp::And: code_->AND(32, gpr.dest, gpr.src2); break;
-			case IROp::Or: code_->OR(32, gpr.dest, gpr.src2); break;
-			case IROp::Xor: code_->XOR(32, gpr.dest, gpr.src2); break;
-			}
+		case IROp::AddConst:
+		case IROp::SubConst:
+		case IROp::AndConst:
+		case IROp::OrConst:
+		case IROp::XorConst:
+		case IROp::Ext8to32:
+		case IROp::Ext16to32:
+		case IROp::BSwap16:
+		case IROp::BSwap32:
+		case IROp::Clz:
+			CompIR_Arith(inst);
 			break;
 
-			// Variable shifts.
-		case IROp::Shl:
-		case IROp::Shr:
-		case IROp::Sar:
-		case IROp::Ror:
-
 		case IROp::Slt:
+		case IROp::SltConst:
 		case IROp::SltU:
+		case IROp::SltUConst:
 		case IROp::MovZ:
 		case IROp::MovNZ:
 		case IROp::Max:
 		case IROp::Min:
+			CompIR_Compare(inst);
 			break;
 
-			// 2-op arithmetic with constant
-		case IROp::AddConst:
-		case IROp::SubConst:
-		case IROp::AndConst:
-		case IROp::OrConst:
-		case IROp::XorConst:
-		case IROp::SltConst:
-		case IROp::SltUConst:
-
-			// 2-op arithmetic with immediate
+		case IROp::Shl:
+		case IROp::Shr:
+		case IROp::Sar:
+		case IROp::Ror:
 		case IROp::ShlImm:
 		case IROp::ShrImm:
 		case IROp::SarImm:
 		case IROp::RorImm:
-
-			// 2-op arithmetic
-		case IROp::Mov:
-			code_->MOV(32, gpr.dest, gpr.src1);
+			CompIR_Shift(inst);
 			break;
 
-		case IROp::Neg:
-		case IROp::Not:
-		case IROp::Ext8to32:
-		case IROp::Ext16to32:
-		case IROp::ReverseBits:
-		case IROp::BSwap16:
-		case IROp::BSwap32:
-		case IROp::Clz:
-			if (inst->dest != inst->src1) {
-				code_->NEG(32, gpr.dest); break;
-			}
-			break;
-				// Multiplier control
 		case IROp::MtLo:
 		case IROp::MtHi:
 		case IROp::MfLo:
@@ -167,108 +443,65 @@ void IRToX86::ConvertIRToNative(const IRInst *instructions, int count, const u32
 		case IROp::MaddU:
 		case IROp::Msub:
 		case IROp::MsubU:
-		case IROp::Div:
-		case IROp::DivU:
+			CompIR_HiLo(inst);
+			break;
 
-			// Memory access
 		case IROp::Load8:
 		case IROp::Load8Ext:
 		case IROp::Load16:
 		case IROp::Load16Ext:
 		case IROp::Load32:
 		case IROp::LoadFloat:
+		case IROp::LoadVec4:
+			CompIR_Load(inst);
+			break;
+
 		case IROp::Store8:
 		case IROp::Store16:
 		case IROp::Store32:
 		case IROp::StoreFloat:
-		case IROp::LoadVec4:
 		case IROp::StoreVec4:
-
-			// Output-only SIMD functions
-		case IROp::Vec4Init:
-		case IROp::Vec4Shuffle:
-
-			// 2-op SIMD functions
-		case IROp::Vec4Mov:
-			code_->MOVAPS(fpr.dest.GetSimpleReg(), fpr.src1);
+			CompIR_Store(inst);
 			break;
-		case IROp::Vec4Neg:
-		case IROp::Vec4Abs:
-			break;
-		case IROp::Vec4ClampToZero:
-			code_->PXOR(XMM0, R(XMM0));
-			code_->PMAXSW(XMM0, fpr.src1);
-			code_->MOVAPD(fpr.dest, XMM0);
-			break;
-		case IROp::Vec4DuplicateUpperBitsAndShift1:
-		case IROp::Vec2ClampToZero:
-
-			// 3-op SIMD functions
-		case IROp::Vec4Add:
-		case IROp::Vec4Sub:
-		case IROp::Vec4Mul:
-		case IROp::Vec4Div:
-
-		case IROp::Vec4Scale:
-		case IROp::Vec4Dot:
 
-			// Pack-unpack
-		case IROp::Vec2Unpack16To31:
-		case IROp::Vec2Unpack16To32:
-		case IROp::Vec4Unpack8To32:
-		case IROp::Vec2Pack32To16:
-		case IROp::Vec2Pack31To16:
-		case IROp::Vec4Pack32To8:
-		case IROp::Vec4Pack31To8:
-
-		case IROp::FCmpVfpuBit:
-		case IROp::FCmpVfpuAggregate:
-		case IROp::FCmovVfpuCC:
-
-			// Trancendental functions (non-simd)
-		case IROp::FSin:
-		case IROp::FCos:
-		case IROp::FRSqrt:
-		case IROp::FRecip:
-		case IROp::FAsin:
-
-			// 3-Op FP
+		case IROp::SetConstF:
 		case IROp::FAdd:
 		case IROp::FSub:
 		case IROp::FMul:
 		case IROp::FDiv:
 		case IROp::FMin:
 		case IROp::FMax:
-
-			// 2-Op FP
 		case IROp::FMov:
-		case IROp::FAbs:
 		case IROp::FSqrt:
 		case IROp::FNeg:
-		case IROp::FSat0_1:
-		case IROp::FSatMinus1_1:
-		case IROp::FSign:
-		case IROp::FCeil:
-		case IROp::FFloor:
-		case IROp::FCmp:
+		case IROp::FAbs:
 		case IROp::FCvtSW:
-		case IROp::FCvtWS:
-		case IROp::FRound:
-		case IROp::FTrunc:
-
-			// Cross moves
 		case IROp::FMovFromGPR:
 		case IROp::FMovToGPR:
 		case IROp::FpCondToReg:
 		case IROp::VfpuCtrlToReg:
-
-			// VFPU flag/control
+		case IROp::ZeroFpCond:
 		case IROp::SetCtrlVFPU:
 		case IROp::SetCtrlVFPUReg:
 		case IROp::SetCtrlVFPUFReg:
-		case IROp::ZeroFpCond:
+			CompIR_FPU(inst);
+			break;
+
+		case IROp::Vec4Init:
+		case IROp::Vec4Shuffle:
+		case IROp::Vec4Mov:
+		case IROp::Vec4Add:
+		case IROp::Vec4Sub:
+		case IROp::Vec4Mul:
+		case IROp::Vec4Div:
+		case IROp::Vec4Scale:
+		case IROp::Vec4Dot:
+		case IROp::Vec4Neg:
+		case IROp::Vec4Abs:
+		case IROp::Vec4ClampToZero:
+			CompIR_Vec4(inst);
+			break;
 
-			// Block Exits
 		case IROp::ExitToConst:
 		case IROp::ExitToReg:
 		case IROp::ExitToConstIfEq:
@@ -278,22 +511,716 @@ void IRToX86::ConvertIRToNative(const IRInst *instructions, int count, const u32
 		case IROp::ExitToConstIfLtZ:
 		case IROp::ExitToConstIfLeZ:
 		case IROp::ExitToPC:
-
-			// Utilities
 		case IROp::Downcount:
 		case IROp::SetPC:
 		case IROp::SetPCConst:
+			CompIR_Exit(inst);
+			break;
+
+		case IROp::ApplyRoundingMode:
+		case IROp::RestoreRoundingMode:
+		case IROp::UpdateRoundingMode:
+			// Not implemented by the interpreter either.
+			break;
+
 		case IROp::Syscall:
-		case IROp::Interpret:  // SLOW fallback. Can be made faster.
-		case IROp::CallReplacement:
-		case IROp::Break:
-		default:
+			// Flagged as an exit, but always followed by ExitToPC.
+			CompIR_Generic(inst);
 			break;
+
+		default:
+			if (GetIRMeta(inst.op)->flags & IRFLAG_EXIT) {
+				CompIR_GenericExit(inst);
+			} else {
+				CompIR_Generic(inst);
 			}
+			break;
+		}
+
+		gpr.ReleaseSpillLocks();
+	}
+
+	// IR blocks always end with an exit, so this should be unreachable.
+	INT3();
+	EndWrite();
+	return start;
+}
+
+void IRToX86::WriteExit(const OpArg &newPC) {
+	MOV(32, R(EAX), newPC);
+	JMP(exit_, true);
+}
+
+void IRToX86::WriteConstExit(u32 newPC) {
+	MOV(32, R(EAX), Imm32(newPC));
+	// Like the loop in IRJit::RunLoopUntil(), only keep going while there's downcount left.
+	CMP(32, MIPSSTATE_VAR(downcount), Imm8(0));
+	J_CC(CC_L, exit_, true);
+
+	// This gets patched as blocks come and go, so it has to stay a 5 byte jump.
+	u8 *site = GetWritableCodePtr();
+	auto target = linkTargets_.find(newPC);
+	JMP(target != linkTargets_.end() ? target->second : exit_, true);
+	linkSites_.insert(std::make_pair(newPC, site));
+}
+
+void IRToX86::CompIR_Generic(const IRInst &inst) {
+	// The interpreter works on the context directly.
+	gpr.FlushAll(true);
+	MOV(64, R(ABI_PARAM1), Imm64(PackInst(inst)));
+	ABI_CallFunction((const void *)&IRX86InterpretSingle);
+	// It may have changed any of them, for example a syscall switching threads.
+	gpr.ReloadPinned();
+}
+
+void IRToX86::CompIR_GenericExit(const IRInst &inst) {
+	gpr.FlushAll(true);
+	MOV(64, R(ABI_PARAM1), Imm64(PackInst(inst)));
+	ABI_CallFunction((const void *)&IRX86InterpretExit);
+	JMP(exitNoStore_, true);
+}
+
+void IRToX86::CompIR_Arith(const IRInst &inst) {
+	if (inst.op == IROp::SetConst) {
+		X64Reg d = gpr.MapReg(inst.dest, IRX86RegCache::MAP_NOINIT | IRX86RegCache::MAP_DIRTY);
+		MOV(32, R(d), Imm32(inst.constant));
+		return;
+	}
+
+	X64Reg s1 = gpr.MapReg(inst.src1);
+	bool threeOp = inst.op == IROp::Add || inst.op == IROp::Sub || inst.op == IROp::And || inst.op == IROp::Or || inst.op == IROp::Xor;
+	X64Reg s2 = threeOp ? gpr.MapReg(inst.src2) : INVALID_REG;
+	X64Reg d = gpr.MapReg(inst.dest, IRX86RegCache::MAP_NOINIT | IRX86RegCache::MAP_DIRTY);
+
+	switch (inst.op) {
+	case IROp::Mov:
+		if (d != s1)
+			MOV(32, R(d), R(s1));
+		break;
+
+	case IROp::Add:
+		if (d == s1) {
+			ADD(32, R(d), R(s2));
+		} else if (d == s2) {
+			ADD(32, R(d), R(s1));
+		} else {
+			LEA(32, d, MRegSum(s1, s2));
+		}
+		break;
+
+	case IROp::Sub:
+		if (d == s1) {
+			SUB(32, R(d), R(s2));
+		} else if (d == s2) {
+			MOV(32, R(EAX), R(s1));
+			SUB(32, R(EAX), R(s2));
+			MOV(32, R(d), R(EAX));
+		} else {
+			MOV(32, R(d), R(s1));
+			SUB(32, R(d), R(s2));
+		}
+		break;
+
+	case IROp::And:
+	case IROp::Or:
+	case IROp::Xor:
+	{
+		// All of these are commutative.
+		X64Reg other = d == s1 ? s2 : s1;
+		if (d != s1 && d != s2)
+			MOV(32, R(d), R(s1));
+		if (inst.op == IROp::And)
+			AND(32, R(d), R(other));
+		else if (inst.op == IROp::Or)
+			OR(32, R(d), R(other));
+		else
+			XOR(32, R(d), R(other));
+		break;
+	}
+
+	case IROp::AddConst:
+		if (d == s1) {
+			ADD(32, R(d), Imm32(inst.constant));
+		} else {
+			LEA(32, d, MDisp(s1, (int)inst.constant));
+		}
+		break;
+
+	case IROp::SubConst:
+		if (d != s1)
+			MOV(32, R(d), R(s1));
+		SUB(32, R(d), Imm32(inst.constant));
+		break;
+
+	case IROp::AndConst:
+		if (d != s1)
+			MOV(32, R(d), R(s1));
+		AND(32, R(d), Imm32(inst.constant));
+		break;
+
+	case IROp::OrConst:
+		if (d != s1)
+			MOV(32, R(d), R(s1));
+		OR(32, R(d), Imm32(inst.constant));
+		break;
+
+	case IROp::XorConst:
+		if (d != s1)
+			MOV(32, R(d), R(s1));
+		XOR(32, R(d), Imm32(inst.constant));
+		break;
+
+	case IROp::Neg:
+		if (d != s1)
+			MOV(32, R(d), R(s1));
+		NEG(32, R(d));
+		break;
+
+	case IROp::Not:
+		if (d != s1)
+			MOV(32, R(d), R(s1));
+		NOT(32, R(d));
+		break;
+
+	case IROp::Ext8to32:
+		MOVSX(32, 8, d, R(s1));
+		break;
+
+	case IROp::Ext16to32:
+		MOVSX(32, 16, d, R(s1));
+		break;
+
+	case IROp::BSwap16:
+		if (d != s1)
+			MOV(32, R(d), R(s1));
+		BSWAP(32, d);
+		ROL(32, R(d), Imm8(16));
+		break;
+
+	case IROp::BSwap32:
+		if (d != s1)
+			MOV(32, R(d), R(s1));
+		BSWAP(32, d);
+		break;
+
+	case IROp::Clz:
+		if (cpu_info.bLZCNT) {
+			LZCNT(32, d, R(s1));
+		} else {
+			BSR(32, EAX, R(s1));
+			FixupBranch notFound = J_CC(CC_Z);
+			XOR(32, R(EAX), Imm8(31));
+			FixupBranch done = J();
+			SetJumpTarget(notFound);
+			MOV(32, R(EAX), Imm32(32));
+			SetJumpTarget(done);
+			MOV(32, R(d), R(EAX));
 		}
+		break;
+
+	default:
+		_assert_msg_(JIT, false, "CompIR_Arith: unexpected op");
+		break;
 	}
+}
+
+void IRToX86::CompIR_Compare(const IRInst &inst) {
+	switch (inst.op) {
+	case IROp::Slt:
+	case IROp::SltU:
+	case IROp::SltConst:
+	case IROp::SltUConst:
+	{
+		bool useConst = inst.op == IROp::SltConst || inst.op == IROp::SltUConst;
+		X64Reg s1 = gpr.MapReg(inst.src1);
+		X64Reg s2 = useConst ? INVALID_REG : gpr.MapReg(inst.src2);
+		X64Reg d = gpr.MapReg(inst.dest, IRX86RegCache::MAP_NOINIT | IRX86RegCache::MAP_DIRTY);
+		bool isSigned = inst.op == IROp::Slt || inst.op == IROp::SltConst;
 
+		XOR(32, R(EAX), R(EAX));
+		CMP(32, R(s1), useConst ? Imm32(inst.constant) : R(s2));
+		SETcc(isSigned ? CC_L : CC_B, R(EAX));
+		MOV(32, R(d), R(EAX));
+		break;
+	}
+
+	case IROp::MovZ:
+	case IROp::MovNZ:
+	{
+		X64Reg s1 = gpr.MapReg(inst.src1);
+		X64Reg s2 = gpr.MapReg(inst.src2);
+		// Keeps its old value if the condition fails, so must be loaded.
+		X64Reg d = gpr.MapReg(inst.dest, IRX86RegCache::MAP_DIRTY);
+		TEST(32, R(s1), R(s1));
+		CMOVcc(32, d, R(s2), inst.op == IROp::MovZ ? CC_Z : CC_NZ);
+		break;
+	}
+
+	case IROp::Max:
+	case IROp::Min:
+	{
+		X64Reg s1 = gpr.MapReg(inst.src1);
+		X64Reg s2 = gpr.MapReg(inst.src2);
+		X64Reg d = gpr.MapReg(inst.dest, IRX86RegCache::MAP_NOINIT | IRX86RegCache::MAP_DIRTY);
+		MOV(32, R(EAX), R(s1));
+		CMP(32, R(s1), R(s2));
+		CMOVcc(32, EAX, R(s2), inst.op == IROp::Max ? CC_L : CC_G);
+		MOV(32, R(d), R(EAX));
+		break;
+	}
+
+	default:
+		_assert_msg_(JIT, false, "CompIR_Compare: unexpected op");
+		break;
+	}
+}
+
+void IRToX86::CompIR_Shift(const IRInst &inst) {
+	X64Reg s1 = gpr.MapReg(inst.src1);
+
+	switch (inst.op) {
+	case IROp::ShlImm:
+	case IROp::ShrImm:
+	case IROp::SarImm:
+	case IROp::RorImm:
+	{
+		X64Reg d = gpr.MapReg(inst.dest, IRX86RegCache::MAP_NOINIT | IRX86RegCache::MAP_DIRTY);
+		if (d != s1)
+			MOV(32, R(d), R(s1));
+		OpArg sa = Imm8(inst.src2);
+		if (inst.op == IROp::ShlImm)
+			SHL(32, R(d), sa);
+		else if (inst.op == IROp::ShrImm)
+			SHR(32, R(d), sa);
+		else if (inst.op == IROp::SarImm)
+			SAR(32, R(d), sa);
+		else
+			ROR(32, R(d), sa);
+		break;
+	}
+
+	case IROp::Shl:
+	case IROp::Shr:
+	case IROp::Sar:
+	case IROp::Ror:
+	{
+		// x86 masks the shift amount by 31 just like MIPS does.
+		X64Reg s2 = gpr.MapReg(inst.src2);
+		X64Reg d = gpr.MapReg(inst.dest, IRX86RegCache::MAP_NOINIT | IRX86RegCache::MAP_DIRTY);
+		MOV(32, R(ECX), R(s2));
+		MOV(32, R(EAX), R(s1));
+		if (inst.op == IROp::Shl)
+			SHL(32, R(EAX), R(CL));
+		else if (inst.op == IROp::Shr)
+			SHR(32, R(EAX), R(CL));
+		else if (inst.op == IROp::Sar)
+			SAR(32, R(EAX), R(CL));
+		else
+			ROR(32, R(EAX), R(CL));
+		MOV(32, R(d), R(EAX));
+		break;
+	}
+
+	default:
+		_assert_msg_(JIT, false, "CompIR_Shift: unexpected op");
+		break;
+	}
+}
+
+void IRToX86::CompIR_HiLo(const IRInst &inst) {
+	// LO and HI are never cached, so we can just work on them in memory.
+	switch (inst.op) {
+	case IROp::MtLo:
+		MOV(32, MIPSSTATE_VAR(lo), R(gpr.MapReg(inst.src1)));
+		break;
+	case IROp::MtHi:
+		MOV(32, MIPSSTATE_VAR(hi), R(gpr.MapReg(inst.src1)));
+		break;
+	case IROp::MfLo:
+		MOV(32, R(gpr.MapReg(inst.dest, IRX86RegCache::MAP_NOINIT | IRX86RegCache::MAP_DIRTY)), MIPSSTATE_VAR(lo));
+		break;
+	case IROp::MfHi:
+		MOV(32, R(gpr.MapReg(inst.dest, IRX86RegCache::MAP_NOINIT | IRX86RegCache::MAP_DIRTY)), MIPSSTATE_VAR(hi));
+		break;
+
+	case IROp::Mult:
+	case IROp::MultU:
+	{
+		X64Reg s1 = gpr.MapReg(inst.src1);
+		X64Reg s2 = gpr.MapReg(inst.src2);
+		MOV(32, R(EAX), R(s1));
+		if (inst.op == IROp::Mult)
+			IMUL(32, R(s2));
+		else
+			MUL(32, R(s2));
+		MOV(32, MIPSSTATE_VAR(lo), R(EAX));
+		MOV(32, MIPSSTATE_VAR(hi), R(EDX));
+		break;
+	}
+
+	case IROp::Madd:
+	case IROp::MaddU:
+	case IROp::Msub:
+	case IROp::MsubU:
+	{
+		X64Reg s1 = gpr.MapReg(inst.src1);
+		X64Reg s2 = gpr.MapReg(inst.src2);
+		if (inst.op == IROp::Madd || inst.op == IROp::Msub) {
+			MOVSX(64, 32, RAX, R(s1));
+			MOVSX(64, 32, RDX, R(s2));
+		} else {
+			// 32-bit moves zero extend, and the low 64 bits of a signed multiply are the same.
+			MOV(32, R(EAX), R(s1));
+			MOV(32, R(EDX), R(s2));
+		}
+		IMUL(64, RAX, R(RDX));
+		// lo and hi are adjacent, lo first.
+		if (inst.op == IROp::Madd || inst.op == IROp::MaddU)
+			ADD(64, MIPSSTATE_VAR(lo), R(RAX));
+		else
+			SUB(64, MIPSSTATE_VAR(lo), R(RAX));
+		break;
+	}
+
+	default:
+		_assert_msg_(JIT, false, "CompIR_HiLo: unexpected op");
+		break;
+	}
+}
+
+OpArg IRToX86::PrepareMemAddress(const IRInst &inst) {
+	// Compute in 32 bits so wraparound matches the interpreter.
+	if (inst.src1 == MIPS_REG_ZERO) {
+		MOV(32, R(EAX), Imm32(inst.constant));
+	} else {
+		X64Reg base = gpr.MapReg(inst.src1);
+		if (inst.constant == 0)
+			MOV(32, R(EAX), R(base));
+		else
+			LEA(32, EAX, MDisp(base, (int)inst.constant));
+	}
+#ifdef MASKED_PSP_MEMORY
+	AND(32, R(EAX), Imm32(Memory::MEMVIEW32_MASK));
+#endif
+	return MComplex(MEMBASEREG, RAX, SCALE_1, 0);
+}
+
+void IRToX86::CompIR_Load(const IRInst &inst) {
+	OpArg src = PrepareMemAddress(inst);
+
+	switch (inst.op) {
+	case IROp::Load8:
+		MOVZX(32, 8, gpr.MapReg(inst.dest, IRX86RegCache::MAP_NOINIT | IRX86RegCache::MAP_DIRTY), src);
+		break;
+	case IROp::Load8Ext:
+		MOVSX(32, 8, gpr.MapReg(inst.dest, IRX86RegCache::MAP_NOINIT | IRX86RegCache::MAP_DIRTY), src);
+		break;
+	case IROp::Load16:
+		MOVZX(32, 16, gpr.MapReg(inst.dest, IRX86RegCache::MAP_NOINIT | IRX86RegCache::MAP_DIRTY), src);
+		break;
+	case IROp::Load16Ext:
+		MOVSX(32, 16, gpr.MapReg(inst.dest, IRX86RegCache::MAP_NOINIT | IRX86RegCache::MAP_DIRTY), src);
+		break;
+	case IROp::Load32:
+		MOV(32, R(gpr.MapReg(inst.dest, IRX86RegCache::MAP_NOINIT | IRX86RegCache::MAP_DIRTY)), src);
+		break;
+	case IROp::LoadFloat:
+		MOVSS(XMM0, src);
+		MOVSS(CtxFPR(inst.dest), XMM0);
+		break;
+	case IROp::LoadVec4:
+		MOVUPS(XMM0, src);
+		MOVAPS(CtxFPR(inst.dest), XMM0);
+		break;
+	default:
+		_assert_msg_(JIT, false, "CompIR_Load: unexpected op");
+		break;
+	}
+}
+
+void IRToX86::CompIR_Store(const IRInst &inst) {
+	X64Reg value = INVALID_REG;
+	if (inst.op != IROp::StoreFloat && inst.op != IROp::StoreVec4)
+		value = gpr.MapReg(inst.src3);
+	OpArg dest = PrepareMemAddress(inst);
+
+	switch (inst.op) {
+	case IROp::Store8:
+		MOV(8, dest, R(value));
+		break;
+	case IROp::Store16:
+		MOV(16, dest, R(value));
+		break;
+	case IROp::Store32:
+		MOV(32, dest, R(value));
+		break;
+	case IROp::StoreFloat:
+		MOVSS(XMM0, CtxFPR(inst.src3));
+		MOVSS(dest, XMM0);
+		break;
+	case IROp::StoreVec4:
+		MOVAPS(XMM0, CtxFPR(inst.src3));
+		MOVUPS(dest, XMM0);
+		break;
+	default:
+		_assert_msg_(JIT, false, "CompIR_Store: unexpected op");
+		break;
+	}
+}
+
+void IRToX86::CompIR_FPU(const IRInst &inst) {
+	switch (inst.op) {
+	case IROp::SetConstF:
+		MOV(32, CtxFPR(inst.dest), Imm32(inst.constant));
+		break;
+
+	case IROp::FAdd:
+	case IROp::FSub:
+	case IROp::FMul:
+	case IROp::FDiv:
+		MOVSS(XMM0, CtxFPR(inst.src1));
+		if (inst.op == IROp::FAdd)
+			ADDSS(XMM0, CtxFPR(inst.src2));
+		else if (inst.op == IROp::FSub)
+			SUBSS(XMM0, CtxFPR(inst.src2));
+		else if (inst.op == IROp::FMul)
+			MULSS(XMM0, CtxFPR(inst.src2));
+		else
+			DIVSS(XMM0, CtxFPR(inst.src2));
+		MOVSS(CtxFPR(inst.dest), XMM0);
+		break;
+
+	case IROp::FMin:
+	case IROp::FMax:
+		// Operand order picked to match std::min/std::max with NANs: src2 < src1 ? src2 : src1.
+		MOVSS(XMM0, CtxFPR(inst.src2));
+		if (inst.op == IROp::FMin)
+			MINSS(XMM0, CtxFPR(inst.src1));
+		else
+			MAXSS(XMM0, CtxFPR(inst.src1));
+		MOVSS(CtxFPR(inst.dest), XMM0);
+		break;
+
+	case IROp::FMov:
+		MOV(32, R(EAX), CtxFPR(inst.src1));
+		MOV(32, CtxFPR(inst.dest), R(EAX));
+		break;
+
+	case IROp::FNeg:
+		MOV(32, R(EAX), CtxFPR(inst.src1));
+		XOR(32, R(EAX), Imm32(0x80000000));
+		MOV(32, CtxFPR(inst.dest), R(EAX));
+		break;
+
+	case IROp::FAbs:
+		MOV(32, R(EAX), CtxFPR(inst.src1));
+		AND(32, R(EAX), Imm32(0x7FFFFFFF));
+		MOV(32, CtxFPR(inst.dest), R(EAX));
+		break;
+
+	case IROp::FSqrt:
+		SQRTSS(XMM0, CtxFPR(inst.src1));
+		MOVSS(CtxFPR(inst.dest), XMM0);
+		break;
+
+	case IROp::FCvtSW:
+		CVTSI2SS(XMM0, CtxFPR(inst.src1));
+		MOVSS(CtxFPR(inst.dest), XMM0);
+		break;
+
+	case IROp::FMovFromGPR:
+		MOV(32, CtxFPR(inst.dest), R(gpr.MapReg(inst.src1)));
+		break;
+
+	case IROp::FMovToGPR:
+		MOV(32, R(gpr.MapReg(inst.dest, IRX86RegCache::MAP_NOINIT | IRX86RegCache::MAP_DIRTY)), CtxFPR(inst.src1));
+		break;
+
+	case IROp::FpCondToReg:
+		MOV(32, R(gpr.MapReg(inst.dest, IRX86RegCache::MAP_NOINIT | IRX86RegCache::MAP_DIRTY)), MIPSSTATE_VAR(fpcond));
+		break;
+
+	case IROp::VfpuCtrlToReg:
+		MOV(32, R(gpr.MapReg(inst.dest, IRX86RegCache::MAP_NOINIT | IRX86RegCache::MAP_DIRTY)), MIPSSTATE_VAR_ELEM32(vfpuCtrl[0], inst.src1));
+		break;
+
+	case IROp::ZeroFpCond:
+		MOV(32, MIPSSTATE_VAR(fpcond), Imm32(0));
+		break;
+
+	case IROp::SetCtrlVFPU:
+		MOV(32, MIPSSTATE_VAR_ELEM32(vfpuCtrl[0], inst.dest), Imm32(inst.constant));
+		break;
+
+	case IROp::SetCtrlVFPUReg:
+		MOV(32, MIPSSTATE_VAR_ELEM32(vfpuCtrl[0], inst.dest), R(gpr.MapReg(inst.src1)));
+		break;
+
+	case IROp::SetCtrlVFPUFReg:
+		MOV(32, R(EAX), CtxFPR(inst.src1));
+		MOV(32, MIPSSTATE_VAR_ELEM32(vfpuCtrl[0], inst.dest), R(EAX));
+		break;
+
+	default:
+		_assert_msg_(JIT, false, "CompIR_FPU: unexpected op");
+		break;
+	}
+}
+
+void IRToX86::CompIR_Vec4(const IRInst &inst) {
+	switch (inst.op) {
+	case IROp::Vec4Init:
+		MOV(PTRBITS, R(RAX), ImmPtr(vec4InitValues[inst.src1]));
+		MOVAPS(XMM0, MatR(RAX));
+		MOVAPS(CtxFPR(inst.dest), XMM0);
+		break;
+
+	case IROp::Vec4Shuffle:
+		MOVAPS(XMM0, CtxFPR(inst.src1));
+		SHUFPS(XMM0, R(XMM0), inst.src2);
+		MOVAPS(CtxFPR(inst.dest), XMM0);
+		break;
+
+	case IROp::Vec4Mov:
+		MOVAPS(XMM0, CtxFPR(inst.src1));
+		MOVAPS(CtxFPR(inst.dest), XMM0);
+		break;
+
+	case IROp::Vec4Add:
+	case IROp::Vec4Sub:
+	case IROp::Vec4Mul:
+	case IROp::Vec4Div:
+		MOVAPS(XMM0, CtxFPR(inst.src1));
+		if (inst.op == IROp::Vec4Add)
+			ADDPS(XMM0, CtxFPR(inst.src2));
+		else if (inst.op == IROp::Vec4Sub)
+			SUBPS(XMM0, CtxFPR(inst.src2));
+		else if (inst.op == IROp::Vec4Mul)
+			MULPS(XMM0, CtxFPR(inst.src2));
+		else
+			DIVPS(XMM0, CtxFPR(inst.src2));
+		MOVAPS(CtxFPR(inst.dest), XMM0);
+		break;
+
+	case IROp::Vec4Scale:
+		MOVSS(XMM1, CtxFPR(inst.src2));
+		SHUFPS(XMM1, R(XMM1), 0);
+		MOVAPS(XMM0, CtxFPR(inst.src1));
+		MULPS(XMM0, R(XMM1));
+		MOVAPS(CtxFPR(inst.dest), XMM0);
+		break;
+
+	case IROp::Vec4Dot:
+		// Scalar, to add in the same order as the interpreter.
+		MOVSS(XMM0, CtxFPR(inst.src1));
+		MULSS(XMM0, CtxFPR(inst.src2));
+		for (int i = 1; i < 4; ++i) {
+			MOVSS(XMM1, CtxFPR(inst.src1 + i));
+			MULSS(XMM1, CtxFPR(inst.src2 + i));
+			ADDSS(XMM0, R(XMM1));
+		}
+		MOVSS(CtxFPR(inst.dest), XMM0);
+		break;
+
+	case IROp::Vec4Neg:
+	case IROp::Vec4Abs:
+		MOV(PTRBITS, R(RAX), ImmPtr(inst.op == IROp::Vec4Neg ? signBits : noSignMask));
+		MOVAPS(XMM0, CtxFPR(inst.src1));
+		if (inst.op == IROp::Vec4Neg)
+			XORPS(XMM0, MatR(RAX));
+		else
+			ANDPS(XMM0, MatR(RAX));
+		MOVAPS(CtxFPR(inst.dest), XMM0);
+		break;
+
+	case IROp::Vec4ClampToZero:
+		// Expand the sign bit, and use andnot to zero negative values.
+		MOVAPS(XMM0, CtxFPR(inst.src1));
+		MOVAPS(XMM1, R(XMM0));
+		PSRAD(XMM1, 31);
+		PANDN(XMM1, R(XMM0));
+		MOVAPS(CtxFPR(inst.dest), XMM1);
+		break;
+
+	default:
+		_assert_msg_(JIT, false, "CompIR_Vec4: unexpected op");
+		break;
+	}
+}
+
+void IRToX86::CompIR_Exit(const IRInst &inst) {
+	switch (inst.op) {
+	case IROp::Downcount:
+		SUB(32, MIPSSTATE_VAR(downcount), Imm32(inst.constant));
+		break;
+
+	case IROp::SetPC:
+		MOV(32, MIPSSTATE_VAR(pc), R(gpr.MapReg(inst.src1)));
+		break;
+
+	case IROp::SetPCConst:
+		MOV(32, MIPSSTATE_VAR(pc), Imm32(inst.constant));
+		break;
+
+	case IROp::ExitToConst:
+		gpr.FlushAll(false);
+		WriteConstExit(inst.constant);
+		break;
+
+	case IROp::ExitToReg:
+	{
+		X64Reg src = gpr.MapReg(inst.src1);
+		gpr.FlushAll(false);
+		WriteExit(R(src));
+		break;
+	}
+
+	case IROp::ExitToPC:
+		gpr.FlushAll(false);
+		WriteExit(MIPSSTATE_VAR(pc));
+		break;
+
+	case IROp::ExitToConstIfEq:
+	case IROp::ExitToConstIfNeq:
+	{
+		X64Reg s1 = gpr.MapReg(inst.src1);
+		X64Reg s2 = gpr.MapReg(inst.src2);
+		// Write back, but keep everything mapped for the fall through path.
+		gpr.FlushAll(false);
+		CMP(32, R(s1), R(s2));
+		FixupBranch skip = J_CC(inst.op == IROp::ExitToConstIfEq ? CC_NE : CC_E);
+		WriteConstExit(inst.constant);
+		SetJumpTarget(skip);
+		break;
+	}
+
+	case IROp::ExitToConstIfGtZ:
+	case IROp::ExitToConstIfGeZ:
+	case IROp::ExitToConstIfLtZ:
+	case IROp::ExitToConstIfLeZ:
+	{
+		X64Reg s1 = gpr.MapReg(inst.src1);
+		gpr.FlushAll(false);
+		CMP(32, R(s1), Imm32(0));
+		CCFlags skipCC;
+		switch (inst.op) {
+		case IROp::ExitToConstIfGtZ: skipCC = CC_LE; break;
+		case IROp::ExitToConstIfGeZ: skipCC = CC_L; break;
+		case IROp::ExitToConstIfLtZ: skipCC = CC_GE; break;
+		default: skipCC = CC_G; break;
+		}
+		FixupBranch skip = J_CC(skipCC);
+		WriteConstExit(inst.constant);
+		SetJumpTarget(skip);
+		break;
+	}
+
+	default:
+		_assert_msg_(JIT, false, "CompIR_Exit: unexpected op");
+		break;
+	}
+}
 
 }  // namespace
 
-#endif // PPSSPP_ARCH(X86) || PPSSPP_ARCH(AMD64)
+#endif // PPSSPP_ARCH(AMD64)
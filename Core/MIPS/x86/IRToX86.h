@@ -1,23 +1,124 @@
-#include "Core/MIPS/IR/IRInst.h"
+#pragma once
+
+#include <string>
+#include <unordered_map>
+
 #include "Common/x64Emitter.h"
+#include "Core/MIPS/IR/IRInst.h"
+#include "Core/MIPS/IR/IRJit.h"
+#include "Core/MIPS/IR/IRRegCache.h"
 
 namespace MIPSComp {
 
-class IRToNativeInterface {
+enum {
+	IRX86_NUM_ALLOC_REGS = 10,
+	// The first host registers hold the same MIPS registers in every block, see IRToX86.
+	IRX86_NUM_PINNED_REGS = 4,
+};
+
+// Greedy per-block allocator for IR GPRs. Values are loaded on first use and written back at exits and
+// around calls. When we run out of registers, we evict the one whose next use is the furthest away.
+// Pinned registers are never written back at exits, they stay in host registers across linked blocks.
+class IRX86RegCache {
 public:
-	virtual ~IRToNativeInterface() {}
+	enum {
+		MAP_NOINIT = 1,
+		MAP_DIRTY = 2,
+	};
 
-	virtual void ConvertIRToNative(const IRInst *instructions, int count, const u32 *constants) = 0;
-};
+	void Start(Gen::XEmitter *emit, const IRInst *instructions, int count, const u8 *pinned);
+	void SetCurrentInst(int i) {
+		curInst_ = i;
+	}
+
+	static bool IsMappable(int r);
+
+	Gen::X64Reg MapReg(int r, int flags = 0);
+	// Returns the host register if mapped, or else the context memory location.
+	Gen::OpArg Operand(int r) const;
+	bool IsMapped(int r) const {
+		return IsMappable(r) && slot_[r] != -1;
+	}
 
+	// Without discard, this is for exits: pinned registers and temps aren't written back.
+	// With discard, everything is written back, and pinned registers must be reloaded afterward.
+	void FlushAll(bool discard);
+	void ReloadPinned();
+	void ReleaseSpillLocks();
+
+private:
+	int AllocateSlot();
+	int NextUse(int r) const;
+	void Flush(int slot, bool discard);
 
-class IRToX86 : public IRToNativeInterface {
+	struct HostReg {
+		Gen::X64Reg reg;
+		int mipsReg;
+		bool dirty;
+		bool locked;
+	};
+
+	Gen::XEmitter *emit_ = nullptr;
+	const IRInst *instructions_ = nullptr;
+	int count_ = 0;
+	int curInst_ = 0;
+	IRLiveness liveness_;
+	HostReg host_[IRX86_NUM_ALLOC_REGS];
+	// Index into host_ for each IR register, or -1.
+	int slot_[256];
+};
+
+class IRToX86 : public Gen::XCodeBlock, public IRToNativeInterface {
 public:
-	void SetCodeBlock(Gen::XCodeBlock *code) { code_ = code; }
-	virtual void ConvertIRToNative(const IRInst *instructions, int count, const u32 *constants) override;
+	IRToX86(MIPSState *mips);
+
+	const u8 *ConvertIRToNative(const IRInst *instructions, int count) override;
+	u32 RunBlock(const u8 *entry) override;
+	void AddLinkTarget(u32 em_address, const u8 *entry) override;
+	void RemoveLinkTarget(u32 em_address) override;
+	void ClearCache() override;
+	bool IsFull() const override;
+	bool DescribeCodePtr(const u8 *ptr, std::string &name) override;
 
 private:
-	Gen::XCodeBlock *code_;
+	void GenerateFixedCode();
+	void ChoosePinnedRegs();
+	void PatchLinks(u32 em_address, const u8 *target);
+	bool CanCompile(const IRInst *instructions, int count) const;
+
+	void CompIR_Arith(const IRInst &inst);
+	void CompIR_Compare(const IRInst &inst);
+	void CompIR_Shift(const IRInst &inst);
+	void CompIR_HiLo(const IRInst &inst);
+	void CompIR_Load(const IRInst &inst);
+	void CompIR_Store(const IRInst &inst);
+	void CompIR_FPU(const IRInst &inst);
+	void CompIR_Vec4(const IRInst &inst);
+	void CompIR_Exit(const IRInst &inst);
+	void CompIR_Generic(const IRInst &inst);
+	void CompIR_GenericExit(const IRInst &inst);
+
+	Gen::OpArg PrepareMemAddress(const IRInst &inst);
+	void WriteExit(const Gen::OpArg &newPC);
+	void WriteConstExit(u32 newPC);
+
+	MIPSState *mips_;
+	IRX86RegCache gpr;
+
+	typedef u32 (*EnterFunc)(const u8 *entry);
+	EnterFunc enter_ = nullptr;
+	const u8 *exit_ = nullptr;
+	// For when the pinned registers were already written back.
+	const u8 *exitNoStore_ = nullptr;
+	const u8 *endOfFixedCode_ = nullptr;
+
+	// Chosen by use counts each time the code space is cleared.
+	u8 pinned_[IRX86_NUM_PINNED_REGS];
+	u32 gprUses_[32]{};
+
+	// Exits to a constant PC jump straight to the block there, while downcount lasts.
+	std::unordered_map<u32, const u8 *> linkTargets_;
+	std::unordered_multimap<u32, u8 *> linkSites_;
 };
 
 }  // namespace
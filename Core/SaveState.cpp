@@ -45,6 +45,7 @@
 #include "Core/MIPS/MIPS.h"
 #include "Core/MIPS/JitCommon/JitBlockCache.h"
 #include "HW/MemoryStick.h"
+#include "GPU/GPUInterface.h"
 #include "GPU/GPUState.h"
 
 #ifndef MOBILE_DEVICE
@@ -281,6 +282,10 @@ namespace SaveState
 			saveStateGeneration = 1;
 		}
 
+		// The GPU may still be drawing into memory on another thread.
+		if (gpu)
+			gpu->FinishPendingDraws();
+
 		// Gotta do CoreTiming first since we'll restore into it.
 		CoreTiming::DoState(p);
 
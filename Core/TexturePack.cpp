@@ -0,0 +1,261 @@
+// Copyright (c) 2026- PPSSPP Project.
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, version 2.0 or later versions.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License 2.0 for more details.
+
+// A copy of the GPL 2.0 should have been included with the program.
+// If not, see http://www.gnu.org/licenses/
+
+// Official git repository and contact information can be found at
+// https://github.com/hrydgard/ppsspp and http://www.ppsspp.org/.
+
+#include <algorithm>
+#include <cstring>
+
+#include "ppsspp_config.h"
+#include "util/text/utf8.h"
+#include "ext/xxhash.h"
+#include "Common/FileUtil.h"
+#include "Common/Log.h"
+#include "Core/TexturePack.h"
+
+#ifdef _WIN32
+#include "Common/CommonWindows.h"
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+static const char PACK_MAGIC[4] = { 'P', 'P', 'T', 'P' };
+static const u32 PACK_VERSION = 1;
+static const u64 DATA_ALIGNMENT = 16;
+
+static u64 NameHash(const std::string &name) {
+	return XXH64(name.data(), name.size(), 0);
+}
+
+TexturePack::~TexturePack() {
+	Close();
+}
+
+bool TexturePack::Open(const std::string &filename) {
+	Close();
+
+#ifdef _WIN32
+#if PPSSPP_PLATFORM(UWP)
+	HANDLE file = CreateFile2(ConvertUTF8ToWString(filename).c_str(), GENERIC_READ, FILE_SHARE_READ, OPEN_EXISTING, nullptr);
+#else
+	HANDLE file = CreateFile(ConvertUTF8ToWString(filename).c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+#endif
+	if (file == INVALID_HANDLE_VALUE) {
+		return false;
+	}
+	LARGE_INTEGER size;
+	if (!GetFileSizeEx(file, &size) || size.QuadPart == 0) {
+		CloseHandle(file);
+		return false;
+	}
+#if PPSSPP_PLATFORM(UWP)
+	HANDLE mapping = CreateFileMappingFromApp(file, nullptr, PAGE_READONLY, 0, nullptr);
+#else
+	HANDLE mapping = CreateFileMapping(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+#endif
+	CloseHandle(file);
+	if (!mapping) {
+		return false;
+	}
+	// The view keeps the mapping alive.
+#if PPSSPP_PLATFORM(UWP)
+	base_ = (const u8 *)MapViewOfFileFromApp(mapping, FILE_MAP_READ, 0, 0);
+#else
+	base_ = (const u8 *)MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+#endif
+	CloseHandle(mapping);
+	size_ = size.QuadPart;
+#else
+	int fd = open(filename.c_str(), O_RDONLY | O_CLOEXEC);
+	if (fd == -1) {
+		return false;
+	}
+	struct stat st;
+	if (fstat(fd, &st) != 0 || st.st_size == 0 || (u64)st.st_size > (u64)SIZE_MAX) {
+		close(fd);
+		return false;
+	}
+	void *base = mmap(nullptr, (size_t)st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+	close(fd);
+	base_ = base == MAP_FAILED ? nullptr : (const u8 *)base;
+	size_ = st.st_size;
+#endif
+
+	if (!base_) {
+		ERROR_LOG(G3D, "Unable to map texture pack: %s", filename.c_str());
+		return false;
+	}
+
+	if (!Validate()) {
+		ERROR_LOG(G3D, "Invalid or unsupported texture pack: %s", filename.c_str());
+		Close();
+		return false;
+	}
+
+	const TexturePackHeader *header = (const TexturePackHeader *)base_;
+	index_ = (const TexturePackEntry *)(base_ + header->indexOffset);
+	count_ = header->count;
+	INFO_LOG(G3D, "Opened texture pack with %d images: %s", count_, filename.c_str());
+	return true;
+}
+
+bool TexturePack::Validate() const {
+	if (size_ < sizeof(TexturePackHeader)) {
+		return false;
+	}
+	const TexturePackHeader *header = (const TexturePackHeader *)base_;
+	if (memcmp(header->magic, PACK_MAGIC, sizeof(PACK_MAGIC)) != 0 || header->version != PACK_VERSION) {
+		return false;
+	}
+	if (header->indexOffset > size_ || (size_ - header->indexOffset) / sizeof(TexturePackEntry) < header->count) {
+		return false;
+	}
+
+	// Check everything once here, so lookups can trust the index.
+	const TexturePackEntry *index = (const TexturePackEntry *)(base_ + header->indexOffset);
+	for (u32 i = 0; i < header->count; ++i) {
+		const TexturePackEntry &entry = index[i];
+		const u64 dataSize = (u64)entry.w * entry.h * sizeof(u32);
+		if (entry.nameOffset > size_ || entry.nameLength > size_ - entry.nameOffset) {
+			return false;
+		}
+		if (entry.dataOffset > size_ || dataSize > size_ - entry.dataOffset || (entry.dataOffset & (DATA_ALIGNMENT - 1)) != 0) {
+			return false;
+		}
+		if (i != 0 && index[i - 1].nameHash > entry.nameHash) {
+			return false;
+		}
+	}
+	return true;
+}
+
+void TexturePack::Close() {
+	if (base_) {
+#ifdef _WIN32
+		UnmapViewOfFile(base_);
+#else
+		munmap((void *)base_, (size_t)size_);
+#endif
+	}
+	base_ = nullptr;
+	size_ = 0;
+	index_ = nullptr;
+	count_ = 0;
+}
+
+const TexturePackEntry *TexturePack::Find(const std::string &name) const {
+	if (!base_) {
+		return nullptr;
+	}
+
+	const u64 hash = NameHash(name);
+	const TexturePackEntry *end = index_ + count_;
+	auto it = std::lower_bound(index_, end, hash, [](const TexturePackEntry &entry, u64 hash) {
+		return entry.nameHash < hash;
+	});
+	// Collisions are unlikely, but just in case, check the name too.
+	for (; it != end && it->nameHash == hash; ++it) {
+		if (it->nameLength == name.size() && memcmp(base_ + it->nameOffset, name.data(), name.size()) == 0) {
+			return it;
+		}
+	}
+	return nullptr;
+}
+
+TexturePackWriter::~TexturePackWriter() {
+	if (fp_) {
+		fclose(fp_);
+	}
+}
+
+bool TexturePackWriter::Begin(const std::string &filename) {
+	fp_ = File::OpenCFile(filename, "wb");
+	if (!fp_) {
+		return false;
+	}
+
+	// The real header is written last, once we know where the index is.
+	TexturePackHeader header{};
+	pos_ = 0;
+	return Write(&header, sizeof(header));
+}
+
+bool TexturePackWriter::Write(const void *data, size_t size) {
+	if (fwrite(data, 1, size, fp_) != size) {
+		return false;
+	}
+	pos_ += size;
+	return true;
+}
+
+bool TexturePackWriter::Align(u64 alignment) {
+	static const u8 zeros[DATA_ALIGNMENT] = {};
+	u64 padding = (alignment - (pos_ & (alignment - 1))) & (alignment - 1);
+	return Write(zeros, (size_t)padding);
+}
+
+bool TexturePackWriter::Add(const std::string &name, int w, int h, u32 alphaStatus, const u8 *data) {
+	if (!Align(DATA_ALIGNMENT)) {
+		return false;
+	}
+
+	TexturePackEntry entry{};
+	entry.nameHash = NameHash(name);
+	entry.dataOffset = pos_;
+	entry.nameLength = (u32)name.size();
+	entry.w = w;
+	entry.h = h;
+	entry.alphaStatus = alphaStatus;
+	if (!Write(data, (size_t)w * h * sizeof(u32))) {
+		return false;
+	}
+
+	entries_.push_back(entry);
+	names_.push_back(name);
+	return true;
+}
+
+bool TexturePackWriter::Finish() {
+	for (size_t i = 0; i < entries_.size(); ++i) {
+		entries_[i].nameOffset = pos_;
+		if (!Write(names_[i].data(), names_[i].size())) {
+			return false;
+		}
+	}
+
+	std::sort(entries_.begin(), entries_.end(), [](const TexturePackEntry &a, const TexturePackEntry &b) {
+		return a.nameHash < b.nameHash;
+	});
+
+	if (!Align(sizeof(u64))) {
+		return false;
+	}
+	TexturePackHeader header{};
+	memcpy(header.magic, PACK_MAGIC, sizeof(PACK_MAGIC));
+	header.version = PACK_VERSION;
+	header.count = (u32)entries_.size();
+	header.indexOffset = pos_;
+	if (!entries_.empty() && !Write(&entries_[0], entries_.size() * sizeof(TexturePackEntry))) {
+		return false;
+	}
+
+	bool success = fseek(fp_, 0, SEEK_SET) == 0 && fwrite(&header, sizeof(header), 1, fp_) == 1;
+	success = fclose(fp_) == 0 && success;
+	fp_ = nullptr;
+	return success;
+}
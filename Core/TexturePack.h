@@ -0,0 +1,105 @@
+// Copyright (c) 2026- PPSSPP Project.
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, version 2.0 or later versions.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License 2.0 for more details.
+
+// A copy of the GPL 2.0 should have been included with the program.
+// If not, see http://www.gnu.org/licenses/
+
+// Official git repository and contact information can be found at
+// https://github.com/hrydgard/ppsspp and http://www.ppsspp.org/.
+
+#pragma once
+
+#include <cstdio>
+#include <string>
+#include <vector>
+#include "Common/Common.h"
+
+// A texture pack in a single file, with every image already decoded to RGBA8888.
+// It's mapped into memory, so finding an image is a binary search and loading it is a copy,
+// instead of opening and decoding a PNG each time.
+//
+// Layout: header, then the image data (each 16-byte aligned), then the names, then the index
+// sorted by name hash.  All little endian.
+
+struct TexturePackHeader {
+	char magic[4];
+	u32 version;
+	u32 count;
+	u32 reserved;
+	u64 indexOffset;
+};
+
+struct TexturePackEntry {
+	// XXH64 of the path relative to the textures folder, as used in textures.ini.
+	u64 nameHash;
+	u64 nameOffset;
+	u64 dataOffset;
+	u32 nameLength;
+	u32 w;
+	u32 h;
+	// A ReplacedTextureAlpha, checked when packing.
+	u32 alphaStatus;
+};
+
+static_assert(sizeof(TexturePackHeader) == 24, "TexturePackHeader should not be padded");
+static_assert(sizeof(TexturePackEntry) == 40, "TexturePackEntry should not be padded");
+
+class TexturePack {
+public:
+	TexturePack() {}
+	~TexturePack();
+
+	bool Open(const std::string &filename);
+	void Close();
+
+	bool IsOpen() const {
+		return base_ != nullptr;
+	}
+
+	// Returns nullptr if the image isn't in the pack.
+	const TexturePackEntry *Find(const std::string &name) const;
+	const u8 *GetData(const TexturePackEntry *entry) const {
+		return base_ + entry->dataOffset;
+	}
+
+private:
+	TexturePack(const TexturePack &) = delete;
+	void operator =(const TexturePack &) = delete;
+
+	bool Validate() const;
+
+	const u8 *base_ = nullptr;
+	u64 size_ = 0;
+	const TexturePackEntry *index_ = nullptr;
+	u32 count_ = 0;
+};
+
+class TexturePackWriter {
+public:
+	TexturePackWriter() {}
+	~TexturePackWriter();
+
+	bool Begin(const std::string &filename);
+	bool Add(const std::string &name, int w, int h, u32 alphaStatus, const u8 *data);
+	bool Finish();
+
+private:
+	TexturePackWriter(const TexturePackWriter &) = delete;
+	void operator =(const TexturePackWriter &) = delete;
+
+	bool Write(const void *data, size_t size);
+	bool Align(u64 alignment);
+
+	FILE *fp_ = nullptr;
+	u64 pos_ = 0;
+	std::vector<TexturePackEntry> entries_;
+	std::vector<std::string> names_;
+};
@@ -24,7 +24,9 @@
 #include <algorithm>
 #include "i18n/i18n.h"
 #include "ext/xxhash.h"
+#include "file/file_util.h"
 #include "file/ini_file.h"
+#include "thread/threadutil.h"
 #include "Common/ColorConv.h"
 #include "Common/FileUtil.h"
 #include "Core/Config.h"
@@ -35,15 +37,32 @@
 #include "GPU/Common/TextureDecoder.h"
 
 static const std::string INI_FILENAME = "textures.ini";
+static const std::string PACK_FILENAME = "textures.pak";
 static const std::string NEW_TEXTURE_DIR = "new/";
 static const int VERSION = 1;
 static const int MAX_MIP_LEVELS = 12;  // 12 should be plenty, 8 is the max mip levels supported by the PSP.
+// PNG decoding is slow, but it's mostly waiting on zlib, so a couple of threads is enough.
+static const int LOAD_THREADS = 2;
+// Decoded size of prefetched images not yet used, after which we stop prefetching.
+static const size_t MAX_PREFETCH_BYTES = 128 * 1024 * 1024;
+// Textures waiting to be saved.  Past this, new ones are skipped until the queue catches up.
+static const size_t MAX_SAVE_QUEUE_BYTES = 64 * 1024 * 1024;
 
 TextureReplacer::TextureReplacer() {
 	none_.alphaStatus_ = ReplacedTextureAlpha::UNKNOWN;
 }
 
 TextureReplacer::~TextureReplacer() {
+	// Let any pending saves finish.
+	WaitForLoads();
+	{
+		std::lock_guard<std::mutex> guard(loadLock_);
+		loadExiting_ = true;
+		loadCond_.notify_all();
+	}
+	for (std::thread &thread : loadThreads_) {
+		thread.join();
+	}
 }
 
 void TextureReplacer::Init() {
@@ -51,6 +70,12 @@ void TextureReplacer::Init() {
 }
 
 void TextureReplacer::NotifyConfigChanged() {
+	// The loading threads use the ini settings.
+	WaitForLoads();
+	// The replacements may point into the pack, and the ini may have changed anyway.
+	cache_.clear();
+	pack_.Close();
+
 	gameID_ = g_paramSFO.GetDiscID();
 
 	enabled_ = g_Config.bReplaceTextures || g_Config.bSaveNewTextures;
@@ -69,6 +94,9 @@ void TextureReplacer::NotifyConfigChanged() {
 	if (enabled_) {
 		enabled_ = LoadIni();
 	}
+	if (enabled_ && File::Exists(basePath_ + PACK_FILENAME)) {
+		pack_.Open(basePath_ + PACK_FILENAME);
+	}
 }
 
 bool TextureReplacer::LoadIni() {
@@ -104,6 +132,8 @@ bool TextureReplacer::LoadIni() {
 		}
 	}
 
+	BuildPrefetchGroups();
+
 	// The ini doesn't have to exist for it to be valid.
 	return true;
 }
@@ -183,6 +213,19 @@ bool TextureReplacer::LoadIniValues(IniFile &ini, bool isOverride) {
 	return true;
 }
 
+void TextureReplacer::BuildPrefetchGroups() {
+	prefetchGroups_.clear();
+	for (const auto &alias : aliases_) {
+		const std::string &file = alias.second;
+		size_t slash = file.find_last_of('/');
+		// Files at the top aren't grouped, that'd usually be the whole pack.
+		if (file.empty() || slash == file.npos) {
+			continue;
+		}
+		prefetchGroups_[file.substr(0, slash)].push_back(file);
+	}
+}
+
 void TextureReplacer::ParseHashRange(const std::string &key, const std::string &value) {
 	std::vector<std::string> keyParts;
 	SplitString(key, ',', keyParts);
@@ -295,16 +338,193 @@ ReplacedTexture &TextureReplacer::FindReplacement(u64 cachekey, u32 hash, int w,
 	ReplacementCacheKey replacementKey(cachekey, hash);
 	auto it = cache_.find(replacementKey);
 	if (it != cache_.end()) {
+		// Its decoded data is freed after use, so load it again if it's used again.
+		if (it->second.state_ == ReplacedTextureState::UNLOADED) {
+			QueueLoad(&it->second);
+		}
 		return it->second;
 	}
 
-	// Okay, let's construct the result.
+	// Okay, let's construct the result.  Finding and decoding the files happens in the background.
 	ReplacedTexture &result = cache_[replacementKey];
 	result.alphaStatus_ = ReplacedTextureAlpha::UNKNOWN;
-	PopulateReplacement(&result, cachekey, hash, w, h);
+	result.lookupCachekey_ = cachekey;
+	result.lookupHash_ = hash;
+	result.lookupW_ = w;
+	result.lookupH_ = h;
+	if (pack_.IsOpen()) {
+		// Packed images are found with a quick lookup and need no decoding, so no need to wait.
+		PopulateReplacement(&result, cachekey, hash, w, h);
+		return result;
+	}
+	QueueLoad(&result);
 	return result;
 }
 
+void TextureReplacer::StartThreads() {
+	// Must be called with loadLock_ held.
+	if (loadThreads_.empty()) {
+		for (int i = 0; i < LOAD_THREADS; ++i) {
+			loadThreads_.push_back(std::thread([this] { WorkerThread(); }));
+		}
+	}
+}
+
+void TextureReplacer::QueueLoad(ReplacedTexture *texture) {
+	texture->state_ = ReplacedTextureState::PENDING;
+
+	std::lock_guard<std::mutex> guard(loadLock_);
+	StartThreads();
+	loadQueue_.push_back(texture);
+	loadCond_.notify_one();
+}
+
+void TextureReplacer::QueuePrefetch(const std::string &filename) {
+	const std::string hashfile = filename.substr(basePath_.size());
+	size_t slash = hashfile.find_last_of('/');
+	if (slash == hashfile.npos) {
+		return;
+	}
+
+	const std::string group = hashfile.substr(0, slash);
+	auto files = prefetchGroups_.find(group);
+	if (files == prefetchGroups_.end()) {
+		return;
+	}
+
+	std::lock_guard<std::mutex> guard(loadLock_);
+	if (!prefetchedGroups_.insert(group).second) {
+		// Already did this folder.
+		return;
+	}
+	for (const std::string &file : files->second) {
+		prefetchQueue_.push_back(basePath_ + file);
+	}
+	loadCond_.notify_all();
+}
+
+void TextureReplacer::WaitForLoads() {
+	std::unique_lock<std::mutex> guard(loadLock_);
+	prefetchQueue_.clear();
+	while (!loadQueue_.empty() || !saveQueue_.empty() || activeLoads_ != 0) {
+		loadDoneCond_.wait(guard);
+	}
+
+	prefetched_.clear();
+	prefetchedBytes_ = 0;
+	prefetchedGroups_.clear();
+}
+
+void TextureReplacer::WorkerThread() {
+	setCurrentThreadName("TexReplace");
+
+	std::unique_lock<std::mutex> guard(loadLock_);
+	while (!loadExiting_) {
+		// Skip saves of a file another thread is still writing, they'd clobber each other.
+		auto nextSave = saveQueue_.begin();
+		while (nextSave != saveQueue_.end() && savesInProgress_.count(nextSave->filename) != 0)
+			++nextSave;
+		if (loadQueue_.empty() && nextSave == saveQueue_.end() && prefetchQueue_.empty()) {
+			loadCond_.wait(guard);
+			continue;
+		}
+
+		activeLoads_++;
+		std::string savedFile;
+		if (!loadQueue_.empty()) {
+			ReplacedTexture *texture = loadQueue_.front();
+			loadQueue_.pop_front();
+			guard.unlock();
+			LoadReplacement(texture);
+		} else if (nextSave != saveQueue_.end()) {
+			ReplacedTextureSave save = std::move(*nextSave);
+			saveQueue_.erase(nextSave);
+			saveQueueBytes_ -= save.data.size();
+			savedFile = save.filename;
+			savesInProgress_.insert(savedFile);
+			guard.unlock();
+			SaveTexture(save);
+		} else {
+			std::string filename = prefetchQueue_.front();
+			prefetchQueue_.pop_front();
+			guard.unlock();
+			PrefetchImage(filename);
+		}
+		guard.lock();
+		if (!savedFile.empty()) {
+			savesInProgress_.erase(savedFile);
+			// A later save of the same file may have been waiting on this one.
+			loadCond_.notify_all();
+		}
+		activeLoads_--;
+		loadDoneCond_.notify_all();
+	}
+}
+
+static bool DecodeReplacementImage(const std::string &filename, ReplacedImage *image);
+
+void TextureReplacer::LoadReplacement(ReplacedTexture *texture) {
+	if (texture->levels_.empty()) {
+		PopulateReplacement(texture, texture->lookupCachekey_, texture->lookupHash_, texture->lookupW_, texture->lookupH_);
+	}
+	if (!texture->levels_.empty()) {
+		// Whatever else is in its folder is likely to be needed soon.
+		QueuePrefetch(texture->levels_[0].file);
+	}
+
+	texture->levelData_.resize(texture->levels_.size());
+	for (size_t i = 0; i < texture->levels_.size(); ++i) {
+		const ReplacedTextureLevel &info = texture->levels_[i];
+		if (info.packedData) {
+			// Already decoded.
+			continue;
+		}
+		ReplacedImage image;
+		if (!TakePrefetched(info.file, &image) && !DecodeReplacementImage(info.file, &image)) {
+			continue;
+		}
+
+		std::vector<u8> &data = texture->levelData_[i];
+		data.resize(info.w * info.h * sizeof(u32));
+		texture->ApplyImage((int)i, image, &data[0], info.w * sizeof(u32));
+	}
+
+	texture->state_ = ReplacedTextureState::READY;
+}
+
+void TextureReplacer::PrefetchImage(const std::string &filename) {
+	{
+		std::lock_guard<std::mutex> guard(loadLock_);
+		if (prefetched_.count(filename) || prefetchedBytes_ >= MAX_PREFETCH_BYTES) {
+			return;
+		}
+	}
+
+	ReplacedImage image;
+	if (!File::Exists(filename) || !DecodeReplacementImage(filename, &image)) {
+		return;
+	}
+
+	std::lock_guard<std::mutex> guard(loadLock_);
+	size_t bytes = image.data.size();
+	if (prefetched_.emplace(filename, std::move(image)).second) {
+		prefetchedBytes_ += bytes;
+	}
+}
+
+bool TextureReplacer::TakePrefetched(const std::string &filename, ReplacedImage *image) {
+	std::lock_guard<std::mutex> guard(loadLock_);
+	auto it = prefetched_.find(filename);
+	if (it == prefetched_.end()) {
+		return false;
+	}
+
+	prefetchedBytes_ -= it->second.data.size();
+	*image = std::move(it->second);
+	prefetched_.erase(it);
+	return true;
+}
+
 void TextureReplacer::PopulateReplacement(ReplacedTexture *result, u64 cachekey, u32 hash, int w, int h) {
 	int newW = w;
 	int newH = h;
@@ -317,7 +537,8 @@ void TextureReplacer::PopulateReplacement(ReplacedTexture *result, u64 cachekey,
 	for (int i = 0; i < MAX_MIP_LEVELS; ++i) {
 		const std::string hashfile = LookupHashFile(cachekey, hash, i);
 		const std::string filename = basePath_ + hashfile;
-		if (hashfile.empty() || !File::Exists(filename)) {
+		const TexturePackEntry *packed = hashfile.empty() ? nullptr : pack_.Find(hashfile);
+		if (hashfile.empty() || (pack_.IsOpen() ? !packed : !File::Exists(filename))) {
 			// Out of valid mip levels.  Bail out.
 			break;
 		}
@@ -327,6 +548,15 @@ void TextureReplacer::PopulateReplacement(ReplacedTexture *result, u64 cachekey,
 		level.fmt = ReplacedTextureFormat::F_8888;
 		level.file = filename;
 
+		if (packed) {
+			level.w = (packed->w * w) / newW;
+			level.h = (packed->h * h) / newH;
+			level.packedData = pack_.GetData(packed);
+			level.packedW = packed->w;
+			level.packedH = packed->h;
+			level.packedAlpha = ReplacedTextureAlpha(packed->alphaStatus);
+			good = true;
+		} else {
 #ifdef USING_QT_UI
 		QImage image(filename.c_str(), "PNG");
 		if (image.isNull()) {
@@ -352,6 +582,7 @@ void TextureReplacer::PopulateReplacement(ReplacedTexture *result, u64 cachekey,
 
 		png_image_free(&png);
 #endif
+		}
 
 		if (good && i != 0) {
 			// Check that the mipmap size is correct.  Can't load mips of the wrong size.
@@ -414,7 +645,6 @@ void TextureReplacer::NotifyTextureDecoded(const ReplacedTextureDecodeInfo &repl
 
 	std::string hashfile = LookupHashFile(cachekey, replacedInfo.hash, level);
 	const std::string filename = basePath_ + hashfile;
-	const std::string saveFilename = basePath_ + NEW_TEXTURE_DIR + hashfile;
 
 	// If it's empty, it's an ignored hash, we intentionally don't save.
 	if (hashfile.empty() || File::Exists(filename)) {
@@ -424,25 +654,26 @@ void TextureReplacer::NotifyTextureDecoded(const ReplacedTextureDecodeInfo &repl
 
 	ReplacementCacheKey replacementKey(cachekey, replacedInfo.hash);
 	auto it = savedCache_.find(replacementKey);
-	if (it != savedCache_.end() && File::Exists(saveFilename)) {
-		// We've already saved this texture.  Let's only save if it's bigger (e.g. scaled now.)
+	if (it != savedCache_.end()) {
+		// We've already saved (or queued) this texture.  Let's only save if it's bigger (e.g. scaled now.)
 		if (it->second.w >= w && it->second.h >= h) {
 			return;
 		}
 	}
 
+#ifdef USING_QT_UI
+	ERROR_LOG(G3D, "Replacement texture saving not implemented for Qt");
+#else
+	ReplacedTextureSave save;
+	save.filename = basePath_ + NEW_TEXTURE_DIR + hashfile;
+
 #ifdef _WIN32
 	size_t slash = hashfile.find_last_of("/\\");
 #else
 	size_t slash = hashfile.find_last_of("/");
 #endif
 	if (slash != hashfile.npos) {
-		// Create any directory structure as needed.
-		const std::string saveDirectory = basePath_ + NEW_TEXTURE_DIR + hashfile.substr(0, slash);
-		if (!File::Exists(saveDirectory)) {
-			File::CreateFullPath(saveDirectory);
-			File::CreateEmptyFile(saveDirectory + "/.nomedia");
-		}
+		save.directory = basePath_ + NEW_TEXTURE_DIR + hashfile.substr(0, slash);
 	}
 
 	// Only save the hashed portion of the PNG.
@@ -453,12 +684,60 @@ void TextureReplacer::NotifyTextureDecoded(const ReplacedTextureDecodeInfo &repl
 		h = lookupH * replacedInfo.scaleFactor;
 	}
 
-#ifdef USING_QT_UI
-	ERROR_LOG(G3D, "Replacement texture saving not implemented for Qt");
-#else
-	if (replacedInfo.fmt != ReplacedTextureFormat::F_8888) {
+	save.fmt = replacedInfo.fmt;
+	save.w = w;
+	save.h = h;
+	save.pitch = pitch;
+
+	{
+		std::lock_guard<std::mutex> guard(loadLock_);
+		// A smaller version of this texture may still be waiting, if so this one replaces it.
+		auto queued = std::find_if(saveQueue_.begin(), saveQueue_.end(), [&](const ReplacedTextureSave &other) {
+			return other.filename == save.filename;
+		});
+		size_t replacedBytes = queued != saveQueue_.end() ? queued->data.size() : 0;
+		if (saveQueueBytes_ - replacedBytes + pitch * h > MAX_SAVE_QUEUE_BYTES) {
+			// Try again next time it's decoded, hopefully the queue has caught up.
+			return;
+		}
+
+		// Only a copy here, the conversion and PNG encoding happen on the worker threads.
+		save.data.assign((const u8 *)data, (const u8 *)data + pitch * h);
+		saveQueueBytes_ += save.data.size() - replacedBytes;
+		if (queued != saveQueue_.end()) {
+			*queued = std::move(save);
+		} else {
+			StartThreads();
+			saveQueue_.push_back(std::move(save));
+		}
+		loadCond_.notify_one();
+	}
+#endif
+
+	// Remember that we've saved this for next time.
+	ReplacedTextureLevel saved;
+	saved.fmt = ReplacedTextureFormat::F_8888;
+	saved.file = filename;
+	saved.w = w;
+	saved.h = h;
+	savedCache_[replacementKey] = saved;
+}
+
+void TextureReplacer::SaveTexture(ReplacedTextureSave &save) {
+#ifndef USING_QT_UI
+	if (!save.directory.empty() && !File::Exists(save.directory)) {
+		// Create any directory structure as needed.
+		File::CreateFullPath(save.directory);
+		File::CreateEmptyFile(save.directory + "/.nomedia");
+	}
+
+	const void *data = save.data.data();
+	int pitch = save.pitch;
+	const int h = save.h;
+	std::vector<u32> saveBuf;
+	if (save.fmt != ReplacedTextureFormat::F_8888) {
 		saveBuf.resize((pitch * h) / sizeof(u16));
-		switch (replacedInfo.fmt) {
+		switch (save.fmt) {
 		case ReplacedTextureFormat::F_5650:
 			ConvertRGBA565ToRGBA8888(saveBuf.data(), (const u16 *)data, (pitch * h) / sizeof(u16));
 			break;
@@ -486,7 +765,7 @@ void TextureReplacer::NotifyTextureDecoded(const ReplacedTextureDecodeInfo &repl
 		}
 
 		data = saveBuf.data();
-		if (replacedInfo.fmt != ReplacedTextureFormat::F_8888_BGRA) {
+		if (save.fmt != ReplacedTextureFormat::F_8888_BGRA) {
 			// We doubled our pitch.
 			pitch *= 2;
 		}
@@ -496,25 +775,17 @@ void TextureReplacer::NotifyTextureDecoded(const ReplacedTextureDecodeInfo &repl
 	memset(&png, 0, sizeof(png));
 	png.version = PNG_IMAGE_VERSION;
 	png.format = PNG_FORMAT_RGBA;
-	png.width = w;
-	png.height = h;
-	bool success = WriteTextureToPNG(&png, saveFilename, 0, data, pitch, nullptr);
+	png.width = save.w;
+	png.height = save.h;
+	bool success = WriteTextureToPNG(&png, save.filename, 0, data, pitch, nullptr);
 	png_image_free(&png);
 
 	if (png.warning_or_error >= 2) {
 		ERROR_LOG(COMMON, "Saving screenshot to PNG produced errors.");
 	} else if (success) {
-		NOTICE_LOG(G3D, "Saving texture for replacement: %08x / %dx%d", replacedInfo.hash, w, h);
+		NOTICE_LOG(G3D, "Saving texture for replacement: %s / %dx%d", save.filename.c_str(), save.w, save.h);
 	}
 #endif
-
-	// Remember that we've saved this for next time.
-	ReplacedTextureLevel saved;
-	saved.fmt = ReplacedTextureFormat::F_8888;
-	saved.file = filename;
-	saved.w = w;
-	saved.h = h;
-	savedCache_[replacementKey] = saved;
 }
 
 std::string TextureReplacer::LookupHashFile(u64 cachekey, u32 hash, int level) {
@@ -588,75 +859,197 @@ bool TextureReplacer::LookupHashRange(u32 addr, int &w, int &h) {
 	return false;
 }
 
-void ReplacedTexture::Load(int level, void *out, int rowPitch) {
-	_assert_msg_(G3D, (size_t)level < levels_.size(), "Invalid miplevel");
-	_assert_msg_(G3D, out != nullptr && rowPitch > 0, "Invalid out/pitch");
-
-	const ReplacedTextureLevel &info = levels_[level];
-
+static bool DecodeReplacementImage(const std::string &filename, ReplacedImage *image) {
 #ifdef USING_QT_UI
-	QImage image(info.file.c_str(), "PNG");
-	if (image.isNull()) {
-		ERROR_LOG(G3D, "Could not load texture replacement info: %s", info.file.c_str());
-		return;
+	QImage qimage(filename.c_str(), "PNG");
+	if (qimage.isNull()) {
+		ERROR_LOG(G3D, "Could not load texture replacement: %s", filename.c_str());
+		return false;
 	}
 
-	image = image.convertToFormat(QImage::Format_ARGB32);
-	bool alphaFull = true;
-	for (int y = 0; y < image.height(); ++y) {
-		const QRgb *src = (const QRgb *)image.constScanLine(y);
-		uint8_t *outLine = (uint8_t *)out + y * rowPitch;
-		for (int x = 0; x < image.width(); ++x) {
+	image->hasAlpha = qimage.hasAlphaChannel();
+	qimage = qimage.convertToFormat(QImage::Format_ARGB32);
+	image->w = qimage.width();
+	image->h = qimage.height();
+	image->data.resize(image->w * image->h * sizeof(u32));
+	for (int y = 0; y < image->h; ++y) {
+		const QRgb *src = (const QRgb *)qimage.constScanLine(y);
+		uint8_t *outLine = &image->data[y * image->w * sizeof(u32)];
+		for (int x = 0; x < image->w; ++x) {
 			outLine[x * 4 + 0] = qRed(src[x]);
 			outLine[x * 4 + 1] = qGreen(src[x]);
 			outLine[x * 4 + 2] = qBlue(src[x]);
 			outLine[x * 4 + 3] = qAlpha(src[x]);
-			// We're already scanning each pixel...
-			if (qAlpha(src[x]) != 255) {
-				alphaFull = false;
-			}
 		}
 	}
-
-	if (level == 0 || !alphaFull) {
-		alphaStatus_ = alphaFull ? ReplacedTextureAlpha::FULL : ReplacedTextureAlpha::UNKNOWN;
-	}
+	return true;
 #else
 	png_image png = {};
 	png.version = PNG_IMAGE_VERSION;
 
-	FILE *fp = File::OpenCFile(info.file, "rb");
+	FILE *fp = File::OpenCFile(filename, "rb");
 	if (!png_image_begin_read_from_stdio(&png, fp)) {
-		ERROR_LOG(G3D, "Could not load texture replacement info: %s - %s", info.file.c_str(), png.message);
+		ERROR_LOG(G3D, "Could not load texture replacement info: %s - %s", filename.c_str(), png.message);
+		if (fp) {
+			fclose(fp);
+		}
+		png_image_free(&png);
+		return false;
+	}
+
+	image->hasAlpha = (png.format & PNG_FORMAT_FLAG_ALPHA) != 0;
+	png.format = PNG_FORMAT_RGBA;
+	image->w = png.width;
+	image->h = png.height;
+	image->data.resize(image->w * image->h * sizeof(u32));
+
+	bool success = png_image_finish_read(&png, nullptr, &image->data[0], image->w * sizeof(u32), nullptr) != 0;
+	if (!success) {
+		ERROR_LOG(G3D, "Could not load texture replacement: %s - %s", filename.c_str(), png.message);
+	}
+
+	fclose(fp);
+	png_image_free(&png);
+	return success;
+#endif
+}
+
+void ReplacedTexture::Load(int level, void *out, int rowPitch) {
+	_assert_msg_(G3D, (size_t)level < levels_.size(), "Invalid miplevel");
+	_assert_msg_(G3D, out != nullptr && rowPitch > 0, "Invalid out/pitch");
+
+	const ReplacedTextureLevel &info = levels_[level];
+
+	if (info.packedData) {
+		const int w = std::min(info.packedW, info.w);
+		const int h = std::min(info.packedH, info.h);
+		for (int y = 0; y < h; ++y) {
+			memcpy((u8 *)out + y * rowPitch, info.packedData + y * info.packedW * sizeof(u32), w * sizeof(u32));
+		}
+		// Checked when packing.
+		if (info.packedAlpha == ReplacedTextureAlpha::UNKNOWN || level == 0) {
+			alphaStatus_ = info.packedAlpha;
+		}
 		return;
 	}
 
-	bool checkedAlpha = false;
-	if ((png.format & PNG_FORMAT_FLAG_ALPHA) == 0) {
-		// Well, we know for sure it doesn't have alpha.
-		if (level == 0) {
-			alphaStatus_ = ReplacedTextureAlpha::FULL;
+	if ((size_t)level < levelData_.size() && !levelData_[level].empty()) {
+		const std::vector<u8> &data = levelData_[level];
+		const int srcPitch = info.w * sizeof(u32);
+		for (int y = 0; y < info.h; ++y) {
+			memcpy((u8 *)out + y * rowPitch, &data[y * srcPitch], srcPitch);
 		}
-		checkedAlpha = true;
+		return;
 	}
-	png.format = PNG_FORMAT_RGBA;
 
-	if (!png_image_finish_read(&png, nullptr, out, rowPitch, nullptr)) {
-		ERROR_LOG(G3D, "Could not load texture replacement: %s - %s", info.file.c_str(), png.message);
+	// Wasn't decoded ahead of time (it failed, most likely), try directly.
+	ReplacedImage image;
+	if (DecodeReplacementImage(info.file, &image)) {
+		ApplyImage(level, image, out, rowPitch);
+	}
+}
+
+void ReplacedTexture::FinishedUpload() {
+	if (levelData_.empty()) {
 		return;
 	}
+	// Uploaded now, so don't hold onto it, even if not every level was used.
+	// It'll be loaded again if it's needed again.
+	levelData_.clear();
+	levelData_.shrink_to_fit();
+	state_ = ReplacedTextureState::UNLOADED;
+}
+
+void ReplacedTexture::ApplyImage(int level, const ReplacedImage &image, void *out, int rowPitch) {
+	// We pad files that have been hashrange'd, so the image may be smaller than the level.
+	const ReplacedTextureLevel &info = levels_[level];
+	const int w = std::min(image.w, info.w);
+	const int h = std::min(image.h, info.h);
+	for (int y = 0; y < h; ++y) {
+		memcpy((u8 *)out + y * rowPitch, &image.data[y * image.w * sizeof(u32)], w * sizeof(u32));
+	}
 
-	if (!checkedAlpha) {
+	if (!image.hasAlpha) {
+		// Well, we know for sure it doesn't have alpha.
+		if (level == 0) {
+			alphaStatus_ = ReplacedTextureAlpha::FULL;
+		}
+	} else {
 		// This will only check the hashed bits.
-		CheckAlphaResult res = CheckAlphaRGBA8888Basic((u32 *)out, rowPitch / sizeof(u32), png.width, png.height);
+		CheckAlphaResult res = CheckAlphaRGBA8888Basic((const u32 *)out, rowPitch / sizeof(u32), w, h);
 		if (res == CHECKALPHA_ANY || level == 0) {
 			alphaStatus_ = ReplacedTextureAlpha(res);
 		}
 	}
+}
 
-	fclose(fp);
-	png_image_free(&png);
-#endif
+static void FindPackFiles(const std::string &dir, const std::string &prefix, std::vector<std::string> *names) {
+	std::vector<FileInfo> files;
+	getFilesInDir((dir + prefix).c_str(), &files, "png");
+	for (const FileInfo &file : files) {
+		if (file.isDirectory) {
+			FindPackFiles(dir, prefix + file.name + "/", names);
+		} else {
+			names->push_back(prefix + file.name);
+		}
+	}
+}
+
+bool TextureReplacer::GeneratePack(const std::string &textureDir, std::string *error) {
+	std::string dir = textureDir;
+	if (!dir.empty() && dir.back() != '/') {
+		dir += "/";
+	}
+	if (!File::IsDirectory(dir)) {
+		*error = "Not a directory: " + dir;
+		return false;
+	}
+
+	// Named as textures.ini refers to them, relative to the folder with forward slashes.
+	std::vector<std::string> names;
+	FindPackFiles(dir, "", &names);
+
+	// Write to a temporary file, so a failure doesn't leave a broken pack behind.
+	const std::string tempFilename = dir + PACK_FILENAME + ".tmp";
+	TexturePackWriter writer;
+	if (!writer.Begin(tempFilename)) {
+		*error = "Unable to create " + tempFilename;
+		return false;
+	}
+
+	for (const std::string &name : names) {
+		ReplacedImage image;
+		if (!DecodeReplacementImage(dir + name, &image)) {
+			WARN_LOG(G3D, "Skipping texture that could not be decoded: %s", name.c_str());
+			continue;
+		}
+
+		ReplacedTextureAlpha alpha = ReplacedTextureAlpha::FULL;
+		if (image.hasAlpha) {
+			alpha = ReplacedTextureAlpha(CheckAlphaRGBA8888Basic((const u32 *)&image.data[0], image.w, image.w, image.h));
+		}
+		if (!writer.Add(name, image.w, image.h, (u32)alpha, &image.data[0])) {
+			*error = "Unable to write " + tempFilename;
+			writer.Finish();
+			File::Delete(tempFilename);
+			return false;
+		}
+	}
+
+	if (!writer.Finish()) {
+		*error = "Unable to write " + tempFilename;
+		File::Delete(tempFilename);
+		return false;
+	}
+
+	if (File::Exists(dir + PACK_FILENAME)) {
+		File::Delete(dir + PACK_FILENAME);
+	}
+	if (!File::Rename(tempFilename, dir + PACK_FILENAME)) {
+		*error = "Unable to rename " + tempFilename;
+		return false;
+	}
+	return true;
 }
 
 bool TextureReplacer::GenerateIni(const std::string &gameID, std::string *generatedFilename) {
@@ -17,12 +17,19 @@
 
 #pragma once
 
+#include <atomic>
+#include <condition_variable>
+#include <deque>
 #include <map>
+#include <mutex>
 #include <string>
+#include <thread>
 #include <unordered_map>
+#include <unordered_set>
 #include <vector>
 #include "Common/Common.h"
 #include "Common/MemoryUtil.h"
+#include "Core/TexturePack.h"
 #include "GPU/ge_constants.h"
 
 class IniFile;
@@ -54,11 +61,23 @@ enum class ReplacedTextureHash {
 	XXH64,
 };
 
+enum class ReplacedTextureState {
+	UNLOADED,
+	PENDING,
+	READY,
+};
+
 struct ReplacedTextureLevel {
 	int w;
 	int h;
 	ReplacedTextureFormat fmt;
 	std::string file;
+
+	// Set when it comes from textures.pak, already decoded.
+	const u8 *packedData = nullptr;
+	int packedW = 0;
+	int packedH = 0;
+	ReplacedTextureAlpha packedAlpha = ReplacedTextureAlpha::UNKNOWN;
 };
 
 struct ReplacementCacheKey {
@@ -121,7 +140,24 @@ namespace std {
 	};
 }
 
+// A decoded PNG, as RGBA8888 with a pitch of w * 4.
+struct ReplacedImage {
+	int w = 0;
+	int h = 0;
+	bool hasAlpha = true;
+	std::vector<u8> data;
+};
+
 struct ReplacedTexture {
+	ReplacedTexture() : state_(ReplacedTextureState::READY) {
+	}
+
+	// False while the replacement is still being loaded in the background.
+	// Nothing else may be accessed until it's ready.
+	inline bool IsReady() const {
+		return state_ == ReplacedTextureState::READY;
+	}
+
 	inline bool Valid() {
 		return !levels_.empty();
 	}
@@ -151,14 +187,38 @@ struct ReplacedTexture {
 	}
 
 	void Load(int level, void *out, int rowPitch);
+	// Call after uploading, however many levels were loaded, to free the decoded data.
+	void FinishedUpload();
 
 protected:
+	void ApplyImage(int level, const ReplacedImage &image, void *out, int rowPitch);
+
 	std::vector<ReplacedTextureLevel> levels_;
+	// Decoded in the background, with a pitch of w * 4.  Freed by FinishedUpload().
+	std::vector<std::vector<u8>> levelData_;
 	ReplacedTextureAlpha alphaStatus_;
+	std::atomic<ReplacedTextureState> state_;
+
+	// What to look up, for the background load.
+	u64 lookupCachekey_ = 0;
+	u32 lookupHash_ = 0;
+	int lookupW_ = 0;
+	int lookupH_ = 0;
 
 	friend TextureReplacer;
 };
 
+// A texture waiting to be saved, copied as it was decoded.
+struct ReplacedTextureSave {
+	std::string filename;
+	std::string directory;
+	ReplacedTextureFormat fmt;
+	int w;
+	int h;
+	int pitch;
+	std::vector<u8> data;
+};
+
 struct ReplacedTextureDecodeInfo {
 	u64 cachekey;
 	u32 hash;
@@ -183,11 +243,17 @@ class TextureReplacer {
 
 	u32 ComputeHash(u32 addr, int bufw, int w, int h, GETextureFormat fmt, u16 maxSeenV);
 
+	// May return a texture that isn't ready yet, while it loads in the background.
 	ReplacedTexture &FindReplacement(u64 cachekey, u32 hash, int w, int h);
+	ReplacedTexture &NoReplacement() {
+		return none_;
+	}
 
 	void NotifyTextureDecoded(const ReplacedTextureDecodeInfo &replacedInfo, const void *data, int pitch, int level, int w, int h);
 
 	static bool GenerateIni(const std::string &gameID, std::string *generatedFilename);
+	// Decodes all the PNGs in a texture folder into its textures.pak.
+	static bool GeneratePack(const std::string &textureDir, std::string *error);
 
 protected:
 	bool LoadIni();
@@ -197,8 +263,18 @@ class TextureReplacer {
 	std::string LookupHashFile(u64 cachekey, u32 hash, int level);
 	std::string HashName(u64 cachekey, u32 hash, int level);
 	void PopulateReplacement(ReplacedTexture *result, u64 cachekey, u32 hash, int w, int h);
+	void BuildPrefetchGroups();
+
+	void StartThreads();
+	void QueueLoad(ReplacedTexture *texture);
+	void QueuePrefetch(const std::string &hashfile);
+	void WaitForLoads();
+	void WorkerThread();
+	void LoadReplacement(ReplacedTexture *texture);
+	void SaveTexture(ReplacedTextureSave &save);
+	void PrefetchImage(const std::string &filename);
+	bool TakePrefetched(const std::string &filename, ReplacedImage *image);
 
-	SimpleBuf<u32> saveBuf;
 	bool enabled_ = false;
 	bool allowVideo_ = false;
 	bool ignoreAddress_ = false;
@@ -210,7 +286,31 @@ class TextureReplacer {
 	std::unordered_map<u64, WidthHeightPair> hashranges_;
 	std::unordered_map<ReplacementAliasKey, std::string> aliases_;
 
+	// When it exists, it's used instead of the loose files.
+	TexturePack pack_;
+
 	ReplacedTexture none_;
 	std::unordered_map<ReplacementCacheKey, ReplacedTexture> cache_;
 	std::unordered_map<ReplacementCacheKey, ReplacedTextureLevel> savedCache_;
+
+	// Files in the same folder of textures.ini are likely used together, keyed by folder.
+	std::unordered_map<std::string, std::vector<std::string>> prefetchGroups_;
+
+	// Everything below is protected by loadLock_.
+	std::mutex loadLock_;
+	std::condition_variable loadCond_;
+	std::condition_variable loadDoneCond_;
+	std::vector<std::thread> loadThreads_;
+	// Textures needed for drawing, always loaded before any saves or prefetches.
+	std::deque<ReplacedTexture *> loadQueue_;
+	std::deque<ReplacedTextureSave> saveQueue_;
+	size_t saveQueueBytes_ = 0;
+	// Filenames currently being written by a worker.
+	std::unordered_set<std::string> savesInProgress_;
+	std::deque<std::string> prefetchQueue_;
+	std::unordered_set<std::string> prefetchedGroups_;
+	std::unordered_map<std::string, ReplacedImage> prefetched_;
+	size_t prefetchedBytes_ = 0;
+	int activeLoads_ = 0;
+	bool loadExiting_ = false;
 };
@@ -98,7 +98,7 @@ static void RegisterServer(int port) {
 
 bool RemoteISOFileSupported(const std::string &filename) {
 	// Disc-like files.
-	if (endsWithNoCase(filename, ".cso") || endsWithNoCase(filename, ".iso")) {
+	if (endsWithNoCase(filename, ".cso") || endsWithNoCase(filename, ".szo") || endsWithNoCase(filename, ".iso")) {
 		return true;
 	}
 	// May work - but won't have supporting files.
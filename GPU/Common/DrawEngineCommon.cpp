@@ -59,6 +59,42 @@ VertexDecoder *DrawEngineCommon::GetVertexDecoder(u32 vtype) {
 	return dec;
 }
 
+// Way more than any game uses, so a bigger count means the file is corrupt.
+static const u32 MAX_CACHED_VERTEX_DECODERS = 4096;
+
+bool DrawEngineCommon::LoadVertexDecoderCache(FILE *f) {
+	u32 count = 0;
+	if (fread(&count, sizeof(count), 1, f) != 1 || count > MAX_CACHED_VERTEX_DECODERS)
+		return false;
+
+	std::vector<u32> vtypes(count);
+	if (count != 0 && fread(&vtypes[0], sizeof(u32), count, f) != count) {
+		ERROR_LOG(G3D, "Vertex decoder cache truncated");
+		return false;
+	}
+	for (u32 vtype : vtypes) {
+		GetVertexDecoder(vtype);
+	}
+	NOTICE_LOG(G3D, "Precompiled %d vertex decoders", (int)count);
+	return true;
+}
+
+void DrawEngineCommon::SaveVertexDecoderCache(FILE *f) {
+	std::vector<u32> vtypes;
+	vtypes.reserve(decoderMap_.size());
+	decoderMap_.Iterate([&](const uint32_t vtype, VertexDecoder *decoder) {
+		vtypes.push_back(vtype);
+	});
+
+	u32 count = (u32)vtypes.size();
+	bool writeFailed = fwrite(&count, sizeof(count), 1, f) != 1;
+	if (count != 0)
+		writeFailed = writeFailed || fwrite(&vtypes[0], sizeof(u32), count, f) != count;
+	if (writeFailed) {
+		ERROR_LOG(G3D, "Failed to write vertex decoder cache, disk full?");
+	}
+}
+
 int DrawEngineCommon::ComputeNumVertsToDecode() const {
 	int vertsToDecode = 0;
 	if (drawCalls[0].indexType == GE_VTYPE_IDX_NONE >> GE_VTYPE_IDX_SHIFT) {
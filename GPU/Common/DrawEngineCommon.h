@@ -17,6 +17,7 @@
 
 #pragma once
 
+#include <cstdio>
 #include <vector>
 #include <unordered_map>
 
@@ -100,10 +101,20 @@ class DrawEngineCommon {
 
 	VertexDecoder *GetVertexDecoder(u32 vtype);
 
+	// Stores the vertex types seen so far in the backend's shader cache file, so that the
+	// decoders can be JIT compiled at boot instead of on the first draw that needs them.
+	bool LoadVertexDecoderCache(FILE *f);
+	void SaveVertexDecoderCache(FILE *f);
+
 protected:
 	virtual void ClearTrackedVertexArrays() {}
 
 	int ComputeNumVertsToDecode() const;
+	// Worst case for what IndexGenerator outputs for the queued draws: strips, fans and rectangles
+	// take up to three indices per vertex.
+	int ComputeMaxIndicesToGenerate() const {
+		return vertexCountInDrawCalls_ * 3;
+	}
 	void DecodeVerts(u8 *dest);
 
 	// Preprocessing for spline/bezier
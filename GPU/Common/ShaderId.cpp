@@ -173,6 +173,7 @@ std::string FragmentShaderDesc(const FShaderID &id) {
 	if (id.Bit(FS_BIT_FLATSHADE)) desc << "Flat ";
 	if (id.Bit(FS_BIT_BGRA_TEXTURE)) desc << "BGRA ";
 	if (id.Bit(FS_BIT_SHADER_DEPAL)) desc << "Depal ";
+	if (id.Bit(FS_BIT_UBERSHADER)) desc << "Uber ";
 	if (id.Bit(FS_BIT_SHADER_TEX_CLAMP)) {
 		desc << "TClamp";
 		if (id.Bit(FS_BIT_CLAMP_S)) desc << "S";
@@ -225,7 +226,7 @@ std::string FragmentShaderDesc(const FShaderID &id) {
 
 // Here we must take all the bits of the gstate that determine what the fragment shader will
 // look like, and concatenate them together into an ID.
-void ComputeFragmentShaderID(FShaderID *id_out, const Draw::Bugs &bugs) {
+void ComputeFragmentShaderID(FShaderID *id_out, const Draw::Bugs &bugs, bool ubershader) {
 	FShaderID id;
 	if (gstate.isModeClear()) {
 		// We only need one clear shader, so let's ignore the rest of the bits.
@@ -250,9 +251,19 @@ void ComputeFragmentShaderID(FShaderID *id_out, const Draw::Bugs &bugs) {
 		if (gstate_c.textureFullAlpha && gstate.getTextureFunction() != GE_TEXFUNC_REPLACE)
 			doTextureAlpha = false;
 
+		if (ubershader) {
+			// These all come from ComputeFragmentUberState() instead.
+			id.SetBit(FS_BIT_UBERSHADER);
+			doTextureAlpha = false;
+			enableAlphaTest = false;
+			enableColorTest = false;
+			enableColorDoubling = false;
+		}
+
 		if (gstate.isTextureMapEnabled()) {
 			id.SetBit(FS_BIT_DO_TEXTURE);
-			id.SetBits(FS_BIT_TEXFUNC, 3, gstate.getTextureFunction());
+			if (!ubershader)
+				id.SetBits(FS_BIT_TEXFUNC, 3, gstate.getTextureFunction());
 			id.SetBit(FS_BIT_TEXALPHA, doTextureAlpha & 1); // rgb or rgba
 			if (gstate_c.needShaderTexClamp) {
 				bool textureAtOffset = gstate_c.curTextureXOffset != 0 || gstate_c.curTextureYOffset != 0;
@@ -319,3 +330,30 @@ void ComputeFragmentShaderID(FShaderID *id_out, const Draw::Bugs &bugs) {
 
 	*id_out = id;
 }
+
+uint32_t ComputeFragmentUberState() {
+	// Must match the checks in ComputeFragmentShaderID.
+	uint32_t state = 0;
+	if (gstate.isModeClear())
+		return state;
+
+	if (gstate.isTextureMapEnabled()) {
+		bool doTextureAlpha = gstate.isTextureAlphaUsed();
+		if (gstate_c.textureFullAlpha && gstate.getTextureFunction() != GE_TEXFUNC_REPLACE)
+			doTextureAlpha = false;
+		state |= gstate.getTextureFunction() & FS_UBER_TEXFUNC_MASK;
+		if (doTextureAlpha)
+			state |= FS_UBER_TEXALPHA;
+		if (gstate.isColorDoublingEnabled() && gstate.getTextureFunction() == GE_TEXFUNC_MODULATE)
+			state |= FS_UBER_COLOR_DOUBLE;
+	}
+	if (gstate.isAlphaTestEnabled() && !IsAlphaTestTriviallyTrue()) {
+		state |= FS_UBER_ALPHA_TEST;
+		state |= (uint32_t)gstate.getAlphaTestFunction() << FS_UBER_ALPHA_TEST_FUNC_SHIFT;
+	}
+	if (gstate.isColorTestEnabled() && !IsColorTestTriviallyTrue()) {
+		state |= FS_UBER_COLOR_TEST;
+		state |= (uint32_t)gstate.getColorTestFunction() << FS_UBER_COLOR_TEST_FUNC_SHIFT;
+	}
+	return state;
+}
@@ -91,7 +91,20 @@ enum FShaderBit : uint8_t {
 	FS_BIT_BGRA_TEXTURE = 47,
 	FS_BIT_TEST_DISCARD_TO_ZERO = 48,
 	FS_BIT_NO_DEPTH_CANNOT_DISCARD_STENCIL = 49,
-	// 50+ are free.
+	// The texture function, alpha/color tests and color doubling come from a uniform instead.
+	FS_BIT_UBERSHADER = 50,
+	// 51+ are free.
+};
+
+// Packed into the fsUberState uniform for shaders with FS_BIT_UBERSHADER.
+enum FragmentUberState : uint32_t {
+	FS_UBER_TEXFUNC_MASK = 0x7,
+	FS_UBER_TEXALPHA = 1 << 3,
+	FS_UBER_ALPHA_TEST = 1 << 4,
+	FS_UBER_ALPHA_TEST_FUNC_SHIFT = 5,  // 3 bits
+	FS_UBER_COLOR_TEST = 1 << 8,
+	FS_UBER_COLOR_TEST_FUNC_SHIFT = 9,  // 2 bits
+	FS_UBER_COLOR_DOUBLE = 1 << 11,
 };
 
 static inline FShaderBit operator +(FShaderBit bit, int i) {
@@ -228,5 +241,7 @@ void ComputeVertexShaderID(VShaderID *id, uint32_t vertexType, bool useHWTransfo
 // of the current flora of shaders.
 std::string VertexShaderDesc(const VShaderID &id);
 
-void ComputeFragmentShaderID(FShaderID *id, const Draw::Bugs &bugs);
+// With ubershader set, the state in FragmentUberState is left out of the ID, so one shader covers it all.
+void ComputeFragmentShaderID(FShaderID *id, const Draw::Bugs &bugs, bool ubershader = false);
+uint32_t ComputeFragmentUberState();
 std::string FragmentShaderDesc(const FShaderID &id);
@@ -10,6 +10,7 @@
 #include "GPU/GPUState.h"
 #include "GPU/Common/FramebufferCommon.h"
 #include "GPU/Common/GPUStateUtils.h"
+#include "GPU/Common/ShaderId.h"
 #include "GPU/Math3D.h"
 #include "Core/Reporting.h"
 #include "Core/Config.h"
@@ -98,6 +99,9 @@ void BaseUpdateUniforms(UB_VS_FS_Base *ub, uint64_t dirtyUniforms, bool flipView
 	if (dirtyUniforms & DIRTY_ALPHACOLORREF) {
 		Uint8x3ToInt4_Alpha(ub->alphaColorRef, gstate.getColorTestRef(), gstate.getAlphaTestRef() & gstate.getAlphaTestMask());
 	}
+	if (dirtyUniforms & DIRTY_FS_UBERSTATE) {
+		ub->fsUberState = ComputeFragmentUberState();
+	}
 	if (dirtyUniforms & DIRTY_ALPHACOLORMASK) {
 		Uint8x3ToInt4_Alpha(ub->colorTestMask, gstate.getColorTestMask(), gstate.getAlphaTestMask());
 	}
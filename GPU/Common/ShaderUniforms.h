@@ -11,7 +11,7 @@ enum : uint64_t {
 	DIRTY_WORLDMATRIX | DIRTY_PROJTHROUGHMATRIX | DIRTY_VIEWMATRIX | DIRTY_TEXMATRIX | DIRTY_ALPHACOLORREF |
 	DIRTY_PROJMATRIX | DIRTY_FOGCOLOR | DIRTY_FOGCOEF | DIRTY_TEXENV | DIRTY_STENCILREPLACEVALUE |
 	DIRTY_ALPHACOLORMASK | DIRTY_SHADERBLEND | DIRTY_UVSCALEOFFSET | DIRTY_TEXCLAMP | DIRTY_DEPTHRANGE | DIRTY_MATAMBIENTALPHA |
-	DIRTY_BEZIERSPLINE | DIRTY_DEPAL,
+	DIRTY_BEZIERSPLINE | DIRTY_DEPAL | DIRTY_FS_UBERSTATE,
 	DIRTY_LIGHT_UNIFORMS =
 	DIRTY_LIGHT0 | DIRTY_LIGHT1 | DIRTY_LIGHT2 | DIRTY_LIGHT3 |
 	DIRTY_MATDIFFUSE | DIRTY_MATSPECULAR | DIRTY_MATEMISSIVE | DIRTY_AMBIENT,
@@ -31,7 +31,7 @@ struct UB_VS_FS_Base {
 	float fogCoef[2];	float stencil; float pad0;
 	float matAmbient[4];
 	uint32_t spline_counts; uint32_t depal_mask_shift_off_fmt;  // 4 params packed into one.
-	int pad2; int pad3;
+	uint32_t fsUberState; int pad3;  // FragmentUberState bits, only used by the fragment ubershader.
 	float cullRangeMin[4];
 	float cullRangeMax[4];
 	// Fragment data
@@ -58,7 +58,7 @@ R"(  mat4 proj_mtx;
   vec4 matambientalpha;
   uint spline_counts;
   uint depal_mask_shift_off_fmt;
-  int pad2;
+  uint fsUberState;
   int pad3;
   vec4 cullRangeMin;
   vec4 cullRangeMax;
@@ -86,7 +86,7 @@ R"(  float4x4 u_proj;
   float4 u_matambientalpha;
   uint u_spline_counts;
   uint u_depal_mask_shift_off_fmt;
-  int pad2;
+  uint u_fsUberState;
   int pad3;
   float4 u_cullRangeMin;
   float4 u_cullRangeMax;
@@ -18,8 +18,10 @@
 #include <algorithm>
 #include "ppsspp_config.h"
 #include "profiler/profiler.h"
+#include "ext/xxhash.h"
 #include "Common/ColorConv.h"
 #include "Common/MemoryUtil.h"
+#include "Common/ThreadPools.h"
 #include "Core/Config.h"
 #include "Core/Reporting.h"
 #include "Core/System.h"
@@ -446,6 +448,18 @@ void TextureCacheCommon::SetTexture(bool force) {
 			}
 		}
 
+		if (match && (entry->status & TexCacheEntry::STATUS_TO_REPLACE)) {
+			ReplacedTexture &replaced = replacer_.FindReplacement(entry->CacheKey(), entry->fullhash, w, h);
+			if (replaced.IsReady()) {
+				if (replaced.Valid()) {
+					match = false;
+					reason = "replacing";
+				} else {
+					entry->status &= ~TexCacheEntry::STATUS_TO_REPLACE;
+				}
+			}
+		}
+
 		if (match) {
 			// TODO: Mark the entry reliable if it's been safe for long enough?
 			//got one!
@@ -1186,6 +1200,29 @@ static inline void ConvertFormatToRGBA8888(GEPaletteFormat format, u32 *dst, con
 	ConvertFormatToRGBA8888(GETextureFormat(format), dst, src, numPixels);
 }
 
+// Levels smaller than this decode faster on one thread than it takes to wake the others.
+static const int MIN_PARALLEL_DECODE_PIXELS = 256 * 256;
+
+// Calls decode(y1, y2) over bands of rows, spread over the thread pool when the level is large.
+// Bands always start on a multiple of rowAlign, so swizzle and DXT blocks aren't split.
+static void DecodeRowBands(int w, int h, int rowAlign, const std::function<void(int, int)> &decode) {
+	if (w * h < MIN_PARALLEL_DECODE_PIXELS || g_Config.iNumWorkerThreads <= 1) {
+		decode(0, h);
+		return;
+	}
+
+	const int blocks = (h + rowAlign - 1) / rowAlign;
+	GlobalThreadPool::Loop([&](int lower, int upper) {
+		decode(lower * rowAlign, std::min(upper * rowAlign, h));
+	}, 0, blocks);
+}
+
+// Byte offset of row y (a multiple of 8) in swizzled data.  Each row of blocks is contiguous.
+static inline u32 SwizzledRowOffset(int y, u32 bufw, u32 bytesPerPixel) {
+	const u32 rowWidth = (bytesPerPixel > 0) ? (bufw * bytesPerPixel) : (bufw / 2);
+	return y * rowWidth;
+}
+
 void TextureCacheCommon::DecodeTextureLevel(u8 *out, int outPitch, GETextureFormat format, GEPaletteFormat clutformat, uint32_t texaddr, int level, int bufw, bool reverseColors, bool useBGRA, bool expandTo32bit) {
 	bool swizzled = gstate.isTextureSwizzled();
 	if ((texaddr & 0x00600000) != 0 && Memory::IsVRAMAddress(texaddr)) {
@@ -1210,9 +1247,17 @@ void TextureCacheCommon::DecodeTextureLevel(u8 *out, int outPitch, GETextureForm
 
 		if (swizzled) {
 			tmpTexBuf32_.resize(bufw * ((h + 7) & ~7));
-			UnswizzleFromMem(tmpTexBuf32_.data(), bufw / 2, texptr, bufw, h, 0);
-			texptr = (u8 *)tmpTexBuf32_.data();
 		}
+		u8 *unswizzled = (u8 *)tmpTexBuf32_.data();
+		// Each band unswizzles its own rows just before looking them up, while they're in cache.
+		auto indexRows = [&](int y1, int y2) -> const u8 * {
+			if (!swizzled) {
+				return texptr;
+			}
+			const u32 offset = SwizzledRowOffset(y1, bufw, 0);
+			UnswizzleFromMem((u32 *)(unswizzled + offset), bufw / 2, texptr + offset, bufw, y2 - y1, 0);
+			return unswizzled;
+		};
 
 		switch (clutformat) {
 		case GE_CMODE_16BIT_BGR5650:
@@ -1222,26 +1267,38 @@ void TextureCacheCommon::DecodeTextureLevel(u8 *out, int outPitch, GETextureForm
 			if (clutAlphaLinear_ && mipmapShareClut && !expandTo32bit) {
 				// Here, reverseColors means the CLUT is already reversed.
 				if (reverseColors) {
-					for (int y = 0; y < h; ++y) {
-						DeIndexTexture4Optimal((u16 *)(out + outPitch * y), texptr + (bufw * y) / 2, w, clutAlphaLinearColor_);
-					}
+					DecodeRowBands(w, h, 8, [&](int y1, int y2) {
+						const u8 *indexed = indexRows(y1, y2);
+						for (int y = y1; y < y2; ++y) {
+							DeIndexTexture4Optimal((u16 *)(out + outPitch * y), indexed + (bufw * y) / 2, w, clutAlphaLinearColor_);
+						}
+					});
 				} else {
-					for (int y = 0; y < h; ++y) {
-						DeIndexTexture4OptimalRev((u16 *)(out + outPitch * y), texptr + (bufw * y) / 2, w, clutAlphaLinearColor_);
-					}
+					DecodeRowBands(w, h, 8, [&](int y1, int y2) {
+						const u8 *indexed = indexRows(y1, y2);
+						for (int y = y1; y < y2; ++y) {
+							DeIndexTexture4OptimalRev((u16 *)(out + outPitch * y), indexed + (bufw * y) / 2, w, clutAlphaLinearColor_);
+						}
+					});
 				}
 			} else {
 				const u16 *clut = GetCurrentClut<u16>() + clutSharingOffset;
 				if (expandTo32bit && !reverseColors) {
 					// We simply expand the CLUT to 32-bit, then we deindex as usual. Probably the fastest way.
 					ConvertFormatToRGBA8888(clutformat, expandClut_, clut, 16);
-					for (int y = 0; y < h; ++y) {
-						DeIndexTexture4((u32 *)(out + outPitch * y), texptr + (bufw * y) / 2, w, expandClut_);
-					}
+					DecodeRowBands(w, h, 8, [&](int y1, int y2) {
+						const u8 *indexed = indexRows(y1, y2);
+						for (int y = y1; y < y2; ++y) {
+							DeIndexTexture4((u32 *)(out + outPitch * y), indexed + (bufw * y) / 2, w, expandClut_);
+						}
+					});
 				} else {
-					for (int y = 0; y < h; ++y) {
-						DeIndexTexture4((u16 *)(out + outPitch * y), texptr + (bufw * y) / 2, w, clut);
-					}
+					DecodeRowBands(w, h, 8, [&](int y1, int y2) {
+						const u8 *indexed = indexRows(y1, y2);
+						for (int y = y1; y < y2; ++y) {
+							DeIndexTexture4((u16 *)(out + outPitch * y), indexed + (bufw * y) / 2, w, clut);
+						}
+					});
 				}
 			}
 		}
@@ -1250,9 +1307,12 @@ void TextureCacheCommon::DecodeTextureLevel(u8 *out, int outPitch, GETextureForm
 		case GE_CMODE_32BIT_ABGR8888:
 		{
 			const u32 *clut = GetCurrentClut<u32>() + clutSharingOffset;
-			for (int y = 0; y < h; ++y) {
-				DeIndexTexture4((u32 *)(out + outPitch * y), texptr + (bufw * y) / 2, w, clut);
-			}
+			DecodeRowBands(w, h, 8, [&](int y1, int y2) {
+				const u8 *indexed = indexRows(y1, y2);
+				for (int y = y1; y < y2; ++y) {
+					DeIndexTexture4((u32 *)(out + outPitch * y), indexed + (bufw * y) / 2, w, clut);
+				}
+			});
 		}
 		break;
 
@@ -1280,63 +1340,75 @@ void TextureCacheCommon::DecodeTextureLevel(u8 *out, int outPitch, GETextureForm
 	case GE_TFMT_5650:
 		if (!swizzled) {
 			// Just a simple copy, we swizzle the color format.
-			if (reverseColors) {
-				for (int y = 0; y < h; ++y) {
-					ReverseColors(out + outPitch * y, texptr + bufw * sizeof(u16) * y, format, w, useBGRA);
-				}
-			} else if (expandTo32bit) {
-				for (int y = 0; y < h; ++y) {
-					ConvertFormatToRGBA8888(format, (u32 *)(out + outPitch * y), (const u16 *)texptr + bufw * y, w);
-				}
-			} else {
-				for (int y = 0; y < h; ++y) {
-					memcpy(out + outPitch * y, texptr + bufw * sizeof(u16) * y, w * sizeof(u16));
+			DecodeRowBands(w, h, 1, [&](int y1, int y2) {
+				if (reverseColors) {
+					for (int y = y1; y < y2; ++y) {
+						ReverseColors(out + outPitch * y, texptr + bufw * sizeof(u16) * y, format, w, useBGRA);
+					}
+				} else if (expandTo32bit) {
+					for (int y = y1; y < y2; ++y) {
+						ConvertFormatToRGBA8888(format, (u32 *)(out + outPitch * y), (const u16 *)texptr + bufw * y, w);
+					}
+				} else {
+					for (int y = y1; y < y2; ++y) {
+						memcpy(out + outPitch * y, texptr + bufw * sizeof(u16) * y, w * sizeof(u16));
+					}
 				}
-			}
+			});
 		} else if (h >= 8 && !expandTo32bit) {
 			// Note: this is always safe since h must be a power of 2, so a multiple of 8.
-			UnswizzleFromMem((u32 *)out, outPitch, texptr, bufw, h, 2);
-			if (reverseColors) {
-				ReverseColors(out, out, format, h * outPitch / 2, useBGRA);
-			}
+			DecodeRowBands(w, h, 8, [&](int y1, int y2) {
+				UnswizzleFromMem((u32 *)(out + outPitch * y1), outPitch, texptr + SwizzledRowOffset(y1, bufw, 2), bufw, y2 - y1, 2);
+				if (reverseColors) {
+					ReverseColors(out + outPitch * y1, out + outPitch * y1, format, (y2 - y1) * outPitch / 2, useBGRA);
+				}
+			});
 		} else {
 			// We don't have enough space for all rows in out, so use a temp buffer.
 			tmpTexBuf32_.resize(bufw * ((h + 7) & ~7));
-			UnswizzleFromMem(tmpTexBuf32_.data(), bufw * 2, texptr, bufw, h, 2);
-			const u8 *unswizzled = (u8 *)tmpTexBuf32_.data();
+			u8 *unswizzled = (u8 *)tmpTexBuf32_.data();
 
-			if (reverseColors) {
-				for (int y = 0; y < h; ++y) {
-					ReverseColors(out + outPitch * y, unswizzled + bufw * sizeof(u16) * y, format, w, useBGRA);
-				}
-			} else if (expandTo32bit) {
-				for (int y = 0; y < h; ++y) {
-					ConvertFormatToRGBA8888(format, (u32 *)(out + outPitch * y), (const u16 *)unswizzled + bufw * y, w);
-				}
-			} else {
-				for (int y = 0; y < h; ++y) {
-					memcpy(out + outPitch * y, unswizzled + bufw * sizeof(u16) * y, w * sizeof(u16));
+			DecodeRowBands(w, h, 8, [&](int y1, int y2) {
+				const u32 offset = SwizzledRowOffset(y1, bufw, 2);
+				UnswizzleFromMem((u32 *)(unswizzled + offset), bufw * 2, texptr + offset, bufw, y2 - y1, 2);
+
+				if (reverseColors) {
+					for (int y = y1; y < y2; ++y) {
+						ReverseColors(out + outPitch * y, unswizzled + bufw * sizeof(u16) * y, format, w, useBGRA);
+					}
+				} else if (expandTo32bit) {
+					for (int y = y1; y < y2; ++y) {
+						ConvertFormatToRGBA8888(format, (u32 *)(out + outPitch * y), (const u16 *)unswizzled + bufw * y, w);
+					}
+				} else {
+					for (int y = y1; y < y2; ++y) {
+						memcpy(out + outPitch * y, unswizzled + bufw * sizeof(u16) * y, w * sizeof(u16));
+					}
 				}
-			}
+			});
 		}
 		break;
 
 	case GE_TFMT_8888:
 		if (!swizzled) {
-			if (reverseColors) {
-				for (int y = 0; y < h; ++y) {
-					ReverseColors(out + outPitch * y, texptr + bufw * sizeof(u32) * y, format, w, useBGRA);
-				}
-			} else {
-				for (int y = 0; y < h; ++y) {
-					memcpy(out + outPitch * y, texptr + bufw * sizeof(u32) * y, w * sizeof(u32));
+			DecodeRowBands(w, h, 1, [&](int y1, int y2) {
+				if (reverseColors) {
+					for (int y = y1; y < y2; ++y) {
+						ReverseColors(out + outPitch * y, texptr + bufw * sizeof(u32) * y, format, w, useBGRA);
+					}
+				} else {
+					for (int y = y1; y < y2; ++y) {
+						memcpy(out + outPitch * y, texptr + bufw * sizeof(u32) * y, w * sizeof(u32));
+					}
 				}
-			}
+			});
 		} else if (h >= 8) {
-			UnswizzleFromMem((u32 *)out, outPitch, texptr, bufw, h, 4);
-			if (reverseColors) {
-				ReverseColors(out, out, format, h * outPitch / 4, useBGRA);
-			}
+			DecodeRowBands(w, h, 8, [&](int y1, int y2) {
+				UnswizzleFromMem((u32 *)(out + outPitch * y1), outPitch, texptr + SwizzledRowOffset(y1, bufw, 4), bufw, y2 - y1, 4);
+				if (reverseColors) {
+					ReverseColors(out + outPitch * y1, out + outPitch * y1, format, (y2 - y1) * outPitch / 4, useBGRA);
+				}
+			});
 		} else {
 			// We don't have enough space for all rows in out, so use a temp buffer.
 			tmpTexBuf32_.resize(bufw * ((h + 7) & ~7));
@@ -1362,18 +1434,20 @@ void TextureCacheCommon::DecodeTextureLevel(u8 *out, int outPitch, GETextureForm
 		int outPitch32 = outPitch / sizeof(u32);
 		DXT1Block *src = (DXT1Block*)texptr;
 
-		for (int y = 0; y < h; y += 4) {
-			u32 blockIndex = (y / 4) * (bufw / 4);
-			int blockHeight = std::min(h - y, 4);
-			for (int x = 0; x < minw; x += 4) {
-				DecodeDXT1Block(dst + outPitch32 * y + x, src + blockIndex, outPitch32, blockHeight, false);
-				blockIndex++;
+		DecodeRowBands(w, h, 4, [&](int y1, int y2) {
+			for (int y = y1; y < y2; y += 4) {
+				u32 blockIndex = (y / 4) * (bufw / 4);
+				int blockHeight = std::min(h - y, 4);
+				for (int x = 0; x < minw; x += 4) {
+					DecodeDXT1Block(dst + outPitch32 * y + x, src + blockIndex, outPitch32, blockHeight, false);
+					blockIndex++;
+				}
 			}
-		}
+			if (reverseColors) {
+				ReverseColors(dst + outPitch32 * y1, dst + outPitch32 * y1, GE_TFMT_8888, outPitch32 * (y2 - y1), useBGRA);
+			}
+		});
 		w = (w + 3) & ~3;
-		if (reverseColors) {
-			ReverseColors(out, out, GE_TFMT_8888, outPitch32 * h, useBGRA);
-		}
 		break;
 	}
 
@@ -1384,18 +1458,20 @@ void TextureCacheCommon::DecodeTextureLevel(u8 *out, int outPitch, GETextureForm
 		int outPitch32 = outPitch / sizeof(u32);
 		DXT3Block *src = (DXT3Block*)texptr;
 
-		for (int y = 0; y < h; y += 4) {
-			u32 blockIndex = (y / 4) * (bufw / 4);
-			int blockHeight = std::min(h - y, 4);
-			for (int x = 0; x < minw; x += 4) {
-				DecodeDXT3Block(dst + outPitch32 * y + x, src + blockIndex, outPitch32, blockHeight);
-				blockIndex++;
+		DecodeRowBands(w, h, 4, [&](int y1, int y2) {
+			for (int y = y1; y < y2; y += 4) {
+				u32 blockIndex = (y / 4) * (bufw / 4);
+				int blockHeight = std::min(h - y, 4);
+				for (int x = 0; x < minw; x += 4) {
+					DecodeDXT3Block(dst + outPitch32 * y + x, src + blockIndex, outPitch32, blockHeight);
+					blockIndex++;
+				}
 			}
-		}
+			if (reverseColors) {
+				ReverseColors(dst + outPitch32 * y1, dst + outPitch32 * y1, GE_TFMT_8888, outPitch32 * (y2 - y1), useBGRA);
+			}
+		});
 		w = (w + 3) & ~3;
-		if (reverseColors) {
-			ReverseColors(out, out, GE_TFMT_8888, outPitch32 * h, useBGRA);
-		}
 		break;
 	}
 
@@ -1406,18 +1482,20 @@ void TextureCacheCommon::DecodeTextureLevel(u8 *out, int outPitch, GETextureForm
 		int outPitch32 = outPitch / sizeof(u32);
 		DXT5Block *src = (DXT5Block*)texptr;
 
-		for (int y = 0; y < h; y += 4) {
-			u32 blockIndex = (y / 4) * (bufw / 4);
-			int blockHeight = std::min(h - y, 4);
-			for (int x = 0; x < minw; x += 4) {
-				DecodeDXT5Block(dst + outPitch32 * y + x, src + blockIndex, outPitch32, blockHeight);
-				blockIndex++;
+		DecodeRowBands(w, h, 4, [&](int y1, int y2) {
+			for (int y = y1; y < y2; y += 4) {
+				u32 blockIndex = (y / 4) * (bufw / 4);
+				int blockHeight = std::min(h - y, 4);
+				for (int x = 0; x < minw; x += 4) {
+					DecodeDXT5Block(dst + outPitch32 * y + x, src + blockIndex, outPitch32, blockHeight);
+					blockIndex++;
+				}
 			}
-		}
+			if (reverseColors) {
+				ReverseColors(dst + outPitch32 * y1, dst + outPitch32 * y1, GE_TFMT_8888, outPitch32 * (y2 - y1), useBGRA);
+			}
+		});
 		w = (w + 3) & ~3;
-		if (reverseColors) {
-			ReverseColors(out, out, GE_TFMT_8888, outPitch32 * h, useBGRA);
-		}
 		break;
 	}
 
@@ -1431,11 +1509,11 @@ void TextureCacheCommon::ReadIndexedTex(u8 *out, int outPitch, int level, const
 	int w = gstate.getTextureWidth(level);
 	int h = gstate.getTextureHeight(level);
 
-	if (gstate.isTextureSwizzled()) {
+	const bool swizzled = gstate.isTextureSwizzled();
+	if (swizzled) {
 		tmpTexBuf32_.resize(bufw * ((h + 7) & ~7));
-		UnswizzleFromMem(tmpTexBuf32_.data(), bufw * bytesPerIndex, texptr, bufw, h, bytesPerIndex);
-		texptr = (u8 *)tmpTexBuf32_.data();
 	}
+	u8 *unswizzled = (u8 *)tmpTexBuf32_.data();
 
 	int palFormat = gstate.getClutPaletteFormat();
 
@@ -1448,61 +1526,62 @@ void TextureCacheCommon::ReadIndexedTex(u8 *out, int outPitch, int level, const
 		palFormat = GE_CMODE_32BIT_ABGR8888;
 	}
 
-	switch (palFormat) {
-	case GE_CMODE_16BIT_BGR5650:
-	case GE_CMODE_16BIT_ABGR5551:
-	case GE_CMODE_16BIT_ABGR4444:
-	{
-		switch (bytesPerIndex) {
-		case 1:
-			for (int y = 0; y < h; ++y) {
-				DeIndexTexture((u16 *)(out + outPitch * y), (const u8 *)texptr + bufw * y, w, clut16);
-			}
-			break;
-
-		case 2:
-			for (int y = 0; y < h; ++y) {
-				DeIndexTexture((u16 *)(out + outPitch * y), (const u16_le *)texptr + bufw * y, w, clut16);
-			}
-			break;
+	if (palFormat != GE_CMODE_32BIT_ABGR8888 && palFormat != GE_CMODE_16BIT_BGR5650 && palFormat != GE_CMODE_16BIT_ABGR5551 && palFormat != GE_CMODE_16BIT_ABGR4444) {
+		ERROR_LOG_REPORT(G3D, "Unhandled clut texture mode %d!!!", gstate.getClutPaletteFormat());
+		return;
+	}
 
-		case 4:
-			for (int y = 0; y < h; ++y) {
-				DeIndexTexture((u16 *)(out + outPitch * y), (const u32_le *)texptr + bufw * y, w, clut16);
-			}
-			break;
+	DecodeRowBands(w, h, 8, [&](int y1, int y2) {
+		const u8 *indexed = texptr;
+		if (swizzled) {
+			// Unswizzle just this band, so it's still in cache when we look it up.
+			const u32 offset = SwizzledRowOffset(y1, bufw, bytesPerIndex);
+			UnswizzleFromMem((u32 *)(unswizzled + offset), bufw * bytesPerIndex, texptr + offset, bufw, y2 - y1, bytesPerIndex);
+			indexed = unswizzled;
 		}
-	}
-	break;
 
-	case GE_CMODE_32BIT_ABGR8888:
-	{
-		switch (bytesPerIndex) {
-		case 1:
-			for (int y = 0; y < h; ++y) {
-				DeIndexTexture((u32 *)(out + outPitch * y), (const u8 *)texptr + bufw * y, w, clut32);
-			}
-			break;
+		if (palFormat == GE_CMODE_32BIT_ABGR8888) {
+			switch (bytesPerIndex) {
+			case 1:
+				for (int y = y1; y < y2; ++y) {
+					DeIndexTexture((u32 *)(out + outPitch * y), (const u8 *)indexed + bufw * y, w, clut32);
+				}
+				break;
+
+			case 2:
+				for (int y = y1; y < y2; ++y) {
+					DeIndexTexture((u32 *)(out + outPitch * y), (const u16_le *)indexed + bufw * y, w, clut32);
+				}
+				break;
 
-		case 2:
-			for (int y = 0; y < h; ++y) {
-				DeIndexTexture((u32 *)(out + outPitch * y), (const u16_le *)texptr + bufw * y, w, clut32);
+			case 4:
+				for (int y = y1; y < y2; ++y) {
+					DeIndexTexture((u32 *)(out + outPitch * y), (const u32_le *)indexed + bufw * y, w, clut32);
+				}
+				break;
 			}
-			break;
+		} else {
+			switch (bytesPerIndex) {
+			case 1:
+				for (int y = y1; y < y2; ++y) {
+					DeIndexTexture((u16 *)(out + outPitch * y), (const u8 *)indexed + bufw * y, w, clut16);
+				}
+				break;
 
-		case 4:
-			for (int y = 0; y < h; ++y) {
-				DeIndexTexture((u32 *)(out + outPitch * y), (const u32_le *)texptr + bufw * y, w, clut32);
+			case 2:
+				for (int y = y1; y < y2; ++y) {
+					DeIndexTexture((u16 *)(out + outPitch * y), (const u16_le *)indexed + bufw * y, w, clut16);
+				}
+				break;
+
+			case 4:
+				for (int y = y1; y < y2; ++y) {
+					DeIndexTexture((u16 *)(out + outPitch * y), (const u32_le *)indexed + bufw * y, w, clut16);
+				}
+				break;
 			}
-			break;
 		}
-	}
-	break;
-
-	default:
-		ERROR_LOG_REPORT(G3D, "Unhandled clut texture mode %d!!!", gstate.getClutPaletteFormat());
-		break;
-	}
+	});
 }
 
 void TextureCacheCommon::ApplyTexture() {
@@ -1597,6 +1676,31 @@ void TextureCacheCommon::DeleteTexture(TexCache::iterator it) {
 	cache_.erase(it);
 }
 
+ReplacedTexture &TextureCacheCommon::FindReplacement(TexCacheEntry *entry, u64 cachekey, int w, int h) {
+	ReplacedTexture &replaced = replacer_.FindReplacement(cachekey, entry->fullhash, w, h);
+	if (replaced.IsReady()) {
+		entry->status &= ~TexCacheEntry::STATUS_TO_REPLACE;
+		return replaced;
+	}
+
+	// Don't count the swap as a change, or we'd stop scaling it.
+	entry->status |= TexCacheEntry::STATUS_TO_REPLACE | TexCacheEntry::STATUS_FREE_CHANGE;
+	return replacer_.NoReplacement();
+}
+
+u64 TextureCacheCommon::ScaleCacheKey(const TexCacheEntry &entry, int level) const {
+	// Videos and such would just fill the cache with frames that won't come back.
+	if (!g_Config.bTexScalingDiskCache || (entry.status & TexCacheEntry::STATUS_CHANGE_FREQUENT) != 0) {
+		return 0;
+	}
+
+	u64 key[2];
+	key[0] = entry.CacheKey();
+	key[1] = ((u64)entry.fullhash << 32) | (u32)level;
+	const u64 hash = XXH64(key, sizeof(key), 0);
+	return hash != 0 ? hash : 1;
+}
+
 bool TextureCacheCommon::CheckFullHash(TexCacheEntry *entry, bool &doDelete) {
 	int w = gstate.getTextureWidth(0);
 	int h = gstate.getTextureHeight(0);
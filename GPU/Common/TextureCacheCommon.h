@@ -119,6 +119,7 @@ struct TexCacheEntry {
 		STATUS_FREE_CHANGE = 0x200,    // Allow one change before marking "frequent".
 
 		STATUS_BAD_MIPS = 0x400,       // Has bad or unusable mipmap levels.
+		STATUS_TO_REPLACE = 0x800,     // Pending replacement texture load, using the original for now.
 	};
 
 	// Status, but int so we can zero initialize.
@@ -227,6 +228,10 @@ class TextureCacheCommon {
 	virtual void BuildTexture(TexCacheEntry *const entry) = 0;
 	virtual void UpdateCurrentClut(GEPaletteFormat clutFormat, u32 clutBase, bool clutIndexIsSimple) = 0;
 	bool CheckFullHash(TexCacheEntry *entry, bool &doDelete);
+	// Returns no replacement while it's still loading, and marks the entry to rebuild once loaded.
+	ReplacedTexture &FindReplacement(TexCacheEntry *entry, u64 cachekey, int w, int h);
+	// Identifies a level for the scaled texture disk cache, or 0 if it shouldn't be cached.
+	u64 ScaleCacheKey(const TexCacheEntry &entry, int level) const;
 
 	// Separate to keep main texture cache size down.
 	struct AttachedFramebufferInfo {
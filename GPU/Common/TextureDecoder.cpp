@@ -29,6 +29,9 @@
 
 #ifdef _M_SSE
 #include <emmintrin.h>
+#if _M_SSE >= 0x301
+#include <tmmintrin.h>
+#endif
 #if _M_SSE >= 0x401
 #include <smmintrin.h>
 #endif
@@ -307,6 +310,115 @@ void DoUnswizzleTex16Basic(const u8 *texptr, u32 *ydestp, int bxc, int byc, u32
 	}
 }
 
+#ifdef _M_SSE
+// Splits 16 bytes of 4-bit indices into 32 byte indices, in pixel order (low nibble first.)
+static inline void SplitIndex4SSE2(const __m128i &packed, __m128i &first, __m128i &second) {
+	const __m128i mask = _mm_set1_epi8(0x0F);
+	const __m128i lo = _mm_and_si128(packed, mask);
+	const __m128i hi = _mm_and_si128(_mm_srli_epi16(packed, 4), mask);
+	first = _mm_unpacklo_epi8(lo, hi);
+	second = _mm_unpackhi_epi8(lo, hi);
+}
+
+template <int shift>
+static inline void DeIndexTexture4OptimalSSE2Impl(u16 *dest, const u8 *indexed, int length, u16 color) {
+	const __m128i zero = _mm_setzero_si128();
+	const __m128i color16 = _mm_set1_epi16(color);
+	const __m128i *src = (const __m128i *)indexed;
+	__m128i *dst = (__m128i *)dest;
+	for (int i = 0; i < length; i += 32) {
+		__m128i first, second;
+		SplitIndex4SSE2(_mm_loadu_si128(src++), first, second);
+		_mm_storeu_si128(dst++, _mm_or_si128(color16, _mm_slli_epi16(_mm_unpacklo_epi8(first, zero), shift)));
+		_mm_storeu_si128(dst++, _mm_or_si128(color16, _mm_slli_epi16(_mm_unpackhi_epi8(first, zero), shift)));
+		_mm_storeu_si128(dst++, _mm_or_si128(color16, _mm_slli_epi16(_mm_unpacklo_epi8(second, zero), shift)));
+		_mm_storeu_si128(dst++, _mm_or_si128(color16, _mm_slli_epi16(_mm_unpackhi_epi8(second, zero), shift)));
+	}
+}
+
+void DeIndexTexture4OptimalSSE2(u16 *dest, const u8 *indexed, int length, u16 color) {
+	DeIndexTexture4OptimalSSE2Impl<0>(dest, indexed, length, color);
+}
+
+void DeIndexTexture4OptimalRevSSE2(u16 *dest, const u8 *indexed, int length, u16 color) {
+	// Reversed, the index lands in the top nibble instead.
+	DeIndexTexture4OptimalSSE2Impl<12>(dest, indexed, length, color);
+}
+
+#if _M_SSE >= 0x301
+// With only 16 entries, each byte of the CLUT fits in one register, so pshufb does the lookup.
+static inline void WriteLookup16SSSE3(__m128i *dest, const __m128i &index, const __m128i &clutLo, const __m128i &clutHi) {
+	const __m128i lo = _mm_shuffle_epi8(clutLo, index);
+	const __m128i hi = _mm_shuffle_epi8(clutHi, index);
+	_mm_storeu_si128(dest, _mm_unpacklo_epi8(lo, hi));
+	_mm_storeu_si128(dest + 1, _mm_unpackhi_epi8(lo, hi));
+}
+
+static inline void WriteLookup32SSSE3(__m128i *dest, const __m128i &index, const __m128i *planes) {
+	const __m128i b0 = _mm_shuffle_epi8(planes[0], index);
+	const __m128i b1 = _mm_shuffle_epi8(planes[1], index);
+	const __m128i b2 = _mm_shuffle_epi8(planes[2], index);
+	const __m128i b3 = _mm_shuffle_epi8(planes[3], index);
+	const __m128i lo01 = _mm_unpacklo_epi8(b0, b1);
+	const __m128i lo23 = _mm_unpacklo_epi8(b2, b3);
+	const __m128i hi01 = _mm_unpackhi_epi8(b0, b1);
+	const __m128i hi23 = _mm_unpackhi_epi8(b2, b3);
+	_mm_storeu_si128(dest, _mm_unpacklo_epi16(lo01, lo23));
+	_mm_storeu_si128(dest + 1, _mm_unpackhi_epi16(lo01, lo23));
+	_mm_storeu_si128(dest + 2, _mm_unpacklo_epi16(hi01, hi23));
+	_mm_storeu_si128(dest + 3, _mm_unpackhi_epi16(hi01, hi23));
+}
+
+void DeIndexTexture4SSSE3(u16 *dest, const u8 *indexed, int length, const u16 *clut) {
+	// Separate the low and high bytes of each entry into their own tables.
+	const __m128i evenOdd = _mm_setr_epi8(0, 2, 4, 6, 8, 10, 12, 14, 1, 3, 5, 7, 9, 11, 13, 15);
+	const __m128i clutA = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *)clut), evenOdd);
+	const __m128i clutB = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *)clut + 1), evenOdd);
+	const __m128i clutLo = _mm_unpacklo_epi64(clutA, clutB);
+	const __m128i clutHi = _mm_unpackhi_epi64(clutA, clutB);
+
+	const __m128i *src = (const __m128i *)indexed;
+	__m128i *dst = (__m128i *)dest;
+	for (int i = 0; i < length; i += 32) {
+		__m128i first, second;
+		SplitIndex4SSE2(_mm_loadu_si128(src++), first, second);
+		WriteLookup16SSSE3(dst, first, clutLo, clutHi);
+		WriteLookup16SSSE3(dst + 2, second, clutLo, clutHi);
+		dst += 4;
+	}
+}
+
+void DeIndexTexture4SSSE3(u32 *dest, const u8 *indexed, int length, const u32 *clut) {
+	// Gather each byte of the 4 entries in a register together, then transpose so that each
+	// register holds one byte of all 16 entries.
+	const __m128i gather = _mm_setr_epi8(0, 4, 8, 12, 1, 5, 9, 13, 2, 6, 10, 14, 3, 7, 11, 15);
+	const __m128i t0 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *)clut + 0), gather);
+	const __m128i t1 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *)clut + 1), gather);
+	const __m128i t2 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *)clut + 2), gather);
+	const __m128i t3 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *)clut + 3), gather);
+	const __m128i u0 = _mm_unpacklo_epi32(t0, t1);
+	const __m128i u1 = _mm_unpacklo_epi32(t2, t3);
+	const __m128i u2 = _mm_unpackhi_epi32(t0, t1);
+	const __m128i u3 = _mm_unpackhi_epi32(t2, t3);
+	__m128i planes[4];
+	planes[0] = _mm_unpacklo_epi64(u0, u1);
+	planes[1] = _mm_unpackhi_epi64(u0, u1);
+	planes[2] = _mm_unpacklo_epi64(u2, u3);
+	planes[3] = _mm_unpackhi_epi64(u2, u3);
+
+	const __m128i *src = (const __m128i *)indexed;
+	__m128i *dst = (__m128i *)dest;
+	for (int i = 0; i < length; i += 32) {
+		__m128i first, second;
+		SplitIndex4SSE2(_mm_loadu_si128(src++), first, second);
+		WriteLookup32SSSE3(dst, first, planes);
+		WriteLookup32SSSE3(dst + 4, second, planes);
+		dst += 8;
+	}
+}
+#endif
+#endif
+
 #if !PPSSPP_ARCH(ARM64) && !defined(_M_SSE)
 QuickTexHashFunc DoQuickTexHash = &QuickTexHashBasic;
 QuickTexHashFunc StableQuickTexHash = &QuickTexHashNonSSE;
@@ -140,6 +140,17 @@ static const u8 textureBitsPerPixel[16] = {
 
 u32 GetTextureBufw(int level, u32 texaddr, GETextureFormat format);
 
+// These all handle 32 pixels at a time, so length must be a multiple of 32.
+#ifdef _M_SSE
+void DeIndexTexture4OptimalSSE2(u16 *dest, const u8 *indexed, int length, u16 color);
+void DeIndexTexture4OptimalRevSSE2(u16 *dest, const u8 *indexed, int length, u16 color);
+#if _M_SSE >= 0x301
+// Only for naked indices, the whole 16 entry CLUT fits in registers.
+void DeIndexTexture4SSSE3(u16 *dest, const u8 *indexed, int length, const u16 *clut);
+void DeIndexTexture4SSSE3(u32 *dest, const u8 *indexed, int length, const u32 *clut);
+#endif
+#endif
+
 template <typename IndexT, typename ClutT>
 inline void DeIndexTexture(ClutT *dest, const IndexT *indexed, int length, const ClutT *clut) {
 	// Usually, there is no special offset, mask, or shift.
@@ -174,6 +185,12 @@ inline void DeIndexTexture4(ClutT *dest, const u8 *indexed, int length, const Cl
 	const bool nakedIndex = gstate.isClutIndexSimple();
 
 	if (nakedIndex) {
+#if defined(_M_SSE) && _M_SSE >= 0x301
+		if ((length & 31) == 0) {
+			DeIndexTexture4SSSE3(dest, indexed, length, clut);
+			return;
+		}
+#endif
 		for (int i = 0; i < length; i += 2) {
 			u8 index = *indexed++;
 			dest[i + 0] = clut[(index >> 0) & 0xf];
@@ -199,6 +216,12 @@ inline void DeIndexTexture4Optimal(ClutT *dest, const u8 *indexed, int length, C
 
 template <>
 inline void DeIndexTexture4Optimal<u16>(u16 *dest, const u8 *indexed, int length, u16 color) {
+#ifdef _M_SSE
+	if ((length & 31) == 0) {
+		DeIndexTexture4OptimalSSE2(dest, indexed, length, color);
+		return;
+	}
+#endif
 	const u16_le *indexed16 = (const u16_le *)indexed;
 	const u32 color32 = (color << 16) | color;
 	u32 *dest32 = (u32 *)dest;
@@ -210,6 +233,12 @@ inline void DeIndexTexture4Optimal<u16>(u16 *dest, const u8 *indexed, int length
 }
 
 inline void DeIndexTexture4OptimalRev(u16 *dest, const u8 *indexed, int length, u16 color) {
+#ifdef _M_SSE
+	if ((length & 31) == 0) {
+		DeIndexTexture4OptimalRevSSE2(dest, indexed, length, color);
+		return;
+	}
+#endif
 	const u16_le *indexed16 = (const u16_le *)indexed;
 	const u32 color32 = (color << 16) | color;
 	u32 *dest32 = (u32 *)dest;
@@ -0,0 +1,279 @@
+// Copyright (c) 2012- PPSSPP Project.
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, version 2.0 or later versions.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License 2.0 for more details.
+
+// A copy of the GPL 2.0 should have been included with the program.
+// If not, see http://www.gnu.org/licenses/
+
+// Official git repository and contact information can be found at
+// https://github.com/hrydgard/ppsspp and http://www.ppsspp.org/.
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <iterator>
+#include <snappy-c.h>
+
+#include "file/file_util.h"
+#include "Common/FileUtil.h"
+#include "Common/Log.h"
+#include "Core/Config.h"
+#include "Core/System.h"
+#include "Core/ELF/ParamSFO.h"
+#include "GPU/Common/TextureScaleCache.h"
+
+static const char INDEX_MAGIC[4] = { 'P', 'P', 'S', 'I' };
+static const char TEXTURE_MAGIC[4] = { 'P', 'P', 'S', 'T' };
+static const u32 CACHE_VERSION = 1;
+// Anything bigger is a corrupt index.
+static const u32 MAX_INDEX_ENTRIES = 1 << 20;
+
+struct ScaleCacheIndexHeader {
+	char magic[4];
+	u32 version;
+	u32 count;
+	u32 reserved;
+};
+
+struct ScaleCacheIndexEntry {
+	u64 key;
+	u64 size;
+};
+
+struct ScaleCacheTextureHeader {
+	char magic[4];
+	u32 version;
+	u32 w;
+	u32 h;
+};
+
+TextureScaleCache::~TextureScaleCache() {
+	if (dirty_) {
+		SaveIndex();
+	}
+}
+
+bool TextureScaleCache::Load(u64 key, u32 *out, int w, int h) {
+	Open();
+
+	auto it = entries_.find(key);
+	if (it == entries_.end()) {
+		return false;
+	}
+	if (!ReadTexture(key, out, w, h)) {
+		WARN_LOG(G3D, "Dropping unreadable scaled texture %s", Filename(key).c_str());
+		File::Delete(Filename(key));
+		Remove(key);
+		return false;
+	}
+
+	// Now the most recently used.
+	lru_.splice(lru_.end(), lru_, it->second.pos);
+	dirty_ = true;
+	return true;
+}
+
+void TextureScaleCache::Save(u64 key, const u32 *data, int w, int h) {
+	Open();
+
+	const size_t rawSize = (size_t)w * h * sizeof(u32);
+	size_t compressedSize = snappy_max_compressed_length(rawSize);
+	buffer_.resize(sizeof(ScaleCacheTextureHeader) + compressedSize);
+	if (snappy_compress((const char *)data, rawSize, &buffer_[sizeof(ScaleCacheTextureHeader)], &compressedSize) != SNAPPY_OK) {
+		return;
+	}
+
+	ScaleCacheTextureHeader header{};
+	memcpy(header.magic, TEXTURE_MAGIC, sizeof(TEXTURE_MAGIC));
+	header.version = CACHE_VERSION;
+	header.w = w;
+	header.h = h;
+	memcpy(&buffer_[0], &header, sizeof(header));
+
+	const std::string filename = Filename(key);
+	const size_t fileSize = sizeof(header) + compressedSize;
+	FILE *f = File::OpenCFile(filename, "wb");
+	if (!f) {
+		return;
+	}
+	bool success = fwrite(&buffer_[0], 1, fileSize, f) == fileSize;
+	success = fclose(f) == 0 && success;
+	if (!success) {
+		// Probably out of space, don't leave a partial file around.
+		WARN_LOG(G3D, "Unable to save scaled texture %s", filename.c_str());
+		File::Delete(filename);
+		Remove(key);
+		return;
+	}
+
+	Add(key, fileSize);
+	Evict();
+}
+
+void TextureScaleCache::Open() {
+	if (opened_) {
+		return;
+	}
+	opened_ = true;
+
+	std::string discID = g_paramSFO.GetDiscID();
+	if (discID.empty()) {
+		discID = "_other";
+	}
+	dir_ = GetSysDirectory(DIRECTORY_APP_CACHE) + "/scaled/" + discID + "/";
+	File::CreateFullPath(dir_);
+
+	LoadIndex();
+	// In case the limit was lowered since last time.
+	Evict();
+}
+
+void TextureScaleCache::LoadIndex() {
+	// Start from the files actually on disk, in case the index is stale (say, after a crash.)
+	std::vector<FileInfo> files;
+	getFilesInDir(dir_.c_str(), &files, "scaled");
+	std::unordered_map<u64, std::string> onDisk;
+	for (const FileInfo &info : files) {
+		unsigned long long key;
+		if (!info.isDirectory && sscanf(info.name.c_str(), "%016llx.scaled", &key) == 1) {
+			onDisk[key] = info.fullName;
+		}
+	}
+
+	std::vector<ScaleCacheIndexEntry> indexed;
+	FILE *f = File::OpenCFile(dir_ + "index", "rb");
+	if (f) {
+		ScaleCacheIndexHeader header;
+		if (fread(&header, sizeof(header), 1, f) == 1 && memcmp(header.magic, INDEX_MAGIC, sizeof(INDEX_MAGIC)) == 0 && header.version == CACHE_VERSION && header.count <= MAX_INDEX_ENTRIES) {
+			indexed.resize(header.count);
+			if (header.count != 0 && fread(&indexed[0], sizeof(ScaleCacheIndexEntry), header.count, f) != header.count) {
+				indexed.clear();
+			}
+		}
+		fclose(f);
+	}
+
+	// Keep the index order for files that still exist.
+	std::vector<ScaleCacheIndexEntry> ordered;
+	ordered.reserve(indexed.size());
+	for (const ScaleCacheIndexEntry &entry : indexed) {
+		auto it = onDisk.find(entry.key);
+		if (it != onDisk.end()) {
+			ordered.push_back(entry);
+			onDisk.erase(it);
+		}
+	}
+
+	// Files the index didn't know about are treated as the oldest.
+	for (const auto &file : onDisk) {
+		Add(file.first, File::GetFileSize(file.second));
+	}
+	for (const ScaleCacheIndexEntry &entry : ordered) {
+		Add(entry.key, entry.size);
+	}
+	dirty_ = !onDisk.empty() || ordered.size() != indexed.size();
+
+	INFO_LOG(G3D, "Scaled texture cache: %d textures, %lld KB", (int)entries_.size(), (long long)(totalSize_ / 1024));
+}
+
+void TextureScaleCache::SaveIndex() {
+	std::vector<ScaleCacheIndexEntry> indexed;
+	indexed.reserve(lru_.size());
+	for (u64 key : lru_) {
+		indexed.push_back(ScaleCacheIndexEntry{ key, entries_[key].size });
+	}
+
+	ScaleCacheIndexHeader header{};
+	memcpy(header.magic, INDEX_MAGIC, sizeof(INDEX_MAGIC));
+	header.version = CACHE_VERSION;
+	header.count = (u32)indexed.size();
+
+	FILE *f = File::OpenCFile(dir_ + "index", "wb");
+	if (!f) {
+		return;
+	}
+	bool success = fwrite(&header, sizeof(header), 1, f) == 1;
+	if (!indexed.empty()) {
+		success = success && fwrite(&indexed[0], sizeof(ScaleCacheIndexEntry), indexed.size(), f) == indexed.size();
+	}
+	success = fclose(f) == 0 && success;
+	if (success) {
+		dirty_ = false;
+	} else {
+		// Next time will rebuild it from the files, just without the order.
+		File::Delete(dir_ + "index");
+	}
+}
+
+bool TextureScaleCache::ReadTexture(u64 key, u32 *out, int w, int h) {
+	const u64 fileSize = entries_[key].size;
+	if (fileSize < sizeof(ScaleCacheTextureHeader)) {
+		return false;
+	}
+
+	FILE *f = File::OpenCFile(Filename(key), "rb");
+	if (!f) {
+		return false;
+	}
+	ScaleCacheTextureHeader header;
+	bool success = fread(&header, sizeof(header), 1, f) == 1;
+	success = success && memcmp(header.magic, TEXTURE_MAGIC, sizeof(TEXTURE_MAGIC)) == 0 && header.version == CACHE_VERSION;
+	success = success && header.w == (u32)w && header.h == (u32)h;
+	const size_t compressedSize = (size_t)(fileSize - sizeof(header));
+	if (success) {
+		buffer_.resize(compressedSize);
+		success = compressedSize != 0 && fread(&buffer_[0], 1, compressedSize, f) == compressedSize;
+	}
+	fclose(f);
+	if (!success) {
+		return false;
+	}
+
+	size_t outSize = (size_t)w * h * sizeof(u32);
+	size_t length;
+	if (snappy_uncompressed_length(&buffer_[0], compressedSize, &length) != SNAPPY_OK || length != outSize) {
+		return false;
+	}
+	return snappy_uncompress(&buffer_[0], compressedSize, (char *)out, &outSize) == SNAPPY_OK;
+}
+
+void TextureScaleCache::Add(u64 key, u64 size) {
+	Remove(key);
+	lru_.push_back(key);
+	entries_[key] = Entry{ size, std::prev(lru_.end()) };
+	totalSize_ += size;
+	dirty_ = true;
+}
+
+void TextureScaleCache::Remove(u64 key) {
+	auto it = entries_.find(key);
+	if (it == entries_.end()) {
+		return;
+	}
+	totalSize_ -= it->second.size;
+	lru_.erase(it->second.pos);
+	entries_.erase(it);
+	dirty_ = true;
+}
+
+void TextureScaleCache::Evict() {
+	const u64 limit = (u64)std::max(g_Config.iTexScalingDiskCacheMB, 0) * 1024 * 1024;
+	while (totalSize_ > limit && !lru_.empty()) {
+		const u64 key = lru_.front();
+		File::Delete(Filename(key));
+		Remove(key);
+	}
+}
+
+std::string TextureScaleCache::Filename(u64 key) const {
+	char name[32];
+	snprintf(name, sizeof(name), "%016llx.scaled", (unsigned long long)key);
+	return dir_ + name;
+}
@@ -0,0 +1,65 @@
+// Copyright (c) 2012- PPSSPP Project.
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, version 2.0 or later versions.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License 2.0 for more details.
+
+// A copy of the GPL 2.0 should have been included with the program.
+// If not, see http://www.gnu.org/licenses/
+
+// Official git repository and contact information can be found at
+// https://github.com/hrydgard/ppsspp and http://www.ppsspp.org/.
+
+#pragma once
+
+#include <list>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "Common/CommonTypes.h"
+
+// Keeps scaled textures on disk between sessions, so they only need to be scaled once.
+// Each texture is a snappy compressed file, and an index remembers the order they were last
+// used in, so the least recently used ones can be deleted when over the size limit.
+//
+// Not thread safe, it's only used from the texture cache.
+class TextureScaleCache {
+public:
+	TextureScaleCache() {}
+	~TextureScaleCache();
+
+	// Sizes are of the scaled texture, which is always 32-bit.  Returns false if not cached.
+	bool Load(u64 key, u32 *out, int w, int h);
+	void Save(u64 key, const u32 *data, int w, int h);
+
+private:
+	struct Entry {
+		u64 size;
+		// Position in lru_.
+		std::list<u64>::iterator pos;
+	};
+
+	void Open();
+	void LoadIndex();
+	void SaveIndex();
+	bool ReadTexture(u64 key, u32 *out, int w, int h);
+	void Add(u64 key, u64 size);
+	void Remove(u64 key);
+	void Evict();
+	std::string Filename(u64 key) const;
+
+	bool opened_ = false;
+	bool dirty_ = false;
+	std::string dir_;
+	// Least recently used first.
+	std::list<u64> lru_;
+	std::unordered_map<u64, Entry> entries_;
+	u64 totalSize_ = 0;
+	std::vector<char> buffer_;
+};
@@ -21,6 +21,7 @@
 #endif
 
 #include <algorithm>
+#include <atomic>
 #include <cassert>
 #include <cstdlib>
 #include <cstring>
@@ -36,7 +37,11 @@
 #include "Common/ThreadPools.h"
 #include "Common/CPUDetect.h"
 #include "ext/xbrz/xbrz.h"
+#include "ext/xxhash.h"
 
+#ifdef _M_SSE
+#include <emmintrin.h>
+#endif
 #if _M_SSE >= 0x401
 #include <smmintrin.h>
 #endif
@@ -72,6 +77,23 @@ namespace {
 
 #define BLOCK_SIZE 32
 
+#ifdef _M_SSE
+// MIX_PIXELS on 16-bit channels, where f0 + f1 = 255.
+inline __m128i MixPixels16SSE2(__m128i p0, __m128i p1, __m128i f0, __m128i f1) {
+	const __m128i sum = _mm_add_epi16(_mm_mullo_epi16(p0, f0), _mm_mullo_epi16(p1, f1));
+	// This is exactly sum / 255 for anything up to 255 * 255.
+	return _mm_srli_epi16(_mm_add_epi16(_mm_add_epi16(sum, _mm_set1_epi16(1)), _mm_srli_epi16(sum, 8)), 8);
+}
+
+// MIX_PIXELS for 4 pixels.  The lo factors are for the first two, hi for the other two.
+inline __m128i MixPixelsSSE2(__m128i p0, __m128i p1, __m128i f0lo, __m128i f1lo, __m128i f0hi, __m128i f1hi) {
+	const __m128i zero = _mm_setzero_si128();
+	const __m128i lo = MixPixels16SSE2(_mm_unpacklo_epi8(p0, zero), _mm_unpacklo_epi8(p1, zero), f0lo, f1lo);
+	const __m128i hi = MixPixels16SSE2(_mm_unpackhi_epi8(p0, zero), _mm_unpackhi_epi8(p1, zero), f0hi, f1hi);
+	return _mm_packus_epi16(lo, hi);
+}
+#endif
+
 // 3x3 convolution with Neumann boundary conditions, parallelizable
 // quite slow, could be sped up a lot
 // especially handling of separable kernels
@@ -188,15 +210,48 @@ void generateDistanceMask(u32* data, u32* out, int width, int height, int l, int
 
 // mix two images based on a mask
 void mix(u32* data, u32* source, u32* mask, u32 maskmax, int width, int l, int u) {
-	for (int y = l; y < u; ++y) {
-		for (int x = 0; x < width; ++x) {
-			int pos = y*width + x;
-			u8 mixFactors[2] = { 0, static_cast<u8>((std::min(mask[pos], maskmax) * 255) / maskmax) };
-			mixFactors[0] = 255 - mixFactors[1];
-			data[pos] = MIX_PIXELS(data[pos], source[pos], mixFactors);
-			if (A(source[pos]) == 0) data[pos] = data[pos] & 0x00FFFFFF; // xBRZ always does a better job with hard alpha
+	int pos = l*width;
+	const int end = u*width;
+#ifdef _M_SSE
+	int maskShift = 0;
+	while ((1U << maskShift) < maskmax)
+		++maskShift;
+	// With a power of 2, the division by maskmax is just a shift.
+	if ((1U << maskShift) == maskmax) {
+		const __m128i zero = _mm_setzero_si128();
+		const __m128i maxMask = _mm_set1_epi32(maskmax);
+		const __m128i shift = _mm_cvtsi32_si128(maskShift);
+		const __m128i alphaBits = _mm_set1_epi32(0xFF000000);
+		const __m128i full = _mm_set1_epi16(255);
+		for (; pos + 4 <= end; pos += 4) {
+			// The mask is far below 2^31, so the signed compare is fine.
+			__m128i m = _mm_loadu_si128((const __m128i *)(mask + pos));
+			const __m128i over = _mm_cmpgt_epi32(m, maxMask);
+			m = _mm_or_si128(_mm_and_si128(over, maxMask), _mm_andnot_si128(over, m));
+			m = _mm_srl_epi32(_mm_sub_epi32(_mm_slli_epi32(m, 8), m), shift);
+
+			// Spread each pixel's factor over its 4 channels.
+			__m128i f16 = _mm_packs_epi32(m, m);
+			f16 = _mm_unpacklo_epi16(f16, f16);
+			const __m128i f1lo = _mm_unpacklo_epi32(f16, f16);
+			const __m128i f1hi = _mm_unpackhi_epi32(f16, f16);
+			const __m128i f0lo = _mm_sub_epi16(full, f1lo);
+			const __m128i f0hi = _mm_sub_epi16(full, f1hi);
+
+			const __m128i src = _mm_loadu_si128((const __m128i *)(source + pos));
+			__m128i result = MixPixelsSSE2(_mm_loadu_si128((const __m128i *)(data + pos)), src, f0lo, f1lo, f0hi, f1hi);
+			const __m128i transparent = _mm_cmpeq_epi32(_mm_and_si128(src, alphaBits), zero);
+			result = _mm_andnot_si128(_mm_and_si128(transparent, alphaBits), result);
+			_mm_storeu_si128((__m128i *)(data + pos), result);
 		}
 	}
+#endif
+	for (; pos < end; ++pos) {
+		u8 mixFactors[2] = { 0, static_cast<u8>((std::min(mask[pos], maskmax) * 255) / maskmax) };
+		mixFactors[0] = 255 - mixFactors[1];
+		data[pos] = MIX_PIXELS(data[pos], source[pos], mixFactors);
+		if (A(source[pos]) == 0) data[pos] = data[pos] & 0x00FFFFFF; // xBRZ always does a better job with hard alpha
+	}
 }
 
 //////////////////////////////////////////////////////////////////// Bicubic scaling
@@ -418,11 +473,37 @@ template<int f>
 void bilinearVt(u32* data, u32* out, int w, int gl, int gu, int l, int u) {
 	static_assert(f>1 && f <= 5, "Bilinear scaling only implemented for 2x, 3x, 4x, and 5x");
 	int outw = w*f;
-	for (int xb = 0; xb < outw / BLOCK_SIZE + 1; ++xb) {
+#ifdef _M_SSE
+	// 4 pixels at a time, whole rows.  Only a narrow leftover goes through the loop below.
+	const int simdw = outw & ~3;
+	for (int y = l; y < u; ++y) {
+		u32 uy = y - (y == gl ? 0 : 1);
+		u32 ly = y + (y == gu - 1 ? 0 : 1);
+		for (int x = 0; x < simdw; x += 4) {
+			const __m128i upper = _mm_loadu_si128((const __m128i *)(data + uy * outw + x));
+			const __m128i center = _mm_loadu_si128((const __m128i *)(data + y * outw + x));
+			const __m128i lower = _mm_loadu_si128((const __m128i *)(data + ly * outw + x));
+			int i = 0;
+			for (; i < f / 2 + f % 2; ++i) {
+				const __m128i f0 = _mm_set1_epi16(BILINEAR_FACTORS[f - 2][i][0]);
+				const __m128i f1 = _mm_set1_epi16(BILINEAR_FACTORS[f - 2][i][1]);
+				_mm_storeu_si128((__m128i *)(out + (y*f + i)*outw + x), MixPixelsSSE2(upper, center, f0, f1, f0, f1));
+			}
+			for (; i < f; ++i) {
+				const __m128i f0 = _mm_set1_epi16(BILINEAR_FACTORS[f - 2][f - 1 - i][0]);
+				const __m128i f1 = _mm_set1_epi16(BILINEAR_FACTORS[f - 2][f - 1 - i][1]);
+				_mm_storeu_si128((__m128i *)(out + (y*f + i)*outw + x), MixPixelsSSE2(lower, center, f0, f1, f0, f1));
+			}
+		}
+	}
+#else
+	const int simdw = 0;
+#endif
+	for (int xb = simdw / BLOCK_SIZE; xb < outw / BLOCK_SIZE + 1; ++xb) {
 		for (int y = l; y < u; ++y) {
 			u32 uy = y - (y == gl ? 0 : 1);
 			u32 ly = y + (y == gu - 1 ? 0 : 1);
-			for (int x = xb*BLOCK_SIZE; x < (xb + 1)*BLOCK_SIZE && x < outw; ++x) {
+			for (int x = std::max(xb*BLOCK_SIZE, simdw); x < (xb + 1)*BLOCK_SIZE && x < outw; ++x) {
 				u32 upper = data[uy * outw + x];
 				u32 center = data[y * outw + x];
 				u32 lower = data[ly * outw + x];
@@ -455,6 +536,28 @@ void bilinearV(int factor, u32* data, u32* out, int w, int gl, int gu, int l, in
 #undef B
 #undef A
 
+//////////////////////////////////////////////////////////////////// Scheduling
+
+const int BANDS_PER_THREAD = 4;
+const int MIN_BAND_ROWS = 4;
+
+// Threads keep taking small bands of rows until none are left, instead of one fixed slice each.
+// xBRZ is much cheaper over flat areas, so with fixed slices everyone waits on the busiest thread.
+void ParallelRowBands(const std::function<void(int, int)> &loop, int lower, int upper) {
+	const int bands = std::max(g_Config.iNumWorkerThreads, 1) * BANDS_PER_THREAD;
+	const int bandSize = std::max(MIN_BAND_ROWS, (upper - lower + bands - 1) / bands);
+	const int bandCount = (upper - lower + bandSize - 1) / bandSize;
+
+	std::atomic<int> nextBand(0);
+	GlobalThreadPool::Loop([&](int, int) {
+		int band;
+		while ((band = nextBand++) < bandCount) {
+			const int start = lower + band * bandSize;
+			loop(start, std::min(start + bandSize, upper));
+		}
+	}, 0, bandCount);
+}
+
 #ifdef DEBUG_SCALER_OUTPUT
 
 // used for debugging texture scaling (writing textures to files)
@@ -513,7 +616,18 @@ bool TextureScalerCommon::IsEmptyOrFlat(u32* data, int pixels, int fmt) {
 	return true;
 }
 
-void TextureScalerCommon::ScaleAlways(u32 *out, u32 *src, u32 &dstFmt, int &width, int &height, int factor) {
+u64 TextureScalerCommon::DiskCacheKey(u64 textureKey, const u32 *src, u32 fmt, int width, int height, int factor) {
+	// The texture cache's hashes are only 32-bit and this outlives the session, so hash the data too.
+	u64 key[5];
+	key[0] = textureKey;
+	key[1] = XXH64(src, width * height * BytesPerPixel(fmt), 0);
+	key[2] = ((u64)fmt << 32) | Get8888Format();
+	key[3] = ((u64)width << 32) | (u32)height;
+	key[4] = (u64)factor | ((u64)g_Config.iTexScalingType << 8) | ((u64)g_Config.bTexDeposterize << 16);
+	return XXH64(key, sizeof(key), 0);
+}
+
+void TextureScalerCommon::ScaleAlways(u32 *out, u32 *src, u32 &dstFmt, int &width, int &height, int factor, u64 diskCacheKey) {
 	if (IsEmptyOrFlat(src, width*height, dstFmt)) {
 		// This means it was a flat texture.  Vulkan wants the size up front, so we need to make it happen.
 		u32 pixel;
@@ -537,6 +651,16 @@ void TextureScalerCommon::ScaleAlways(u32 *out, u32 *src, u32 &dstFmt, int &widt
 				out[i] = pixel;
 			}
 		}
+	} else if (diskCacheKey != 0) {
+		const u64 key = DiskCacheKey(diskCacheKey, src, dstFmt, width, height, factor);
+		if (diskCache_.Load(key, out, width * factor, height * factor)) {
+			dstFmt = Get8888Format();
+			width *= factor;
+			height *= factor;
+		} else {
+			ScaleInto(out, src, dstFmt, width, height, factor);
+			diskCache_.Save(key, out, width, height);
+		}
 	} else {
 		ScaleInto(out, src, dstFmt, width, height, factor);
 	}
@@ -614,7 +738,7 @@ bool TextureScalerCommon::Scale(u32* &data, u32 &dstFmt, int &width, int &height
 
 void TextureScalerCommon::ScaleXBRZ(int factor, u32* source, u32* dest, int width, int height) {
 	xbrz::ScalerCfg cfg;
-	GlobalThreadPool::Loop(std::bind(&xbrz::scale, factor, source, dest, width, height, xbrz::ColorFormat::ARGB, cfg, std::placeholders::_1, std::placeholders::_2), 0, height);
+	ParallelRowBands(std::bind(&xbrz::scale, factor, source, dest, width, height, xbrz::ColorFormat::ARGB, cfg, std::placeholders::_1, std::placeholders::_2), 0, height);
 }
 
 void TextureScalerCommon::ScaleBilinear(int factor, u32* source, u32* dest, int width, int height) {
@@ -625,11 +749,11 @@ void TextureScalerCommon::ScaleBilinear(int factor, u32* source, u32* dest, int
 }
 
 void TextureScalerCommon::ScaleBicubicBSpline(int factor, u32* source, u32* dest, int width, int height) {
-	GlobalThreadPool::Loop(std::bind(&scaleBicubicBSpline, factor, source, dest, width, height, std::placeholders::_1, std::placeholders::_2), 0, height);
+	ParallelRowBands(std::bind(&scaleBicubicBSpline, factor, source, dest, width, height, std::placeholders::_1, std::placeholders::_2), 0, height);
 }
 
 void TextureScalerCommon::ScaleBicubicMitchell(int factor, u32* source, u32* dest, int width, int height) {
-	GlobalThreadPool::Loop(std::bind(&scaleBicubicMitchell, factor, source, dest, width, height, std::placeholders::_1, std::placeholders::_2), 0, height);
+	ParallelRowBands(std::bind(&scaleBicubicMitchell, factor, source, dest, width, height, std::placeholders::_1, std::placeholders::_2), 0, height);
 }
 
 void TextureScalerCommon::ScaleHybrid(int factor, u32* source, u32* dest, int width, int height, bool bicubic) {
@@ -19,6 +19,7 @@
 
 #include "Common/CommonTypes.h"
 #include "Common/MemoryUtil.h"
+#include "GPU/Common/TextureScaleCache.h"
 
 #include <vector>
 
@@ -27,7 +28,8 @@ class TextureScalerCommon {
 	TextureScalerCommon();
 	~TextureScalerCommon();
 
-	void ScaleAlways(u32 *out, u32 *src, u32 &dstFmt, int &width, int &height, int factor);
+	// A non-zero diskCacheKey identifies the texture, to keep the result in the disk cache.
+	void ScaleAlways(u32 *out, u32 *src, u32 &dstFmt, int &width, int &height, int factor, u64 diskCacheKey = 0);
 	bool Scale(u32 *&data, u32 &dstfmt, int &width, int &height, int factor);
 	bool ScaleInto(u32 *out, u32 *src, u32 &dstfmt, int &width, int &height, int factor);
 
@@ -47,9 +49,12 @@ class TextureScalerCommon {
 	void DePosterize(u32* source, u32* dest, int width, int height);
 
 	bool IsEmptyOrFlat(u32* data, int pixels, int fmt);
+	u64 DiskCacheKey(u64 textureKey, const u32 *src, u32 fmt, int width, int height, int factor);
 
 	// depending on the factor and texture sizes, these can get pretty large 
 	// maximum is (100 MB total for a 512 by 512 texture with scaling factor 5 and hybrid scaling)
 	// of course, scaling factor 5 is totally silly anyway
 	SimpleBuf<u32> bufInput, bufDeposter, bufOutput, bufTmp1, bufTmp2, bufTmp3;
+
+	TextureScaleCache diskCache_;
 };
@@ -490,7 +490,7 @@ void TextureCacheD3D11::BuildTexture(TexCacheEntry *const entry) {
 	u64 cachekey = replacer_.Enabled() ? entry->CacheKey() : 0;
 	int w = gstate.getTextureWidth(0);
 	int h = gstate.getTextureHeight(0);
-	ReplacedTexture &replaced = replacer_.FindReplacement(cachekey, entry->fullhash, w, h);
+	ReplacedTexture &replaced = FindReplacement(entry, cachekey, w, h);
 	if (replaced.GetSize(0, w, h)) {
 		// We're replacing, so we won't scale.
 		scaleFactor = 1;
@@ -553,6 +553,7 @@ void TextureCacheD3D11::BuildTexture(TexCacheEntry *const entry) {
 	}
 	if (replaced.Valid()) {
 		entry->SetAlphaStatus(TexCacheEntry::TexStatus(replaced.AlphaStatus()));
+		replaced.FinishedUpload();
 	}
 }
 
@@ -724,7 +725,7 @@ void TextureCacheD3D11::LoadTextureLevel(TexCacheEntry &entry, ReplacedTexture &
 
 		if (scaleFactor > 1) {
 			u32 scaleFmt = (u32)dstFmt;
-			scaler.ScaleAlways((u32 *)mapData, pixelData, scaleFmt, w, h, scaleFactor);
+			scaler.ScaleAlways((u32 *)mapData, pixelData, scaleFmt, w, h, scaleFactor, ScaleCacheKey(entry, level));
 			pixelData = (u32 *)mapData;
 
 			// We always end up at 8888.  Other parts assume this.
@@ -409,8 +409,7 @@ void DumpExecute::SubmitListEnd() {
 }
 
 void DumpExecute::Init(u32 ptr, u32 sz) {
-	gstate.Restore((u32_le *)(pushbuf_.data() + ptr));
-	gpu->ReapplyGfxState();
+	gpu->RestoreContext((u32_le *)(pushbuf_.data() + ptr));
 }
 
 void DumpExecute::Registers(u32 ptr, u32 sz) {
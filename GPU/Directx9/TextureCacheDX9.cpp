@@ -533,7 +533,7 @@ void TextureCacheDX9::BuildTexture(TexCacheEntry *const entry) {
 	u64 cachekey = replacer_.Enabled() ? entry->CacheKey() : 0;
 	int w = gstate.getTextureWidth(0);
 	int h = gstate.getTextureHeight(0);
-	ReplacedTexture &replaced = replacer_.FindReplacement(cachekey, entry->fullhash, w, h);
+	ReplacedTexture &replaced = FindReplacement(entry, cachekey, w, h);
 	if (replaced.GetSize(0, w, h)) {
 		// We're replacing, so we won't scale.
 		scaleFactor = 1;
@@ -593,6 +593,7 @@ void TextureCacheDX9::BuildTexture(TexCacheEntry *const entry) {
 	}
 	if (replaced.Valid()) {
 		entry->SetAlphaStatus(TexCacheEntry::TexStatus(replaced.AlphaStatus()));
+		replaced.FinishedUpload();
 	}
 }
 
@@ -736,7 +737,7 @@ void TextureCacheDX9::LoadTextureLevel(TexCacheEntry &entry, ReplacedTexture &re
 		}
 
 		if (scaleFactor > 1) {
-			scaler.ScaleAlways((u32 *)rect.pBits, pixelData, dstFmt, w, h, scaleFactor);
+			scaler.ScaleAlways((u32 *)rect.pBits, pixelData, dstFmt, w, h, scaleFactor, ScaleCacheKey(entry, level));
 			pixelData = (u32 *)rect.pBits;
 
 			// We always end up at 8888.  Other parts assume this.
@@ -228,7 +228,7 @@ GLRInputLayout *DrawEngineGLES::SetupDecFmtForDraw(LinkedShader *program, const
 	return inputLayout;
 }
 
-void DrawEngineGLES::DecodeVertsToPushBuffer(GLPushBuffer *push, uint32_t *bindOffset, GLRBuffer **buf) {
+void DrawEngineGLES::DecodeVertsToPushBuffer(GLPushBuffer *push, uint32_t *bindOffset, GLRBuffer **buf, GLPushBuffer *indexPush, uint32_t *indexBindOffset, GLRBuffer **indexBuf) {
 	u8 *dest = decoded;
 
 	// Figure out how much pushbuffer space we need to allocate.
@@ -236,6 +236,12 @@ void DrawEngineGLES::DecodeVertsToPushBuffer(GLPushBuffer *push, uint32_t *bindO
 		int vertsToDecode = ComputeNumVertsToDecode();
 		dest = (u8 *)push->Push(vertsToDecode * dec_->GetDecVtxFmt().stride, bindOffset, buf);
 	}
+	// Same for the indices, unless some were already generated into decIndex (software skinning.)
+	// The caller rewinds the pushbuffer once it knows how many were actually used.
+	if (indexPush && decodeCounter_ == 0) {
+		u16 *inds = (u16 *)indexPush->Push(sizeof(uint16_t) * ComputeMaxIndicesToGenerate(), indexBindOffset, indexBuf);
+		indexGen.Setup(inds);
+	}
 	DecodeVerts(dest);
 }
 
@@ -482,8 +488,8 @@ void DrawEngineGLES::DoFlush() {
 				u8 *dest = (u8 *)frameData.pushVertex->Push(size, &vertexBufferOffset, &vertexBuffer);
 				memcpy(dest, decoded, size);
 			} else {
-				// Decode directly into the pushbuffer
-				DecodeVertsToPushBuffer(frameData.pushVertex, &vertexBufferOffset, &vertexBuffer);
+				// Decode directly into the pushbuffer, indices too.
+				DecodeVertsToPushBuffer(frameData.pushVertex, &vertexBufferOffset, &vertexBuffer, frameData.pushIndex, &indexBufferOffset, &indexBuffer);
 			}
 
 rotateVBO:
@@ -493,6 +499,10 @@ void DrawEngineGLES::DoFlush() {
 			if (!useElements && indexGen.PureCount()) {
 				vertexCount = indexGen.PureCount();
 			}
+			if (indexBuffer) {
+				// The indices went straight into the pushbuffer, give back what the worst case didn't need.
+				frameData.pushIndex->Rewind(indexBufferOffset + (useElements ? sizeof(uint16_t) * indexGen.VertexCount() : 0));
+			}
 			prim = indexGen.Prim();
 		}
 
@@ -517,8 +527,8 @@ void DrawEngineGLES::DoFlush() {
 		if (useElements) {
 			if (!indexBuffer) {
 				indexBufferOffset = (uint32_t)frameData.pushIndex->Push(decIndex, sizeof(uint16_t) * indexGen.VertexCount(), &indexBuffer);
-				render_->BindIndexBuffer(indexBuffer);
 			}
+			render_->BindIndexBuffer(indexBuffer);
 			render_->DrawIndexed(glprim[prim], vertexCount, GL_UNSIGNED_SHORT, (GLvoid*)(intptr_t)indexBufferOffset);
 		} else {
 			render_->Draw(glprim[prim], 0, vertexCount);
@@ -631,7 +641,8 @@ void DrawEngineGLES::DoFlush() {
 	gpuStats.numDrawCalls += numDrawCalls;
 	gpuStats.numVertsSubmitted += vertexCountInDrawCalls_;
 
-	indexGen.Reset();
+	// Point the index generator back at decIndex, in case it was writing into the pushbuffer.
+	indexGen.Setup(decIndex);
 	decodedVerts_ = 0;
 	numDrawCalls = 0;
 	vertexCountInDrawCalls_ = 0;
@@ -193,7 +193,8 @@ class DrawEngineGLES : public DrawEngineCommon {
 
 	GLRInputLayout *SetupDecFmtForDraw(LinkedShader *program, const DecVtxFormat &decFmt);
 
-	void DecodeVertsToPushBuffer(GLPushBuffer *push, uint32_t *bindOffset, GLRBuffer **buf);
+	// If indexPush is given, IndexGenerator also writes straight into it, and *indexBuf is set.
+	void DecodeVertsToPushBuffer(GLPushBuffer *push, uint32_t *bindOffset, GLRBuffer **buf, GLPushBuffer *indexPush = nullptr, uint32_t *indexBindOffset = nullptr, GLRBuffer **indexBuf = nullptr);
 
 	void FreeVertexArray(VertexArrayInfo *vai);
 
@@ -605,7 +605,7 @@ void TextureCacheGLES::BuildTexture(TexCacheEntry *const entry) {
 	u64 cachekey = replacer_.Enabled() ? entry->CacheKey() : 0;
 	int w = gstate.getTextureWidth(0);
 	int h = gstate.getTextureHeight(0);
-	ReplacedTexture &replaced = replacer_.FindReplacement(cachekey, entry->fullhash, w, h);
+	ReplacedTexture &replaced = FindReplacement(entry, cachekey, w, h);
 	if (replaced.GetSize(0, w, h)) {
 		// We're replacing, so we won't scale.
 		scaleFactor = 1;
@@ -690,6 +690,7 @@ void TextureCacheGLES::BuildTexture(TexCacheEntry *const entry) {
 	}
 	if (replaced.Valid()) {
 		entry->SetAlphaStatus(TexCacheEntry::TexStatus(replaced.AlphaStatus()));
+		replaced.FinishedUpload();
 	}
 
 	render_->FinalizeTexture(entry->textureName, texMaxLevel, genMips);
@@ -786,7 +787,7 @@ void TextureCacheGLES::LoadTextureLevel(TexCacheEntry &entry, ReplacedTexture &r
 		if (scaleFactor > 1) {
 			uint8_t *rearrange = (uint8_t *)AllocateAlignedMemory(w * scaleFactor * h * scaleFactor * 4, 16);
 			u32 dFmt = (u32)dstFmt;
-			scaler.ScaleAlways((u32 *)rearrange, (u32 *)pixelData, dFmt, w, h, scaleFactor);
+			scaler.ScaleAlways((u32 *)rearrange, (u32 *)pixelData, dFmt, w, h, scaleFactor, ScaleCacheKey(entry, level));
 			dstFmt = (Draw::DataFormat)dFmt;
 			FreeAlignedMemory(pixelData);
 			pixelData = rearrange;
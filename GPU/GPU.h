@@ -70,6 +70,7 @@ struct GPUStatistics {
 		numReadbacks = 0;
 		numUploads = 0;
 		numClears = 0;
+		numPendingPipelineDraws = 0;
 		msProcessingDisplayLists = 0;
 		vertexGPUCycles = 0;
 		otherGPUCycles = 0;
@@ -91,6 +92,8 @@ struct GPUStatistics {
 	int numReadbacks;
 	int numUploads;
 	int numClears;
+	// Draws that needed a pipeline still being compiled in the background.
+	int numPendingPipelineDraws;
 	double msProcessingDisplayLists;
 	int vertexGPUCycles;
 	int otherGPUCycles;
@@ -1084,6 +1084,11 @@ void GPUCommon::UpdatePC(u32 currentPC, u32 newPC) {
 		downcount = 0;
 }
 
+void GPUCommon::RestoreContext(u32_le *ptr) {
+	gstate.Restore(ptr);
+	ReapplyGfxState();
+}
+
 void GPUCommon::ReapplyGfxState() {
 	// The commands are embedded in the command memory so we can just reexecute the words. Convenient.
 	// To be safe we pass 0xFFFFFFFF as the diff.
@@ -1422,8 +1427,7 @@ void GPUCommon::Execute_End(u32 op, u32 diff) {
 				busyTicks = std::max(busyTicks, currentList->waitTicks);
 				__GeTriggerSync(GPU_SYNC_LIST, currentList->id, currentList->waitTicks);
 				if (currentList->started && currentList->context.IsValid()) {
-					gstate.Restore(currentList->context);
-					ReapplyGfxState();
+					RestoreContext(currentList->context);
 				}
 			}
 			break;
@@ -2443,8 +2447,7 @@ void GPUCommon::InterruptEnd(int listid) {
 	// TODO: Unless the signal handler could change it?
 	if (dl.state == PSP_GE_DL_STATE_COMPLETED || dl.state == PSP_GE_DL_STATE_NONE) {
 		if (dl.started && dl.context.IsValid()) {
-			gstate.Restore(dl.context);
-			ReapplyGfxState();
+			RestoreContext(dl.context);
 		}
 		dl.waitTicks = 0;
 		__GeTriggerWait(GPU_SYNC_LIST, listid);
@@ -110,6 +110,8 @@ class GPUCommon : public GPUInterface, public GPUDebugInterface {
 	u32  Continue() override;
 	u32  Break(int mode) override;
 	void ReapplyGfxState() override;
+	void RestoreContext(u32_le *ptr) override;
+	void FinishPendingDraws() override {}
 
 	void CopyDisplayToOutput() override = 0;
 	void InitClear() override = 0;
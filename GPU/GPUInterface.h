@@ -225,7 +225,11 @@ class GPUInterface {
 	virtual void DeviceLost() = 0;
 	virtual void DeviceRestore() = 0;
 	virtual void ReapplyGfxState() = 0;
+	// Replaces gstate with a saved context and reapplies it.
+	virtual void RestoreContext(u32_le *ptr) = 0;
 	virtual void DoState(PointerWrap &p) = 0;
+	// Finishes any drawing still in flight, before all of emulated memory is saved or replaced.
+	virtual void FinishPendingDraws() = 0;
 
 	// Called by the window system if the window size changed. This will be reflected in PSPCoreParam.pixel*.
 	virtual void Resized() = 0;
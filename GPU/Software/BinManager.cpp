@@ -0,0 +1,206 @@
+// Copyright (c) 2013- PPSSPP Project.
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, version 2.0 or later versions.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License 2.0 for more details.
+
+// A copy of the GPL 2.0 should have been included with the program.
+// If not, see http://www.gnu.org/licenses/
+
+// Official git repository and contact information can be found at
+// https://github.com/hrydgard/ppsspp and http://www.ppsspp.org/.
+
+#include <algorithm>
+
+#include "profiler/profiler.h"
+#include "thread/threadutil.h"
+#include "Common/ThreadPools.h"
+#include "Core/Config.h"
+#include "GPU/GPUState.h"
+#include "GPU/Software/BinManager.h"
+#include "GPU/Software/Rasterizer.h"
+
+namespace Rasterizer {
+
+// Tiles are 32x32 pixels, over the whole 1024x1024 drawing space.
+static const int BIN_SIZE_LOG2 = 5;
+static const int BINS_PER_ROW_LOG2 = 10 - BIN_SIZE_LOG2;
+static const int BINS_PER_ROW = 1 << BINS_PER_ROW_LOG2;
+static const int BIN_COUNT = BINS_PER_ROW * BINS_PER_ROW;
+
+// Kick early if a draw is huge, to keep memory use in check.
+static const size_t MAX_QUEUED_TRIANGLES = 4096;
+
+static inline int ScreenToBin(int v, int offset16) {
+	int drawing = (v - offset16) >> 4;
+	return std::max(0, std::min(BINS_PER_ROW - 1, drawing >> BIN_SIZE_LOG2));
+}
+
+BinManager::BinManager() : nextBin_(0), drawing_(false) {
+	for (BinQueue &queue : queues_) {
+		queue.bins.resize(BIN_COUNT);
+		queue.triangles.reserve(MAX_QUEUED_TRIANGLES);
+	}
+}
+
+BinManager::~BinManager() {
+	if (thread_.joinable()) {
+		WaitForDrawing();
+		{
+			std::lock_guard<std::mutex> guard(wakeMutex_);
+			exiting_ = true;
+		}
+		wake_.notify_one();
+		thread_.join();
+	}
+}
+
+bool BinManager::IsEnabled() const {
+	return g_Config.iNumWorkerThreads > 1;
+}
+
+void BinManager::AddTriangle(const VertexData &v0, const VertexData &v1, const VertexData &v2, const BinCoords &range) {
+	if (range.x2 < range.x1 || range.y2 < range.y1)
+		return;
+	if (queues_[current_].triangles.size() >= MAX_QUEUED_TRIANGLES)
+		Kick();
+
+	BinQueue &queue = queues_[current_];
+	int index = (int)queue.triangles.size();
+	queue.triangles.push_back(BinTriangle{ v0, v1, v2, range });
+
+	const int offsetX = gstate.getOffsetX16();
+	const int offsetY = gstate.getOffsetY16();
+	int bx1 = ScreenToBin(range.x1, offsetX);
+	int bx2 = ScreenToBin(range.x2, offsetX);
+	int by1 = ScreenToBin(range.y1, offsetY);
+	int by2 = ScreenToBin(range.y2, offsetY);
+	for (int by = by1; by <= by2; ++by) {
+		for (int bx = bx1; bx <= bx2; ++bx) {
+			int bin = (by << BINS_PER_ROW_LOG2) + bx;
+			if (queue.bins[bin].empty())
+				queue.usedBins.push_back(bin);
+			queue.bins[bin].push_back(index);
+		}
+	}
+}
+
+void BinManager::Flush() {
+	WaitForDrawing();
+
+	BinQueue &queue = queues_[current_];
+	if (queue.triangles.empty())
+		return;
+
+	// Looking up the sampler or pixel func may compile it, which must not happen on the workers.
+	queue.sampler = Sampler::GetFuncs();
+	queue.drawPixel = GetSingleFunc();
+	Drain(queue);
+}
+
+void BinManager::Kick() {
+	if (!g_Config.bSoftwareRenderingThread) {
+		Flush();
+		return;
+	}
+
+	BinQueue &queue = queues_[current_];
+	if (queue.triangles.empty())
+		return;
+
+	// Only one queue draws at a time, and always in order.
+	WaitForDrawing();
+	queue.sampler = Sampler::GetFuncs();
+	queue.drawPixel = GetSingleFunc();
+
+	if (!thread_.joinable()) {
+		thread_ = std::thread([this] { RasterThread(); });
+	}
+
+	{
+		std::lock_guard<std::mutex> guard(wakeMutex_);
+		drawingQueue_ = &queue;
+		drawing_ = true;
+	}
+	current_ ^= 1;
+	wake_.notify_one();
+}
+
+void BinManager::WaitForDrawing() {
+	if (!drawing_)
+		return;
+
+	PROFILE_THIS_SCOPE("bin_wait");
+	std::unique_lock<std::mutex> guard(doneMutex_);
+	while (drawing_)
+		done_.wait(guard);
+}
+
+void BinManager::RasterThread() {
+	setCurrentThreadName("SoftRaster");
+
+	std::unique_lock<std::mutex> guard(wakeMutex_);
+	while (!exiting_) {
+		if (!drawingQueue_) {
+			wake_.wait(guard);
+			continue;
+		}
+
+		BinQueue *queue = drawingQueue_;
+		drawingQueue_ = nullptr;
+		guard.unlock();
+
+		Drain(*queue);
+
+		{
+			std::lock_guard<std::mutex> doneGuard(doneMutex_);
+			drawing_ = false;
+		}
+		done_.notify_all();
+		guard.lock();
+	}
+}
+
+void BinManager::Drain(BinQueue &queue) {
+	PROFILE_THIS_SCOPE("bin_flush");
+
+	// Tiles vary a lot in cost, so threads grab them one at a time rather than in fixed slices.
+	const int count = (int)queue.usedBins.size();
+	nextBin_ = 0;
+	auto drawBins = [&](int, int) {
+		int i;
+		while ((i = nextBin_++) < count) {
+			DrawTile(queue, queue.usedBins[i]);
+		}
+	};
+	GlobalThreadPool::Loop(drawBins, 0, count);
+
+	for (int bin : queue.usedBins) {
+		queue.bins[bin].clear();
+	}
+	queue.usedBins.clear();
+	queue.triangles.clear();
+}
+
+void BinManager::DrawTile(const BinQueue &queue, int tile) {
+	const int bx = tile & (BINS_PER_ROW - 1);
+	const int by = tile >> BINS_PER_ROW_LOG2;
+
+	BinCoords clip;
+	clip.x1 = gstate.getOffsetX16() + (bx << (BIN_SIZE_LOG2 + 4));
+	clip.y1 = gstate.getOffsetY16() + (by << (BIN_SIZE_LOG2 + 4));
+	clip.x2 = clip.x1 + (1 << (BIN_SIZE_LOG2 + 4)) - 1;
+	clip.y2 = clip.y1 + (1 << (BIN_SIZE_LOG2 + 4)) - 1;
+
+	for (int index : queue.bins[tile]) {
+		const BinTriangle &tri = queue.triangles[index];
+		DrawTriangleRange(tri.v0, tri.v1, tri.v2, tri.range, clip, queue.sampler, queue.drawPixel);
+	}
+}
+
+}  // namespace Rasterizer
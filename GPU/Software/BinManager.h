@@ -0,0 +1,107 @@
+// Copyright (c) 2013- PPSSPP Project.
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, version 2.0 or later versions.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License 2.0 for more details.
+
+// A copy of the GPL 2.0 should have been included with the program.
+// If not, see http://www.gnu.org/licenses/
+
+// Official git repository and contact information can be found at
+// https://github.com/hrydgard/ppsspp and http://www.ppsspp.org/.
+
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "GPU/Software/DrawPixel.h"
+#include "GPU/Software/Sampler.h"
+#include "GPU/Software/TransformUnit.h"
+
+namespace Rasterizer {
+
+// Inclusive range in screen coordinates (1/16th pixels.)
+struct BinCoords {
+	int x1;
+	int y1;
+	int x2;
+	int y2;
+};
+
+// Queues triangles into screen tiles, so that all the triangles of a draw can be rasterized
+// on worker threads.  Each tile is drawn by one thread, in submission order, so the result
+// is identical to drawing serially.
+//
+// The rasterizer reads gstate and the framebuffer directly, so anything that changes either
+// must Flush() first.
+//
+// Kick() instead hands the queue to a raster thread and returns right away, so emulation can
+// continue while it draws.  A second queue collects triangles meanwhile.  HasPendingWork()
+// stays true until the raster thread is done, so the same Flush() checks cover it.
+class BinManager {
+public:
+	BinManager();
+	~BinManager();
+
+	// Only true when there are worker threads to spread the tiles over.
+	bool IsEnabled() const;
+
+	void AddTriangle(const VertexData &v0, const VertexData &v1, const VertexData &v2, const BinCoords &range);
+	// Draws everything queued, and waits for the raster thread.
+	void Flush();
+	// Starts drawing everything queued on the raster thread, if enabled, without waiting.
+	void Kick();
+
+	bool HasPendingWork() const {
+		return !queues_[current_].triangles.empty() || drawing_;
+	}
+
+private:
+	struct BinTriangle {
+		VertexData v0;
+		VertexData v1;
+		VertexData v2;
+		BinCoords range;
+	};
+
+	struct BinQueue {
+		std::vector<BinTriangle> triangles;
+		// Indices into triangles, per tile.
+		std::vector<std::vector<int>> bins;
+		std::vector<int> usedBins;
+
+		// Resolved on the emu thread, since looking them up may compile.
+		Sampler::Funcs sampler;
+		SingleFunc drawPixel;
+	};
+
+	void Drain(BinQueue &queue);
+	void DrawTile(const BinQueue &queue, int tile);
+	void WaitForDrawing();
+	void RasterThread();
+
+	BinQueue queues_[2];
+	// The queue being filled.  The other one may be drawing on the raster thread.
+	int current_ = 0;
+	std::atomic<int> nextBin_;
+
+	std::thread thread_;
+	std::mutex wakeMutex_;
+	std::mutex doneMutex_;
+	std::condition_variable wake_;
+	std::condition_variable done_;
+	BinQueue *drawingQueue_ = nullptr;
+	std::atomic<bool> drawing_;
+	bool exiting_ = false;
+};
+
+}  // namespace Rasterizer
@@ -0,0 +1,233 @@
+// Copyright (c) 2017- PPSSPP Project.
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, version 2.0 or later versions.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License 2.0 for more details.
+
+// A copy of the GPL 2.0 should have been included with the program.
+// If not, see http://www.gnu.org/licenses/
+
+// Official git repository and contact information can be found at
+// https://github.com/hrydgard/ppsspp and http://www.ppsspp.org/.
+
+#include <unordered_map>
+#include <mutex>
+#include "Common/StringUtils.h"
+#include "GPU/GPUState.h"
+#include "GPU/Software/DrawPixel.h"
+#include "GPU/Software/Rasterizer.h"
+
+namespace Rasterizer {
+
+std::mutex jitCacheLock;
+PixelJitCache *jitCache = nullptr;
+
+void Init() {
+	jitCache = new PixelJitCache();
+}
+
+void Shutdown() {
+	delete jitCache;
+	jitCache = nullptr;
+}
+
+bool DescribeCodePtr(const u8 *ptr, std::string &name) {
+	if (!jitCache->IsInSpace(ptr)) {
+		return false;
+	}
+
+	name = jitCache->DescribeCodePtr(ptr);
+	return true;
+}
+
+SingleFunc GetSingleFunc() {
+	PixelFuncID id;
+	jitCache->ComputePixelFuncID(&id);
+	SingleFunc jitted = jitCache->GetSingle(id);
+	if (jitted) {
+		return jitted;
+	}
+
+	return id.clearMode ? &DrawSinglePixelClearInterp : &DrawSinglePixelInterp;
+}
+
+PixelJitCache::PixelJitCache() {
+	// 256k should be plenty, these are small.
+	AllocCodeSpace(1024 * 64 * 4);
+
+	// Add some random code to "help" MSVC's buggy disassembler :(
+#if defined(_WIN32) && (defined(_M_IX86) || defined(_M_X64))
+	using namespace Gen;
+	for (int i = 0; i < 100; i++) {
+		MOV(32, R(EAX), R(EBX));
+		RET();
+	}
+#elif defined(ARM)
+	BKPT(0);
+	BKPT(0);
+#endif
+}
+
+void PixelJitCache::Clear() {
+	ClearCodeSpace(0);
+	cache_.clear();
+	addresses_.clear();
+}
+
+void PixelJitCache::ComputePixelFuncID(PixelFuncID *id_out) {
+	PixelFuncID id;
+
+	id.clearMode = gstate.isModeClear();
+	if (id.clearMode) {
+		id.colorClear = gstate.isClearModeColorMask();
+		id.stencilClear = gstate.isClearModeAlphaMask();
+		id.depthClear = gstate.isClearModeDepthMask();
+	}
+	id.applyDepthRange = !gstate.isModeThrough();
+	// Dithering happens even in clear mode.
+	id.dithering = gstate.isDitherEnabled();
+	id.applyColorWriteMask = gstate.getColorMask() != 0;
+	id.fbFormat = gstate.FrameBufFormat();
+
+	id.alphaTestFunc = GE_COMP_ALWAYS;
+	id.depthTestFunc = GE_COMP_ALWAYS;
+	id.stencilTestFunc = GE_COMP_ALWAYS;
+	if (!id.clearMode) {
+		if (gstate.isAlphaTestEnabled()) {
+			id.alphaTestFunc = gstate.getAlphaTestFunction();
+		}
+		if (gstate.isDepthTestEnabled()) {
+			id.depthTestFunc = gstate.getDepthTestFunction();
+			id.depthWrite = gstate.isDepthWriteEnabled();
+		}
+		if (gstate.isStencilTestEnabled()) {
+			id.stencilTest = true;
+			id.stencilTestFunc = gstate.getStencilTestFunction();
+			id.sFail = gstate.getStencilOpSFail();
+			id.zFail = gstate.getStencilOpZFail();
+			id.zPass = gstate.getStencilOpZPass();
+		}
+
+		id.colorTest = gstate.isColorTestEnabled();
+		id.applyFog = gstate.isFogEnabled() && !gstate.isModeThrough();
+
+		if (gstate.isAlphaBlendEnabled()) {
+			id.alphaBlend = true;
+			id.alphaBlendEq = gstate.getBlendEq();
+			id.alphaBlendSrc = gstate.getBlendFuncA();
+			id.alphaBlendDst = gstate.getBlendFuncB();
+		}
+
+		if (gstate.isLogicOpEnabled()) {
+			id.applyLogicOp = true;
+			id.logicOp = gstate.getLogicOp();
+		}
+	}
+
+	*id_out = id;
+}
+
+std::string PixelJitCache::DescribePixelFuncID(const PixelFuncID &id) {
+	static const char *const comparisons[] = { "NEVER", "ALWAYS", "EQ", "NE", "LT", "LE", "GT", "GE" };
+
+	std::string name;
+	switch ((GEBufferFormat)id.fbFormat) {
+	case GE_FORMAT_565: name = "565"; break;
+	case GE_FORMAT_5551: name = "5551"; break;
+	case GE_FORMAT_4444: name = "4444"; break;
+	case GE_FORMAT_8888: name = "8888"; break;
+	case GE_FORMAT_INVALID: name = "INVALID"; break;
+	}
+
+	if (id.clearMode) {
+		name += ":Clear";
+		if (id.colorClear) {
+			name += "C";
+		}
+		if (id.stencilClear) {
+			name += "S";
+		}
+		if (id.depthClear) {
+			name += "D";
+		}
+	}
+	if (id.applyDepthRange) {
+		name += ":DepthRange";
+	}
+	if (id.alphaTestFunc != GE_COMP_ALWAYS) {
+		name += StringFromFormat(":AT%s", comparisons[id.alphaTestFunc]);
+	}
+	if (id.depthTestFunc != GE_COMP_ALWAYS) {
+		name += StringFromFormat(":ZT%s", comparisons[id.depthTestFunc]);
+	}
+	if (id.depthWrite) {
+		name += ":ZWrite";
+	}
+	if (id.stencilTest) {
+		name += StringFromFormat(":ST%s:%d%d%d", comparisons[id.stencilTestFunc], id.sFail, id.zFail, id.zPass);
+	}
+	if (id.colorTest) {
+		name += ":ColorTest";
+	}
+	if (id.applyFog) {
+		name += ":Fog";
+	}
+	if (id.alphaBlend) {
+		name += StringFromFormat(":Blend%d:%d:%d", id.alphaBlendEq, id.alphaBlendSrc, id.alphaBlendDst);
+	}
+	if (id.dithering) {
+		name += ":Dither";
+	}
+	if (id.applyLogicOp) {
+		name += StringFromFormat(":Logic%d", id.logicOp);
+	}
+	if (id.applyColorWriteMask) {
+		name += ":Mask";
+	}
+	return name;
+}
+
+std::string PixelJitCache::DescribeCodePtr(const u8 *ptr) {
+	ptrdiff_t dist = 0x7FFFFFFF;
+	PixelFuncID found;
+	for (const auto &it : addresses_) {
+		ptrdiff_t it_dist = ptr - it.second;
+		if (it_dist >= 0 && it_dist < dist) {
+			found = it.first;
+			dist = it_dist;
+		}
+	}
+
+	return DescribePixelFuncID(found);
+}
+
+SingleFunc PixelJitCache::GetSingle(const PixelFuncID &id) {
+	std::lock_guard<std::mutex> guard(jitCacheLock);
+
+	auto it = cache_.find(id);
+	if (it != cache_.end()) {
+		return it->second;
+	}
+
+	// Nothing is unrolled, so even a function using every state is well under 2KB of code.
+	// A game cycling through a few hundred states can still fill the space, so keep a margin.
+	if (GetSpaceLeft() < 16384) {
+		Clear();
+	}
+
+#ifdef _M_X64
+	addresses_[id] = GetCodePointer();
+	SingleFunc func = CompileSingle(id);
+	cache_[id] = func;
+	return func;
+#else
+	return nullptr;
+#endif
+}
+
+};
@@ -0,0 +1,153 @@
+// Copyright (c) 2017- PPSSPP Project.
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, version 2.0 or later versions.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License 2.0 for more details.
+
+// A copy of the GPL 2.0 should have been included with the program.
+// If not, see http://www.gnu.org/licenses/
+
+// Official git repository and contact information can be found at
+// https://github.com/hrydgard/ppsspp and http://www.ppsspp.org/.
+
+#pragma once
+
+#include "ppsspp_config.h"
+
+#include <string>
+#include <unordered_map>
+#include <vector>
+#if PPSSPP_ARCH(ARM)
+#include "Common/ArmEmitter.h"
+#elif PPSSPP_ARCH(ARM64)
+#include "Common/Arm64Emitter.h"
+#elif PPSSPP_ARCH(X86) || PPSSPP_ARCH(AMD64)
+#include "Common/x64Emitter.h"
+#elif PPSSPP_ARCH(MIPS)
+#include "Common/MipsEmitter.h"
+#else
+#include "Common/FakeEmitter.h"
+#endif
+#include "GPU/Math3D.h"
+
+struct PixelFuncID {
+	PixelFuncID() : fullKey(0) {
+	}
+
+	union {
+		u64 fullKey;
+		struct {
+			bool clearMode : 1;
+			// Only set in clear mode.
+			bool colorClear : 1;
+			bool stencilClear : 1;
+			bool depthClear : 1;
+			bool applyDepthRange : 1;
+			bool dithering : 1;
+			bool applyColorWriteMask : 1;
+			bool applyLogicOp : 1;
+
+			uint8_t fbFormat : 2;
+			// ALWAYS when disabled.
+			uint8_t alphaTestFunc : 3;
+			uint8_t depthTestFunc : 3;
+
+			uint8_t stencilTestFunc : 3;
+			uint8_t sFail : 3;
+			bool colorTest : 1;
+			bool applyFog : 1;
+
+			uint8_t zFail : 3;
+			uint8_t zPass : 3;
+			bool depthWrite : 1;
+			bool stencilTest : 1;
+
+			uint8_t alphaBlendEq : 3;
+			bool alphaBlend : 1;
+			uint8_t logicOp : 4;
+
+			uint8_t alphaBlendSrc : 4;
+			uint8_t alphaBlendDst : 4;
+		};
+	};
+
+	bool operator == (const PixelFuncID &other) const {
+		return fullKey == other.fullKey;
+	}
+};
+
+namespace std {
+
+template <>
+struct hash<PixelFuncID> {
+	std::size_t operator()(const PixelFuncID &k) const {
+		return hash<u64>()(k.fullKey);
+	}
+};
+
+};
+
+namespace Rasterizer {
+
+// Runs the whole per-pixel pipeline (tests, blending, masks, writes) for one pixel.
+typedef void (*SingleFunc)(int x, int y, int z, int fog, const Math3D::Vec4<int> &color_in);
+SingleFunc GetSingleFunc();
+
+void Init();
+void Shutdown();
+
+bool DescribeCodePtr(const u8 *ptr, std::string &name);
+
+#if PPSSPP_ARCH(ARM)
+class PixelJitCache : public ArmGen::ARMXCodeBlock {
+#elif PPSSPP_ARCH(ARM64)
+class PixelJitCache : public Arm64Gen::ARM64CodeBlock {
+#elif PPSSPP_ARCH(X86) || PPSSPP_ARCH(AMD64)
+class PixelJitCache : public Gen::XCodeBlock {
+#elif PPSSPP_ARCH(MIPS)
+class PixelJitCache : public MIPSGen::MIPSCodeBlock {
+#else
+class PixelJitCache : public FakeGen::FakeXCodeBlock {
+#endif
+public:
+	PixelJitCache();
+
+	void ComputePixelFuncID(PixelFuncID *id_out);
+
+	// Returns a pointer to the code to run, or nullptr if the state isn't supported.
+	SingleFunc GetSingle(const PixelFuncID &id);
+	void Clear();
+
+	std::string DescribeCodePtr(const u8 *ptr);
+	std::string DescribePixelFuncID(const PixelFuncID &id);
+
+private:
+	SingleFunc CompileSingle(const PixelFuncID &id);
+
+	bool Jit_ApplyDepthRange(const PixelFuncID &id);
+	bool Jit_AlphaTest(const PixelFuncID &id);
+	bool Jit_DepthTest(const PixelFuncID &id);
+	bool Jit_WriteDepth(const PixelFuncID &id);
+	bool Jit_ReadColor(const PixelFuncID &id);
+	bool Jit_AlphaBlend(const PixelFuncID &id);
+	bool Jit_ApplyColorMasks(const PixelFuncID &id);
+	bool Jit_WriteColor(const PixelFuncID &id);
+
+#if PPSSPP_ARCH(X86) || PPSSPP_ARCH(AMD64)
+	// Computes *base + (y * stride + x) * bpp into dest, clobbering temp.
+	void Jit_CalculateAddress(Gen::X64Reg dest, Gen::X64Reg temp, const u32 *strideReg, u8 *const *base, int bpp);
+
+	// Targets for failed tests, all of which just return.
+	std::vector<Gen::FixupBranch> discards_;
+#endif
+
+	std::unordered_map<PixelFuncID, SingleFunc> cache_;
+	std::unordered_map<PixelFuncID, const u8 *> addresses_;
+};
+
+};
@@ -0,0 +1,394 @@
+// Copyright (c) 2017- PPSSPP Project.
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, version 2.0 or later versions.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License 2.0 for more details.
+
+// A copy of the GPL 2.0 should have been included with the program.
+// If not, see http://www.gnu.org/licenses/
+
+// Official git repository and contact information can be found at
+// https://github.com/hrydgard/ppsspp and http://www.ppsspp.org/.
+
+#include "ppsspp_config.h"
+#if PPSSPP_ARCH(X86) || PPSSPP_ARCH(AMD64)
+
+#include "Common/x64Emitter.h"
+#include "GPU/GPUState.h"
+#include "GPU/Software/DrawPixel.h"
+#include "GPU/Software/SoftGpu.h"
+#include "GPU/ge_constants.h"
+
+using namespace Gen;
+
+namespace Rasterizer {
+
+#ifdef _WIN32
+static const X64Reg arg1Reg = RCX;
+static const X64Reg arg2Reg = RDX;
+static const X64Reg arg3Reg = R8;
+static const X64Reg arg4Reg = R9;
+// 5 is on the stack, we load it into arg4Reg since fog is unused.
+static const X64Reg colorPtrReg = arg4Reg;
+#else
+static const X64Reg arg1Reg = RDI;
+static const X64Reg arg2Reg = RSI;
+static const X64Reg arg3Reg = RDX;
+static const X64Reg arg4Reg = RCX;
+static const X64Reg arg5Reg = R8;
+
+static const X64Reg colorPtrReg = arg5Reg;
+#endif
+
+static const X64Reg xReg = arg1Reg;
+static const X64Reg yReg = arg2Reg;
+static const X64Reg zReg = arg3Reg;
+
+// The clamped color, as RGBA8888.
+static const X64Reg argbReg = RAX;
+static const X64Reg tempReg1 = R10;
+static const X64Reg tempReg2 = R11;
+// Free once the color has been loaded.
+static const X64Reg tempReg3 = colorPtrReg;
+
+// Hold the buffer addresses once computed.
+static const X64Reg depthAddrReg = tempReg2;
+static const X64Reg colorAddrReg = tempReg2;
+static const X64Reg oldColorReg = tempReg3;
+
+static const X64Reg fpScratchReg1 = XMM1;
+static const X64Reg fpScratchReg2 = XMM2;
+static const X64Reg fpScratchReg3 = XMM3;
+static const X64Reg fpScratchReg4 = XMM4;
+
+alignas(16) static const int const255_4[4] = { 255, 255, 255, 255 };
+alignas(16) static const float by255[4] = { 1.0f / 255.0f, 1.0f / 255.0f, 1.0f / 255.0f, 1.0f / 255.0f };
+
+SingleFunc PixelJitCache::CompileSingle(const PixelFuncID &id) {
+	// Only the common states are compiled so far, the rest use the interpreter.
+	if (id.applyFog || id.colorTest || id.stencilTest || id.dithering || id.applyLogicOp)
+		return nullptr;
+	if (id.alphaBlend) {
+		if (id.fbFormat != GE_FORMAT_8888 || id.alphaBlendEq != GE_BLENDMODE_MUL_AND_ADD)
+			return nullptr;
+		if (id.alphaBlendSrc != GE_SRCBLEND_SRCALPHA || id.alphaBlendDst != GE_DSTBLEND_INVSRCALPHA)
+			return nullptr;
+	}
+	if (id.fbFormat != GE_FORMAT_8888) {
+		if (id.applyColorWriteMask)
+			return nullptr;
+		// Partial clears of 16-bit formats aren't handled.
+		if (id.clearMode && (!id.colorClear || (!id.stencilClear && id.fbFormat != GE_FORMAT_565)))
+			return nullptr;
+	}
+
+	BeginWrite();
+	const u8 *start = AlignCode16();
+	discards_.clear();
+
+#ifdef _WIN32
+	// The fifth argument is after the return address and the shadow space.
+	MOV(PTRBITS, R(colorPtrReg), MDisp(RSP, 40));
+#endif
+
+	// Clamp to 0-255 and pack, same as Clamp(0, 255) and ToRGBA().
+	MOVDQU(XMM0, MatR(colorPtrReg));
+	PACKSSDW(XMM0, R(XMM0));
+	PACKUSWB(XMM0, R(XMM0));
+	MOVD_xmm(R(argbReg), XMM0);
+
+	bool success = true;
+	success = success && Jit_ApplyDepthRange(id);
+	success = success && Jit_AlphaTest(id);
+	success = success && Jit_DepthTest(id);
+	success = success && Jit_WriteDepth(id);
+	success = success && Jit_ReadColor(id);
+	success = success && Jit_AlphaBlend(id);
+	success = success && Jit_ApplyColorMasks(id);
+	success = success && Jit_WriteColor(id);
+
+	for (FixupBranch &fixup : discards_) {
+		SetJumpTarget(fixup);
+	}
+	discards_.clear();
+	RET();
+
+	if (!success) {
+		EndWrite();
+		SetCodePtr(const_cast<u8 *>(start));
+		return nullptr;
+	}
+
+	EndWrite();
+	return (SingleFunc)start;
+}
+
+void PixelJitCache::Jit_CalculateAddress(X64Reg dest, X64Reg temp, const u32 *strideReg, u8 *const *base, int bpp) {
+	MOV(PTRBITS, R(dest), ImmPtr(strideReg));
+	MOV(32, R(dest), MatR(dest));
+	AND(32, R(dest), Imm32(0x7FC));
+	IMUL(32, dest, R(yReg));
+	ADD(32, R(dest), R(xReg));
+
+	MOV(PTRBITS, R(temp), ImmPtr(base));
+	MOV(PTRBITS, R(temp), MatR(temp));
+	LEA(PTRBITS, dest, MComplex(temp, dest, bpp, 0));
+}
+
+static CCFlags DiscardCondition(GEComparison func) {
+	// These are the inverse of the test, for jumping out.  Values are all unsigned.
+	switch (func) {
+	case GE_COMP_EQUAL: return CC_NE;
+	case GE_COMP_NOTEQUAL: return CC_E;
+	case GE_COMP_LESS: return CC_AE;
+	case GE_COMP_LEQUAL: return CC_A;
+	case GE_COMP_GREATER: return CC_BE;
+	case GE_COMP_GEQUAL: return CC_B;
+	default:
+		_assert_msg_(G3D, false, "Unexpected comparison");
+		return CC_NE;
+	}
+}
+
+bool PixelJitCache::Jit_ApplyDepthRange(const PixelFuncID &id) {
+	if (!id.applyDepthRange)
+		return true;
+
+	MOV(PTRBITS, R(tempReg1), ImmPtr(&gstate.minz));
+	MOVZX(32, 16, tempReg2, MatR(tempReg1));
+	CMP(32, R(zReg), R(tempReg2));
+	discards_.push_back(J_CC(CC_B, true));
+
+	MOV(PTRBITS, R(tempReg1), ImmPtr(&gstate.maxz));
+	MOVZX(32, 16, tempReg2, MatR(tempReg1));
+	CMP(32, R(zReg), R(tempReg2));
+	discards_.push_back(J_CC(CC_A, true));
+	return true;
+}
+
+bool PixelJitCache::Jit_AlphaTest(const PixelFuncID &id) {
+	if (id.alphaTestFunc == GE_COMP_ALWAYS)
+		return true;
+	if (id.alphaTestFunc == GE_COMP_NEVER) {
+		discards_.push_back(J(true));
+		return true;
+	}
+
+	// The mask is bits 16-23 and the ref bits 8-15.  The top byte is the command.
+	MOV(PTRBITS, R(tempReg1), ImmPtr(&gstate.alphatest));
+	MOV(32, R(tempReg1), MatR(tempReg1));
+	MOV(32, R(tempReg2), R(tempReg1));
+	SHR(32, R(tempReg1), Imm8(16));
+	SHR(32, R(tempReg2), Imm8(8));
+	AND(32, R(tempReg2), R(tempReg1));
+	AND(32, R(tempReg2), Imm32(0xFF));
+
+	MOV(32, R(tempReg3), R(argbReg));
+	SHR(32, R(tempReg3), Imm8(24));
+	AND(32, R(tempReg3), R(tempReg1));
+
+	CMP(32, R(tempReg3), R(tempReg2));
+	discards_.push_back(J_CC(DiscardCondition((GEComparison)id.alphaTestFunc), true));
+	return true;
+}
+
+bool PixelJitCache::Jit_DepthTest(const PixelFuncID &id) {
+	bool writeDepth = id.clearMode ? id.depthClear : id.depthWrite;
+	if (id.depthTestFunc == GE_COMP_ALWAYS && !writeDepth)
+		return true;
+	if (id.depthTestFunc == GE_COMP_NEVER) {
+		discards_.push_back(J(true));
+		return true;
+	}
+
+	Jit_CalculateAddress(depthAddrReg, tempReg1, &gstate.zbwidth, &depthbuf.data, 2);
+	if (id.depthTestFunc == GE_COMP_ALWAYS)
+		return true;
+
+	MOVZX(32, 16, tempReg1, MatR(depthAddrReg));
+	CMP(32, R(zReg), R(tempReg1));
+	discards_.push_back(J_CC(DiscardCondition((GEComparison)id.depthTestFunc), true));
+	return true;
+}
+
+bool PixelJitCache::Jit_WriteDepth(const PixelFuncID &id) {
+	bool writeDepth = id.clearMode ? id.depthClear : id.depthWrite;
+	if (!writeDepth || id.depthTestFunc == GE_COMP_NEVER)
+		return true;
+
+	// Jit_DepthTest left the address in depthAddrReg.
+	MOV(16, MatR(depthAddrReg), R(zReg));
+	return true;
+}
+
+bool PixelJitCache::Jit_ReadColor(const PixelFuncID &id) {
+	int bpp = id.fbFormat == GE_FORMAT_8888 ? 4 : 2;
+	Jit_CalculateAddress(colorAddrReg, tempReg1, &gstate.fbwidth, &fb.data, bpp);
+
+	if (id.fbFormat == GE_FORMAT_8888) {
+		MOV(32, R(oldColorReg), MatR(colorAddrReg));
+	} else if (id.fbFormat != GE_FORMAT_565 && !id.clearMode) {
+		// Only needed to keep the stencil bits.
+		MOVZX(32, 16, oldColorReg, MatR(colorAddrReg));
+	}
+	return true;
+}
+
+bool PixelJitCache::Jit_AlphaBlend(const PixelFuncID &id) {
+	if (!id.alphaBlend)
+		return true;
+
+	// Only MUL_AND_ADD with SRCALPHA / INVSRCALPHA gets here, matching AlphaBlendingResult() exactly.
+	PXOR(fpScratchReg4, R(fpScratchReg4));
+	MOVD_xmm(fpScratchReg1, R(argbReg));
+	PUNPCKLBW(fpScratchReg1, R(fpScratchReg4));
+	PUNPCKLWD(fpScratchReg1, R(fpScratchReg4));
+	MOVD_xmm(fpScratchReg2, R(oldColorReg));
+	PUNPCKLBW(fpScratchReg2, R(fpScratchReg4));
+	PUNPCKLWD(fpScratchReg2, R(fpScratchReg4));
+
+	// Source factor is alpha, dest factor 255 - alpha.
+	PSHUFD(fpScratchReg3, R(fpScratchReg1), 0xFF);
+	MOVDQA(fpScratchReg4, M(const255_4));
+	PSUBD(fpScratchReg4, R(fpScratchReg3));
+
+	CVTDQ2PS(fpScratchReg1, R(fpScratchReg1));
+	CVTDQ2PS(fpScratchReg2, R(fpScratchReg2));
+	CVTDQ2PS(fpScratchReg3, R(fpScratchReg3));
+	CVTDQ2PS(fpScratchReg4, R(fpScratchReg4));
+	MULPS(fpScratchReg1, R(fpScratchReg3));
+	MULPS(fpScratchReg2, R(fpScratchReg4));
+	ADDPS(fpScratchReg1, R(fpScratchReg2));
+	MULPS(fpScratchReg1, M(by255));
+	CVTPS2DQ(fpScratchReg1, R(fpScratchReg1));
+
+	// Like ToRGB(), this clamps.  Alpha is replaced later.
+	PACKSSDW(fpScratchReg1, R(fpScratchReg1));
+	PACKUSWB(fpScratchReg1, R(fpScratchReg1));
+	MOVD_xmm(R(argbReg), fpScratchReg1);
+	return true;
+}
+
+bool PixelJitCache::Jit_ApplyColorMasks(const PixelFuncID &id) {
+	if (id.fbFormat != GE_FORMAT_8888) {
+		// 16-bit formats handle the stencil bits while converting, and don't support the rest.
+		return !id.applyColorWriteMask;
+	}
+
+	if (!id.clearMode) {
+		// Without a stencil test, the stencil (alpha) is kept as is.
+		AND(32, R(argbReg), Imm32(0x00FFFFFF));
+		MOV(32, R(tempReg1), R(oldColorReg));
+		AND(32, R(tempReg1), Imm32(0xFF000000));
+		OR(32, R(argbReg), R(tempReg1));
+	} else {
+		u32 keepMask = (id.colorClear ? 0 : 0x00FFFFFF) | (id.stencilClear ? 0 : 0xFF000000);
+		if (keepMask != 0) {
+			AND(32, R(argbReg), Imm32(~keepMask));
+			MOV(32, R(tempReg1), R(oldColorReg));
+			AND(32, R(tempReg1), Imm32(keepMask));
+			OR(32, R(argbReg), R(tempReg1));
+		}
+	}
+
+	if (id.applyColorWriteMask) {
+		// x and y aren't needed once we have the address, so use them for the mask.
+		MOV(PTRBITS, R(yReg), ImmPtr(&gstate.pmskc));
+		MOV(32, R(xReg), MatR(yReg));
+		AND(32, R(xReg), Imm32(0x00FFFFFF));
+		MOV(PTRBITS, R(yReg), ImmPtr(&gstate.pmska));
+		MOV(32, R(yReg), MatR(yReg));
+		SHL(32, R(yReg), Imm8(24));
+		OR(32, R(xReg), R(yReg));
+
+		// new ^ ((new ^ old) & mask) keeps the masked bits of old.
+		MOV(32, R(tempReg1), R(argbReg));
+		XOR(32, R(tempReg1), R(oldColorReg));
+		AND(32, R(tempReg1), R(xReg));
+		XOR(32, R(argbReg), R(tempReg1));
+	}
+	return true;
+}
+
+bool PixelJitCache::Jit_WriteColor(const PixelFuncID &id) {
+	// Same as the conversions in ColorConv.
+	switch (id.fbFormat) {
+	case GE_FORMAT_565:
+		MOV(32, R(tempReg1), R(argbReg));
+		SHR(32, R(tempReg1), Imm8(3));
+		AND(32, R(tempReg1), Imm32(0x001F));
+		MOV(32, R(xReg), R(argbReg));
+		SHR(32, R(xReg), Imm8(5));
+		AND(32, R(xReg), Imm32(0x07E0));
+		OR(32, R(tempReg1), R(xReg));
+		MOV(32, R(xReg), R(argbReg));
+		SHR(32, R(xReg), Imm8(8));
+		AND(32, R(xReg), Imm32(0xF800));
+		OR(32, R(tempReg1), R(xReg));
+		MOV(16, MatR(colorAddrReg), R(tempReg1));
+		break;
+
+	case GE_FORMAT_5551:
+		MOV(32, R(tempReg1), R(argbReg));
+		SHR(32, R(tempReg1), Imm8(3));
+		AND(32, R(tempReg1), Imm32(0x001F));
+		MOV(32, R(xReg), R(argbReg));
+		SHR(32, R(xReg), Imm8(6));
+		AND(32, R(xReg), Imm32(0x03E0));
+		OR(32, R(tempReg1), R(xReg));
+		MOV(32, R(xReg), R(argbReg));
+		SHR(32, R(xReg), Imm8(9));
+		AND(32, R(xReg), Imm32(0x7C00));
+		OR(32, R(tempReg1), R(xReg));
+		if (id.clearMode) {
+			MOV(32, R(xReg), R(argbReg));
+			SHR(32, R(xReg), Imm8(16));
+		} else {
+			MOV(32, R(xReg), R(oldColorReg));
+		}
+		AND(32, R(xReg), Imm32(0x8000));
+		OR(32, R(tempReg1), R(xReg));
+		MOV(16, MatR(colorAddrReg), R(tempReg1));
+		break;
+
+	case GE_FORMAT_4444:
+		MOV(32, R(tempReg1), R(argbReg));
+		SHR(32, R(tempReg1), Imm8(4));
+		AND(32, R(tempReg1), Imm32(0x000F));
+		MOV(32, R(xReg), R(argbReg));
+		SHR(32, R(xReg), Imm8(8));
+		AND(32, R(xReg), Imm32(0x00F0));
+		OR(32, R(tempReg1), R(xReg));
+		MOV(32, R(xReg), R(argbReg));
+		SHR(32, R(xReg), Imm8(12));
+		AND(32, R(xReg), Imm32(0x0F00));
+		OR(32, R(tempReg1), R(xReg));
+		if (id.clearMode) {
+			MOV(32, R(xReg), R(argbReg));
+			SHR(32, R(xReg), Imm8(16));
+		} else {
+			MOV(32, R(xReg), R(oldColorReg));
+		}
+		AND(32, R(xReg), Imm32(0xF000));
+		OR(32, R(tempReg1), R(xReg));
+		MOV(16, MatR(colorAddrReg), R(tempReg1));
+		break;
+
+	case GE_FORMAT_8888:
+		MOV(32, MatR(colorAddrReg), R(argbReg));
+		break;
+
+	default:
+		return false;
+	}
+	return true;
+}
+
+};
+
+#endif
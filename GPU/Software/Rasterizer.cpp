@@ -21,7 +21,6 @@
 #include "base/basictypes.h"
 #include "profiler/profiler.h"
 
-#include "Common/ThreadPools.h"
 #include "Common/ColorConv.h"
 #include "Core/Config.h"
 #include "Core/MemMap.h"
@@ -30,6 +29,7 @@
 
 #include "GPU/Common/TextureCacheCommon.h"
 #include "GPU/Common/TextureDecoder.h"
+#include "GPU/Software/BinManager.h"
 #include "GPU/Software/SoftGpu.h"
 #include "GPU/Software/Rasterizer.h"
 #include "GPU/Software/Sampler.h"
@@ -40,6 +40,8 @@
 
 namespace Rasterizer {
 
+static BinManager binner;
+
 // Only OK on x64 where our stack is aligned
 #if defined(_M_SSE) && !defined(_M_IX86)
 static inline __m128 Interpolate(const __m128 &c0, const __m128 &c1, const __m128 &c2, int w0, int w1, int w2, float wsum) {
@@ -936,8 +938,12 @@ inline void DrawSinglePixel(const DrawingCoords &p, u16 z, u8 fog, const Vec4<in
 	SetPixelColor(p.x, p.y, new_color);
 }
 
-void DrawSinglePixelNonClear(const DrawingCoords &p, u16 z, u8 fog, const Vec4<int> &color_in) {
-	DrawSinglePixel<false>(p, z, fog, color_in);
+void DrawSinglePixelInterp(int x, int y, int z, int fog, const Vec4<int> &color_in) {
+	DrawSinglePixel<false>(DrawingCoords(x, y, 0), (u16)z, (u8)fog, color_in);
+}
+
+void DrawSinglePixelClearInterp(int x, int y, int z, int fog, const Vec4<int> &color_in) {
+	DrawSinglePixel<true>(DrawingCoords(x, y, 0), (u16)z, (u8)fog, color_in);
 }
 
 static inline void ApplyTexturing(Sampler::Funcs sampler, Vec4<int> &prim_color, float s, float t, int texlevel, int frac_texlevel, bool bilinear, u8 *texptr[], int texbufw[]) {
@@ -1044,8 +1050,10 @@ static inline void CalculateSamplingParams(const float ds, const float dt, const
 }
 
 static inline void ApplyTexturing(Sampler::Funcs sampler, Vec4<int> *prim_color, const Vec4<float> &s, const Vec4<float> &t, int maxTexLevel, u8 *texptr[], int texbufw[]) {
-	float ds = s[1] - s[0];
-	float dt = t[2] - t[0];
+	// Take the larger of the x and y derivatives across the quad, so rotated or mirrored
+	// textures still pick a sensible level.  For the usual axis aligned case, this is s/x and t/y.
+	float ds = std::max(fabsf(s[1] - s[0]), fabsf(s[2] - s[0]));
+	float dt = std::max(fabsf(t[1] - t[0]), fabsf(t[2] - t[0]));
 
 	int level;
 	int levelFrac;
@@ -1122,6 +1130,16 @@ static inline bool AnyMask(const Vec4<int> &mask) {
 #endif
 }
 
+// Edges are linear, so if one is outside at the corners of a span of quads, it's outside for all of it.
+// span holds the offsets from the first quad's values to the far corners.
+static inline bool EdgeRejectsQuads(const Vec4<int> &w, const Vec4<int> &bias, const Vec4<int> &span) {
+#if defined(_M_SSE) && !defined(_M_IX86)
+	return !AnyMask(_mm_add_epi32(w.ivec, _mm_add_epi32(bias.ivec, span.ivec)));
+#else
+	return !AnyMask(w + bias + span);
+#endif
+}
+
 static inline Vec4<float> EdgeRecip(const Vec4<int> &w0, const Vec4<int> &w1, const Vec4<int> &w2) {
 #if defined(_M_SSE) && !defined(_M_IX86)
 	__m128i wsum = _mm_add_epi32(w0.ivec, _mm_add_epi32(w1.ivec, w2.ivec));
@@ -1132,11 +1150,22 @@ static inline Vec4<float> EdgeRecip(const Vec4<int> &w0, const Vec4<int> &w1, co
 #endif
 }
 
+static inline Vec4<int> MakeClipMask(const ScreenCoords &pprime, const BinCoords &clip) {
+	Vec4<int> mask;
+	for (int i = 0; i < 4; ++i) {
+		int x = pprime.x + (i & 1) * 16;
+		int y = pprime.y + (i / 2) * 16;
+		mask[i] = x < clip.x1 || x > clip.x2 || y < clip.y1 || y > clip.y2 ? -1 : 0;
+	}
+	return mask;
+}
+
+// Draws the pixels of the triangle within both range (its bounds) and clip (a bin tile.)
+// Quads stay aligned to range, so any split into clip rects draws exactly the same pixels.
 template <bool clearMode>
 void DrawTriangleSlice(
 	const VertexData& v0, const VertexData& v1, const VertexData& v2,
-	int minX, int minY, int maxX, int maxY,
-	bool byY, int h1, int h2)
+	const BinCoords &range, const BinCoords &clip, const Sampler::Funcs &sampler, SingleFunc drawPixel)
 {
 	Vec4<int> bias0 = Vec4<int>::AssignToAll(IsRightSideOrFlatBottomLine(v0.screenpos.xy(), v1.screenpos.xy(), v2.screenpos.xy()) ? -1 : 0);
 	Vec4<int> bias1 = Vec4<int>::AssignToAll(IsRightSideOrFlatBottomLine(v1.screenpos.xy(), v2.screenpos.xy(), v0.screenpos.xy()) ? -1 : 0);
@@ -1168,13 +1197,11 @@ void DrawTriangleSlice(
 	TriangleEdge e1;
 	TriangleEdge e2;
 
-	if (byY) {
-		maxY = std::min(maxY, minY + h2 * 16 * 2);
-		minY += h1 * 16 * 2;
-	} else {
-		maxX = std::min(maxX, minX + h2 * 16 * 2);
-		minX += h1 * 16 * 2;
-	}
+	const int minX = range.x1 + std::max(0, (clip.x1 - range.x1) / 32) * 32;
+	const int minY = range.y1 + std::max(0, (clip.y1 - range.y1) / 32) * 32;
+	const int maxX = std::min(range.x2, clip.x2);
+	const int maxY = range.y2;
+	const bool needClipMask = clip.x1 > range.x1 || clip.y1 > range.y1 || clip.x2 < range.x2 || clip.y2 < range.y2;
 
 	ScreenCoords pprime(minX, minY, 0);
 	Vec4<int> w0_base = e0.Start(v1.screenpos, v2.screenpos, pprime);
@@ -1184,10 +1211,19 @@ void DrawTriangleSlice(
 	// All the z values are the same, no interpolation required.
 	// This is common, and when we interpolate, we lose accuracy.
 	const bool flatZ = v0.screenpos.z == v1.screenpos.z && v0.screenpos.z == v2.screenpos.z;
-
-	Sampler::Funcs sampler = Sampler::GetFuncs();
-
-	for (pprime.y = minY; pprime.y < maxY; pprime.y += 32,
+	// Failing the depth test has no side effects without stencil ops, so we can do it before texturing.
+	const bool earlyDepthTest = !clearMode && gstate.isDepthTestEnabled() && !gstate.isStencilTestEnabled();
+
+	// For coarse rejection of whole rows, and of blocks of 4 quads within a row.
+	const int rowQuads = maxX >= minX ? (maxX - minX) / 32 + 1 : 1;
+	const Vec4<int> rowSpan0 = Vec4<int>(0, 1, 0, 1) * (e0.stepX.x * (rowQuads - 1));
+	const Vec4<int> rowSpan1 = Vec4<int>(0, 1, 0, 1) * (e1.stepX.x * (rowQuads - 1));
+	const Vec4<int> rowSpan2 = Vec4<int>(0, 1, 0, 1) * (e2.stepX.x * (rowQuads - 1));
+	const Vec4<int> blockSpan0 = Vec4<int>(0, 1, 0, 1) * (e0.stepX.x * 3);
+	const Vec4<int> blockSpan1 = Vec4<int>(0, 1, 0, 1) * (e1.stepX.x * 3);
+	const Vec4<int> blockSpan2 = Vec4<int>(0, 1, 0, 1) * (e2.stepX.x * 3);
+
+	for (pprime.y = minY; pprime.y < maxY && pprime.y <= clip.y2; pprime.y += 32,
 										w0_base = e0.StepY(w0_base),
 										w1_base = e1.StepY(w1_base),
 										w2_base = e2.StepY(w2_base)) {
@@ -1195,9 +1231,12 @@ void DrawTriangleSlice(
 		Vec4<int> w1 = w1_base;
 		Vec4<int> w2 = w2_base;
 
+		if (EdgeRejectsQuads(w0, bias0, rowSpan0) || EdgeRejectsQuads(w1, bias1, rowSpan1) || EdgeRejectsQuads(w2, bias2, rowSpan2))
+			continue;
+
 		// TODO: Maybe we can clip the edges instead?
 		int scissorYPlus1 = pprime.y + 16 > maxY ? -1 : 0;
-		Vec4<int> scissor_mask = Vec4<int>(0, maxX - minX - 1, scissorYPlus1, (maxX - minX - 1) | scissorYPlus1);
+		Vec4<int> scissor_mask = Vec4<int>(0, range.x2 - minX - 1, scissorYPlus1, (range.x2 - minX - 1) | scissorYPlus1);
 		Vec4<int> scissor_step = Vec4<int>(0, -32, 0, -32);
 
 		pprime.x = minX;
@@ -1212,9 +1251,29 @@ void DrawTriangleSlice(
 
 			// If p is on or inside all edges, render pixel
 			Vec4<int> mask = MakeMask(w0, w1, w2, bias0, bias1, bias2, scissor_mask);
+			if (needClipMask)
+				mask = mask | MakeClipMask(pprime, clip);
 			if (AnyMask(mask)) {
 				Vec4<float> wsum_recip = EdgeRecip(w0, w1, w2);
 
+				Vec4<int> z;
+				if (flatZ) {
+					z = Vec4<int>::AssignToAll(v2.screenpos.z);
+				} else {
+					// TODO: Is that the correct way to interpolate?
+					Vec4<float> zfloats = w0.Cast<float>() * v0.screenpos.z + w1.Cast<float>() * v1.screenpos.z + w2.Cast<float>() * v2.screenpos.z;
+					z = (zfloats * wsum_recip).Cast<int>();
+				}
+
+				if (earlyDepthTest) {
+					for (int i = 0; i < 4; ++i) {
+						if (mask[i] >= 0 && !DepthTestPassed(p.x + (i & 1), p.y + (i / 2), (u16)z[i]))
+							mask[i] = -1;
+					}
+					if (!AnyMask(mask))
+						continue;
+				}
+
 				Vec4<int> prim_color[4];
 				Vec3<int> sec_color[4];
 				if (gstate.getShadeMode() == GE_SHADE_GOURAUD && !clearMode) {
@@ -1268,15 +1327,6 @@ void DrawTriangleSlice(
 					}
 				}
 
-				Vec4<int> z;
-				if (flatZ) {
-					z = Vec4<int>::AssignToAll(v2.screenpos.z);
-				} else {
-					// TODO: Is that the correct way to interpolate?
-					Vec4<float> zfloats = w0.Cast<float>() * v0.screenpos.z + w1.Cast<float>() * v1.screenpos.z + w2.Cast<float>() * v2.screenpos.z;
-					z = (zfloats * wsum_recip).Cast<int>();
-				}
-
 				DrawingCoords subp = p;
 				for (int i = 0; i < 4; ++i) {
 					if (mask[i] < 0) {
@@ -1285,8 +1335,18 @@ void DrawTriangleSlice(
 					subp.x = p.x + (i & 1);
 					subp.y = p.y + (i / 2);
 
-					DrawSinglePixel<clearMode>(subp, (u16)z[i], fog[i], prim_color[i]);
+					drawPixel(subp.x, subp.y, (u16)z[i], fog[i], prim_color[i]);
+				}
+			} else if (EdgeRejectsQuads(w0, bias0, blockSpan0) || EdgeRejectsQuads(w1, bias1, blockSpan1) || EdgeRejectsQuads(w2, bias2, blockSpan2)) {
+				// Nothing in the next 3 quads either, skip them (the loop steps past the 4th.)
+				for (int i = 0; i < 3; ++i) {
+					w0 = e0.StepX(w0);
+					w1 = e1.StepX(w1);
+					w2 = e2.StepX(w2);
+					scissor_mask = scissor_mask + scissor_step;
 				}
+				pprime.x += 32 * 3;
+				p.x = (p.x + 2 * 3) & 0x3FF;
 			}
 		}
 	}
@@ -1317,44 +1377,40 @@ void DrawTriangle(const VertexData& v0, const VertexData& v1, const VertexData&
 	minY = std::max(minY, (int)TransformUnit::DrawingToScreen(scissorTL).y);
 	maxY = std::min(maxY, (int)TransformUnit::DrawingToScreen(scissorBR).y);
 
-	// 32 because we do two pixels at once, and we don't want overlap.
-	int rangeY = (maxY - minY) / 32 + 1;
-	int rangeX = (maxX - minX) / 32 + 1;
-	if (rangeY >= 12 && rangeX >= rangeY * 4) {
-		if (gstate.isModeClear()) {
-			auto bound = [&](int a, int b) -> void {
-				DrawTriangleSlice<true>(v0, v1, v2, minX, minY, maxX, maxY, false, a, b);
-			};
-			GlobalThreadPool::Loop(bound, 0, rangeX);
-		} else {
-			auto bound = [&](int a, int b) -> void {
-				DrawTriangleSlice<false>(v0, v1, v2, minX, minY, maxX, maxY, false, a, b);
-			};
-			GlobalThreadPool::Loop(bound, 0, rangeX);
-		}
-	} else if (rangeY >= 12 && rangeX >= 12) {
-		if (gstate.isModeClear()) {
-			auto bound = [&](int a, int b) -> void {
-				DrawTriangleSlice<true>(v0, v1, v2, minX, minY, maxX, maxY, true, a, b);
-			};
-			GlobalThreadPool::Loop(bound, 0, rangeY);
-		} else {
-			auto bound = [&](int a, int b) -> void {
-				DrawTriangleSlice<false>(v0, v1, v2, minX, minY, maxX, maxY, true, a, b);
-			};
-			GlobalThreadPool::Loop(bound, 0, rangeY);
-		}
+	BinCoords range{ minX, minY, maxX, maxY };
+	if (binner.IsEnabled()) {
+		binner.AddTriangle(v0, v1, v2, range);
+		return;
+	}
+
+	DrawTriangleRange(v0, v1, v2, range, range, Sampler::GetFuncs(), GetSingleFunc());
+}
+
+void DrawTriangleRange(const VertexData &v0, const VertexData &v1, const VertexData &v2, const BinCoords &range, const BinCoords &clip, const Sampler::Funcs &sampler, SingleFunc drawPixel) {
+	if (gstate.isModeClear()) {
+		DrawTriangleSlice<true>(v0, v1, v2, range, clip, sampler, drawPixel);
 	} else {
-		if (gstate.isModeClear()) {
-			DrawTriangleSlice<true>(v0, v1, v2, minX, minY, maxX, maxY, true, 0, rangeY);
-		} else {
-			DrawTriangleSlice<false>(v0, v1, v2, minX, minY, maxX, maxY, true, 0, rangeY);
-		}
+		DrawTriangleSlice<false>(v0, v1, v2, range, clip, sampler, drawPixel);
 	}
 }
 
+void FlushBins() {
+	binner.Flush();
+}
+
+void KickBins() {
+	binner.Kick();
+}
+
+bool HasPendingBins() {
+	return binner.HasPendingWork();
+}
+
 void DrawPoint(const VertexData &v0)
 {
+	// These draw directly, so anything binned must be drawn first.
+	binner.Flush();
+
 	ScreenCoords pos = v0.screenpos;
 	Vec4<int> prim_color = v0.color0;
 	Vec3<int> sec_color = v0.color1;
@@ -1431,6 +1487,8 @@ void DrawPoint(const VertexData &v0)
 
 void ClearRectangle(const VertexData &v0, const VertexData &v1)
 {
+	binner.Flush();
+
 	int minX = std::min(v0.screenpos.x, v1.screenpos.x) & ~0xF;
 	int minY = std::min(v0.screenpos.y, v1.screenpos.y) & ~0xF;
 	int maxX = (std::max(v0.screenpos.x, v1.screenpos.x) + 0xF) & ~0xF;
@@ -1559,6 +1617,8 @@ void ClearRectangle(const VertexData &v0, const VertexData &v1)
 
 void DrawLine(const VertexData &v0, const VertexData &v1)
 {
+	binner.Flush();
+
 	// TODO: Use a proper line drawing algorithm that handles fractional endpoints correctly.
 	Vec3<int> a(v0.screenpos.x, v0.screenpos.y, v0.screenpos.z);
 	Vec3<int> b(v1.screenpos.x, v1.screenpos.y, v0.screenpos.z);
@@ -1690,6 +1750,8 @@ void DrawLine(const VertexData &v0, const VertexData &v1)
 
 bool GetCurrentStencilbuffer(GPUDebugBuffer &buffer)
 {
+	binner.Flush();
+
 	int w = gstate.getRegionX2() - gstate.getRegionX1() + 1;
 	int h = gstate.getRegionY2() - gstate.getRegionY1() + 1;
 	buffer.Allocate(w, h, GPU_DBG_FORMAT_8BIT);
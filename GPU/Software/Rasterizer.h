@@ -18,23 +18,41 @@
 #pragma once
 
 #include "TransformUnit.h" // for DrawingCoords
+#include "GPU/Software/DrawPixel.h"
 
 struct GPUDebugBuffer;
 
+namespace Sampler {
+struct Funcs;
+}
+
 namespace Rasterizer {
 
+struct BinCoords;
+
 // Draws a triangle if its vertices are specified in counter-clockwise order
 void DrawTriangle(const VertexData& v0, const VertexData& v1, const VertexData& v2);
 void DrawPoint(const VertexData &v0);
 void DrawLine(const VertexData &v0, const VertexData &v1);
 void ClearRectangle(const VertexData &v0, const VertexData &v1);
 
+// Triangles may be queued for drawing on worker threads.  This must be called before changing
+// any state, or accessing the framebuffer.
+void FlushBins();
+// Starts drawing queued triangles without waiting, when the raster thread is enabled.
+void KickBins();
+bool HasPendingBins();
+// Used by BinManager to draw the part of a triangle within one tile.
+void DrawTriangleRange(const VertexData &v0, const VertexData &v1, const VertexData &v2, const BinCoords &range, const BinCoords &clip, const Sampler::Funcs &sampler, SingleFunc drawPixel);
+
 bool GetCurrentStencilbuffer(GPUDebugBuffer &buffer);
 bool GetCurrentTexture(GPUDebugBuffer &buffer, int level);
 
 // Shared functions with RasterizerRectangle.cpp
 Vec3<int> AlphaBlendingResult(const Vec4<int> &source, const Vec4<int> &dst);
-void DrawSinglePixelNonClear(const DrawingCoords &p, u16 z, u8 fog, const Vec4<int> &color_in);
+// Fallbacks for GetSingleFunc() when the state can't be jitted.
+void DrawSinglePixelInterp(int x, int y, int z, int fog, const Vec4<int> &color_in);
+void DrawSinglePixelClearInterp(int x, int y, int z, int fog, const Vec4<int> &color_in);
 Vec4<int> GetTextureFunctionOutput(const Vec4<int>& prim_color, const Vec4<int>& texcolor);
 
 }  // namespace Rasterizer
@@ -78,6 +78,8 @@ static inline Vec4<int> ModulateRGBA(const Vec4<int>& prim_color, const Vec4<int
 }
 
 void DrawSprite(const VertexData& v0, const VertexData& v1) {
+	FlushBins();
+
 	const u8 *texptr = nullptr;
 
 	GETextureFormat texfmt = gstate.getTextureFormat();
@@ -88,6 +90,7 @@ void DrawSprite(const VertexData& v0, const VertexData& v1) {
 
 	ScreenCoords pprime(v0.screenpos.x, v0.screenpos.y, 0);
 	Sampler::NearestFunc nearestFunc = Sampler::GetNearestFunc();  // Looks at gstate.
+	SingleFunc drawPixel = GetSingleFunc();
 
 	DrawingCoords pos0 = TransformUnit::ScreenToDrawing(v0.screenpos);
 	DrawingCoords pos1 = TransformUnit::ScreenToDrawing(v1.screenpos);
@@ -176,8 +179,7 @@ void DrawSprite(const VertexData& v0, const VertexData& v1) {
 					Vec4<int> prim_color = v0.color0;
 					Vec4<int> tex_color = Vec4<int>::FromRGBA(nearestFunc(s, t, texptr, texbufw, 0));
 					prim_color = GetTextureFunctionOutput(prim_color, tex_color);
-					DrawingCoords pos(x, y, z);
-					DrawSinglePixelNonClear(pos, (u16)z, 1.0f, prim_color);
+					drawPixel(x, y, z, 1, prim_color);
 					s += ds;
 				}
 				t += dt;
@@ -216,8 +218,7 @@ void DrawSprite(const VertexData& v0, const VertexData& v1) {
 			for (int y = pos0.y; y < pos1.y; y++) {
 				for (int x = pos0.x; x < pos1.x; x++) {
 					Vec4<int> prim_color = v0.color0;
-					DrawingCoords pos(x, y, z);
-					DrawSinglePixelNonClear(pos, (u16)z, fog, prim_color);
+					drawPixel(x, y, z, (u8)fog, prim_color);
 				}
 			}
 		}
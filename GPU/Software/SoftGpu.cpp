@@ -112,6 +112,7 @@ SoftGPU::SoftGPU(GraphicsContext *gfxCtx, Draw::DrawContext *draw)
 	displayStride_ = 512;
 	displayFormat_ = GE_FORMAT_8888;
 
+	Rasterizer::Init();
 	Sampler::Init();
 	drawEngine_ = new SoftwareDrawEngine();
 	drawEngineCommon_ = drawEngine_;
@@ -144,7 +145,9 @@ SoftGPU::~SoftGPU() {
 	samplerLinear->Release();
 	samplerLinear = nullptr;
 
+	Rasterizer::FlushBins();
 	Sampler::Shutdown();
+	Rasterizer::Shutdown();
 }
 
 void SoftGPU::SetDisplayFramebuffer(u32 framebuf, u32 stride, GEBufferFormat format) {
@@ -354,6 +357,8 @@ void SoftGPU::CopyToCurrentFboFromDisplayRam(int srcwidth, int srcheight) {
 }
 
 void SoftGPU::CopyDisplayToOutput() {
+	Rasterizer::FlushBins();
+
 	// The display always shows 480x272.
 	CopyToCurrentFboFromDisplayRam(FB_WIDTH, FB_HEIGHT);
 	framebufferDirty_ = false;
@@ -368,6 +373,48 @@ void SoftGPU::CopyDisplayToOutput() {
 	}
 }
 
+// Binned triangles are drawn later, on other threads, using the current gstate.
+static bool NeedsBinFlush(u32 cmd, u32 diff) {
+	switch (cmd) {
+	case GE_CMD_NOP:
+	case GE_CMD_BASE:
+	case GE_CMD_VADDR:
+	case GE_CMD_IADDR:
+	case GE_CMD_PRIM:
+	case GE_CMD_BEZIER:
+	case GE_CMD_SPLINE:
+	case GE_CMD_OFFSETADDR:
+	case GE_CMD_ORIGIN:
+	case GE_CMD_JUMP:
+	case GE_CMD_CALL:
+	case GE_CMD_RET:
+	// Matrices only affect transform, which isn't deferred.
+	case GE_CMD_WORLDMATRIXNUMBER:
+	case GE_CMD_WORLDMATRIXDATA:
+	case GE_CMD_VIEWMATRIXNUMBER:
+	case GE_CMD_VIEWMATRIXDATA:
+	case GE_CMD_PROJMATRIXNUMBER:
+	case GE_CMD_PROJMATRIXDATA:
+	case GE_CMD_TGENMATRIXNUMBER:
+	case GE_CMD_TGENMATRIXDATA:
+	case GE_CMD_BONEMATRIXNUMBER:
+	case GE_CMD_BONEMATRIXDATA:
+		return false;
+
+	// These act even when unchanged.
+	case GE_CMD_LOADCLUT:
+	case GE_CMD_TRANSFERSTART:
+	case GE_CMD_BJUMP:
+	case GE_CMD_SIGNAL:
+	case GE_CMD_FINISH:
+	case GE_CMD_END:
+		return true;
+
+	default:
+		return diff != 0;
+	}
+}
+
 void SoftGPU::FastRunLoop(DisplayList &list) {
 	PROFILE_THIS_SCOPE("soft_runloop");
 	for (; downcount > 0; --downcount) {
@@ -375,6 +422,9 @@ void SoftGPU::FastRunLoop(DisplayList &list) {
 		u32 cmd = op >> 24;
 
 		u32 diff = op ^ gstate.cmdmem[cmd];
+		if (NeedsBinFlush(cmd, diff) && Rasterizer::HasPendingBins()) {
+			Rasterizer::FlushBins();
+		}
 		gstate.cmdmem[cmd] = op;
 		ExecuteOp(op, diff);
 
@@ -382,6 +432,66 @@ void SoftGPU::FastRunLoop(DisplayList &list) {
 	}
 }
 
+void SoftGPU::PreExecuteOp(u32 op, u32 diff) {
+	if (NeedsBinFlush(op >> 24, diff) && Rasterizer::HasPendingBins()) {
+		Rasterizer::FlushBins();
+	}
+}
+
+void SoftGPU::FinishDeferred() {
+	// Keep drawing while the CPU runs.  Anything that could see the result waits below.
+	Rasterizer::KickBins();
+}
+
+// The raster thread may still be drawing after the list ends, so these sync with it first.
+void SoftGPU::Reinitialize() {
+	Rasterizer::FlushBins();
+	GPUCommon::Reinitialize();
+}
+
+void SoftGPU::BeginHostFrame() {
+	// This may reapply all state.
+	Rasterizer::FlushBins();
+	GPUCommon::BeginHostFrame();
+}
+
+void SoftGPU::InterruptStart(int listid) {
+	// Callbacks may look at the framebuffer.
+	Rasterizer::FlushBins();
+	GPUCommon::InterruptStart(listid);
+}
+
+void SoftGPU::InterruptEnd(int listid) {
+	// This may restore a saved context.
+	Rasterizer::FlushBins();
+	GPUCommon::InterruptEnd(listid);
+}
+
+int SoftGPU::ListSync(int listid, int mode) {
+	Rasterizer::FlushBins();
+	return GPUCommon::ListSync(listid, mode);
+}
+
+u32 SoftGPU::DrawSync(int mode) {
+	Rasterizer::FlushBins();
+	return GPUCommon::DrawSync(mode);
+}
+
+void SoftGPU::RestoreContext(u32_le *ptr) {
+	// The raster thread reads gstate while it draws.
+	Rasterizer::FlushBins();
+	GPUCommon::RestoreContext(ptr);
+}
+
+void SoftGPU::FinishPendingDraws() {
+	Rasterizer::FlushBins();
+}
+
+void SoftGPU::DoState(PointerWrap &p) {
+	Rasterizer::FlushBins();
+	GPUCommon::DoState(p);
+}
+
 void SoftGPU::ExecuteOp(u32 op, u32 diff) {
 	u32 cmd = op >> 24;
 	u32 data = op & 0xFFFFFF;
@@ -941,9 +1051,40 @@ void SoftGPU::GetStats(char *buffer, size_t bufsize) {
 	snprintf(buffer, bufsize, "SoftGPU: (N/A)");
 }
 
+static bool RangesOverlap(u32 addr1, u32 size1, u32 addr2, u32 size2) {
+	// VRAM is mirrored, compare without the uncached and mirror bits.
+	addr1 &= 0x041FFFFF;
+	addr2 &= 0x041FFFFF;
+	return addr1 < addr2 + size2 && addr2 < addr1 + size1;
+}
+
+// Whether anything the queued triangles read or write overlaps the range.
+static bool PendingDrawsTouch(u32 addr, u32 size) {
+	const u32 h = gstate.getRegionY2() + 1;
+	const u32 fbBpp = gstate.FrameBufFormat() == GE_FORMAT_8888 ? 4 : 2;
+	if (RangesOverlap(addr, size, gstate.getFrameBufAddress(), gstate.FrameBufStride() * fbBpp * h))
+		return true;
+	if (RangesOverlap(addr, size, gstate.getDepthBufAddress(), gstate.DepthBufStride() * 2 * h))
+		return true;
+
+	if (gstate.isTextureMapEnabled()) {
+		const int maxLevel = gstate.isMipmapEnabled() ? gstate.getTextureMaxLevel() : 0;
+		const u32 bpp = textureBitsPerPixel[gstate.getTextureFormat()];
+		for (int level = 0; level <= maxLevel; ++level) {
+			u32 texBytes = (bpp * GetTextureBufw(level, gstate.getTextureAddress(level), gstate.getTextureFormat()) * gstate.getTextureHeight(level)) / 8;
+			if (RangesOverlap(addr, size, gstate.getTextureAddress(level), texBytes))
+				return true;
+		}
+	}
+	return false;
+}
+
 void SoftGPU::InvalidateCache(u32 addr, int size, GPUInvalidationType type)
 {
-	// Nothing to invalidate.
+	// Nothing to invalidate, but the CPU is about to touch memory the raster thread may use.
+	if (Rasterizer::HasPendingBins() && (size < 0 || PendingDrawsTouch(addr, size))) {
+		Rasterizer::FlushBins();
+	}
 }
 
 void SoftGPU::NotifyVideoUpload(u32 addr, int size, int width, int format)
@@ -953,7 +1094,10 @@ void SoftGPU::NotifyVideoUpload(u32 addr, int size, int width, int format)
 
 bool SoftGPU::PerformMemoryCopy(u32 dest, u32 src, int size)
 {
-	// Nothing to update.
+	// Queued draws may still be writing to the source, too.
+	if (Rasterizer::HasPendingBins() && PendingDrawsTouch(src, size)) {
+		Rasterizer::FlushBins();
+	}
 	InvalidateCache(dest, size, GPU_INVALIDATE_HINT);
 	GPURecord::NotifyMemcpy(dest, src, size);
 	// Let's just be safe.
@@ -1001,6 +1145,8 @@ bool SoftGPU::FramebufferDirty() {
 }
 
 bool SoftGPU::GetCurrentFramebuffer(GPUDebugBuffer &buffer, GPUDebugFramebufferType type, int maxRes) {
+	Rasterizer::FlushBins();
+
 	int x1 = gstate.getRegionX1();
 	int y1 = gstate.getRegionY1();
 	int x2 = gstate.getRegionX2() + 1;
@@ -1037,6 +1183,8 @@ bool SoftGPU::GetOutputFramebuffer(GPUDebugBuffer &buffer) {
 
 bool SoftGPU::GetCurrentDepthbuffer(GPUDebugBuffer &buffer)
 {
+	Rasterizer::FlushBins();
+
 	const int w = gstate.getRegionX2() - gstate.getRegionX1() + 1;
 	const int h = gstate.getRegionY2() - gstate.getRegionY1() + 1;
 	buffer.Allocate(w, h, GPU_DBG_FORMAT_16BIT);
@@ -1083,5 +1231,9 @@ bool SoftGPU::DescribeCodePtr(const u8 *ptr, std::string &name) {
 		name = "SamplerJit:" + subname;
 		return true;
 	}
+	if (Rasterizer::DescribeCodePtr(ptr, subname)) {
+		name = "PixelJit:" + subname;
+		return true;
+	}
 	return false;
 }
@@ -59,6 +59,16 @@ class SoftGPU : public GPUCommon {
 
 	void CheckGPUFeatures() override {}
 	void InitClear() override {}
+	void Reinitialize() override;
+	void BeginHostFrame() override;
+	void InterruptStart(int listid) override;
+	void InterruptEnd(int listid) override;
+	int ListSync(int listid, int mode) override;
+	u32 DrawSync(int mode) override;
+	void DoState(PointerWrap &p) override;
+	void RestoreContext(u32_le *ptr) override;
+	void FinishPendingDraws() override;
+	void PreExecuteOp(u32 op, u32 diff) override;
 	void ExecuteOp(u32 op, u32 diff) override;
 
 	void SetDisplayFramebuffer(u32 framebuf, u32 stride, GEBufferFormat format) override;
@@ -100,6 +110,7 @@ class SoftGPU : public GPUCommon {
 
 protected:
 	void FastRunLoop(DisplayList &list) override;
+	void FinishDeferred() override;
 	void CopyToCurrentFboFromDisplayRam(int srcwidth, int srcheight);
 	void ConvertTextureDescFrom16(Draw::TextureDesc &desc, int srcwidth, int srcheight);
 
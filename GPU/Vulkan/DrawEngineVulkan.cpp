@@ -337,7 +337,7 @@ void DrawEngineVulkan::EndFrame() {
 	vertexCache_->End();
 }
 
-void DrawEngineVulkan::DecodeVertsToPushBuffer(VulkanPushBuffer *push, uint32_t *bindOffset, VkBuffer *vkbuf) {
+void DrawEngineVulkan::DecodeVertsToPushBuffer(VulkanPushBuffer *push, uint32_t *bindOffset, VkBuffer *vkbuf, VulkanPushBuffer *indexPush, uint32_t *indexBindOffset, VkBuffer *indexVkbuf) {
 	u8 *dest = decoded;
 
 	// Figure out how much pushbuffer space we need to allocate.
@@ -345,6 +345,12 @@ void DrawEngineVulkan::DecodeVertsToPushBuffer(VulkanPushBuffer *push, uint32_t
 		int vertsToDecode = ComputeNumVertsToDecode();
 		dest = (u8 *)push->Push(vertsToDecode * dec_->GetDecVtxFmt().stride, bindOffset, vkbuf);
 	}
+	// Same for the indices, unless some were already generated into decIndex (software skinning.)
+	// The caller rewinds the pushbuffer once it knows how many were actually used.
+	if (indexPush && decodeCounter_ == 0) {
+		u16 *inds = (u16 *)indexPush->Push(sizeof(uint16_t) * ComputeMaxIndicesToGenerate(), indexBindOffset, indexVkbuf);
+		indexGen.Setup(inds);
+	}
 	DecodeVerts(dest);
 }
 
@@ -650,7 +656,7 @@ void DrawEngineVulkan::DoFlush() {
 				vai->minihash = ComputeMiniHash();
 				vai->status = VertexArrayInfoVulkan::VAI_HASHING;
 				vai->drawsUntilNextFullHash = 0;
-				DecodeVertsToPushBuffer(frame->pushVertex, &vbOffset, &vbuf);  // writes to indexGen
+				DecodeVertsToPushBuffer(frame->pushVertex, &vbOffset, &vbuf, frame->pushIndex, &ibOffset, &ibuf);  // writes to indexGen
 				vai->numVerts = indexGen.VertexCount();
 				vai->prim = indexGen.Prim();
 				vai->maxIndex = indexGen.MaxIndex();
@@ -676,7 +682,7 @@ void DrawEngineVulkan::DoFlush() {
 					}
 					if (newMiniHash != vai->minihash || newHash != vai->hash) {
 						MarkUnreliable(vai);
-						DecodeVertsToPushBuffer(frame->pushVertex, &vbOffset, &vbuf);
+						DecodeVertsToPushBuffer(frame->pushVertex, &vbOffset, &vbuf, frame->pushIndex, &ibOffset, &ibuf);
 						goto rotateVBO;
 					}
 					if (vai->numVerts > 64) {
@@ -695,7 +701,7 @@ void DrawEngineVulkan::DoFlush() {
 					u32 newMiniHash = ComputeMiniHash();
 					if (newMiniHash != vai->minihash) {
 						MarkUnreliable(vai);
-						DecodeVertsToPushBuffer(frame->pushVertex, &vbOffset, &vbuf);
+						DecodeVertsToPushBuffer(frame->pushVertex, &vbOffset, &vbuf, frame->pushIndex, &ibOffset, &ibuf);
 						goto rotateVBO;
 					}
 				}
@@ -763,7 +769,7 @@ void DrawEngineVulkan::DoFlush() {
 				if (vai->lastFrame != gpuStats.numFlips) {
 					vai->numFrames++;
 				}
-				DecodeVertsToPushBuffer(frame->pushVertex, &vbOffset, &vbuf);
+				DecodeVertsToPushBuffer(frame->pushVertex, &vbOffset, &vbuf, frame->pushIndex, &ibOffset, &ibuf);
 				goto rotateVBO;
 			}
 			default:
@@ -776,8 +782,8 @@ void DrawEngineVulkan::DoFlush() {
 				u8 *dest = (u8 *)frame->pushVertex->Push(size, &vbOffset, &vbuf);
 				memcpy(dest, decoded, size);
 			} else {
-				// Decode directly into the pushbuffer
-				DecodeVertsToPushBuffer(frame->pushVertex, &vbOffset, &vbuf);
+				// Decode directly into the pushbuffer, indices too.
+				DecodeVertsToPushBuffer(frame->pushVertex, &vbOffset, &vbuf, frame->pushIndex, &ibOffset, &ibuf);
 			}
 
 	rotateVBO:
@@ -787,6 +793,10 @@ void DrawEngineVulkan::DoFlush() {
 			if (!useElements && indexGen.PureCount()) {
 				vertexCount = indexGen.PureCount();
 			}
+			if (ibuf) {
+				// The indices went straight into the pushbuffer, give back what the worst case didn't need.
+				frame->pushIndex->Rewind(ibOffset + (useElements ? sizeof(uint16_t) * indexGen.VertexCount() : 0));
+			}
 			prim = indexGen.Prim();
 		}
 
@@ -816,10 +826,10 @@ void DrawEngineVulkan::DoFlush() {
 			}
 			Draw::NativeObject object = g_Config.iRenderingMode != FB_NON_BUFFERED_MODE ? Draw::NativeObject::FRAMEBUFFER_RENDERPASS : Draw::NativeObject::BACKBUFFER_RENDERPASS;
 			VkRenderPass renderPass = (VkRenderPass)draw_->GetNativeObject(object);
-			VulkanPipeline *pipeline = pipelineManager_->GetOrCreatePipeline(pipelineLayout_, renderPass, pipelineKey_, &dec_->decFmt, vshader, fshader, true);
+			VulkanPipeline *pipeline = pipelineManager_->GetOrCreatePipeline(pipelineLayout_, renderPass, pipelineKey_, &dec_->decFmt, vshader, fshader, true, g_Config.bAsyncShaderCompile);
 			if (!pipeline || !pipeline->pipeline) {
-				// Already logged, let's bail out.
-				return;
+				// Already logged, or still compiling.  Either way, skip the draw.
+				goto skipDraw;
 			}
 			BindShaderBlendTex();  // This might cause copies so important to do before BindPipeline.
 			renderManager->BindPipeline(pipeline->pipeline);
@@ -928,10 +938,10 @@ void DrawEngineVulkan::DoFlush() {
 				}
 				Draw::NativeObject object = g_Config.iRenderingMode != FB_NON_BUFFERED_MODE ? Draw::NativeObject::FRAMEBUFFER_RENDERPASS : Draw::NativeObject::BACKBUFFER_RENDERPASS;
 				VkRenderPass renderPass = (VkRenderPass)draw_->GetNativeObject(object);
-				VulkanPipeline *pipeline = pipelineManager_->GetOrCreatePipeline(pipelineLayout_, renderPass, pipelineKey_, &dec_->decFmt, vshader, fshader, false);
+				VulkanPipeline *pipeline = pipelineManager_->GetOrCreatePipeline(pipelineLayout_, renderPass, pipelineKey_, &dec_->decFmt, vshader, fshader, false, g_Config.bAsyncShaderCompile);
 				if (!pipeline || !pipeline->pipeline) {
-					// Already logged, let's bail out.
-					return;
+					// Already logged, or still compiling.  Either way, skip the draw.
+					goto skipDraw;
 				}
 				BindShaderBlendTex();  // This might cause copies so super important to do before BindPipeline.
 				renderManager->BindPipeline(pipeline->pipeline);
@@ -994,10 +1004,12 @@ void DrawEngineVulkan::DoFlush() {
 		}
 	}
 
+skipDraw:
 	gpuStats.numDrawCalls += numDrawCalls;
 	gpuStats.numVertsSubmitted += vertexCountInDrawCalls_;
 
-	indexGen.Reset();
+	// Point the index generator back at decIndex, in case it was writing into the pushbuffer.
+	indexGen.Setup(decIndex);
 	decodedVerts_ = 0;
 	numDrawCalls = 0;
 	vertexCountInDrawCalls_ = 0;
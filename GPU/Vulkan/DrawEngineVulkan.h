@@ -215,7 +215,8 @@ class DrawEngineVulkan : public DrawEngineCommon {
 	void InitDeviceObjects();
 	void DestroyDeviceObjects();
 
-	void DecodeVertsToPushBuffer(VulkanPushBuffer *push, uint32_t *bindOffset, VkBuffer *vkbuf);
+	// If indexPush is given, IndexGenerator also writes straight into it, and *indexVkbuf is set.
+	void DecodeVertsToPushBuffer(VulkanPushBuffer *push, uint32_t *bindOffset, VkBuffer *vkbuf, VulkanPushBuffer *indexPush = nullptr, uint32_t *indexBindOffset = nullptr, VkBuffer *indexVkbuf = nullptr);
 	VkResult RecreateDescriptorPool(FrameData &frame, int newSize);
 
 	void DoFlush();
@@ -64,6 +64,7 @@ bool GenerateVulkanGLSLFragmentShader(const FShaderID &id, char *buffer, uint32_
 	bool doTextureAlpha = id.Bit(FS_BIT_TEXALPHA);
 	bool doFlatShading = id.Bit(FS_BIT_FLATSHADE);
 	bool shaderDepal = id.Bit(FS_BIT_SHADER_DEPAL);
+	bool ubershader = id.Bit(FS_BIT_UBERSHADER);
 
 	GEComparison alphaTestFunc = (GEComparison)id.Bits(FS_BIT_ALPHA_TEST_FUNC, 3);
 	GEComparison colorTestFunc = (GEComparison)id.Bits(FS_BIT_COLOR_TEST_FUNC, 2);
@@ -83,7 +84,7 @@ bool GenerateVulkanGLSLFragmentShader(const FShaderID &id, char *buffer, uint32_
 	bool isModeClear = id.Bit(FS_BIT_CLEARMODE);
 
 	const char *shading = doFlatShading ? "flat" : "";
-	bool earlyFragmentTests = ((!enableAlphaTest && !enableColorTest) || testForceToZero) && !gstate_c.Supports(GPU_ROUND_FRAGMENT_DEPTH_TO_16BIT);
+	bool earlyFragmentTests = ((!enableAlphaTest && !enableColorTest) || testForceToZero) && !ubershader && !gstate_c.Supports(GPU_ROUND_FRAGMENT_DEPTH_TO_16BIT);
 	bool useAdrenoBugWorkaround = id.Bit(FS_BIT_NO_DEPTH_CANNOT_DISCARD_STENCIL);
 
 	if (earlyFragmentTests) {
@@ -117,12 +118,27 @@ bool GenerateVulkanGLSLFragmentShader(const FShaderID &id, char *buffer, uint32_
 		WRITE(p, "layout (location = 0) in vec3 v_texcoord;\n");
 	}
 
-	if (enableAlphaTest && !alphaTestAgainstZero) {
+	if ((enableAlphaTest && !alphaTestAgainstZero) || ubershader) {
 		WRITE(p, "int roundAndScaleTo255i(in float x) { return int(floor(x * 255.0 + 0.5)); }\n");
 	}
-	if (enableColorTest && !colorTestAgainstZero) {
+	if ((enableColorTest && !colorTestAgainstZero) || ubershader) {
 		WRITE(p, "ivec3 roundAndScaleTo255iv(in vec3 x) { return ivec3(floor(x * 255.0 + 0.5)); }\n");
 	}
+	if (ubershader) {
+		// Whether a GEComparison passes.
+		WRITE(p, "bool uberCompare(uint func, int a, int b) {\n");
+		WRITE(p, "  switch (func) {\n");
+		WRITE(p, "  case 0u: return false;\n");
+		WRITE(p, "  case 1u: return true;\n");
+		WRITE(p, "  case 2u: return a == b;\n");
+		WRITE(p, "  case 3u: return a != b;\n");
+		WRITE(p, "  case 4u: return a < b;\n");
+		WRITE(p, "  case 5u: return a <= b;\n");
+		WRITE(p, "  case 6u: return a > b;\n");
+		WRITE(p, "  default: return a >= b;\n");
+		WRITE(p, "  }\n");
+		WRITE(p, "}\n");
+	}
 
 	WRITE(p, "layout (location = 0, index = 0) out vec4 fragColor0;\n");
 	if (stencilToAlpha == REPLACE_ALPHA_DUALSOURCE) {
@@ -283,10 +299,33 @@ bool GenerateVulkanGLSLFragmentShader(const FShaderID &id, char *buffer, uint32_
 				WRITE(p, "  }\n");
 			}
 
-			if (texFunc != GE_TEXFUNC_REPLACE || !doTextureAlpha)
+			if (ubershader) {
 				WRITE(p, "  vec4 p = v_color0;\n");
+				WRITE(p, "  uint texFunc = base.fsUberState & %uu;\n", (uint32_t)FS_UBER_TEXFUNC_MASK);
+				WRITE(p, "  bool texAlpha = (base.fsUberState & %uu) != 0u;\n", (uint32_t)FS_UBER_TEXALPHA);
+				WRITE(p, "  vec4 v;\n");
+				WRITE(p, "  if (texFunc == %du) {\n", GE_TEXFUNC_MODULATE);
+				WRITE(p, "    v = vec4(p.rgb * t.rgb, texAlpha ? p.a * t.a : p.a);\n");
+				WRITE(p, "  } else if (texFunc == %du) {\n", GE_TEXFUNC_DECAL);
+				WRITE(p, "    v = vec4(texAlpha ? mix(p.rgb, t.rgb, t.a) : t.rgb, p.a);\n");
+				WRITE(p, "  } else if (texFunc == %du) {\n", GE_TEXFUNC_BLEND);
+				WRITE(p, "    v = vec4(mix(p.rgb, base.texenv.rgb, t.rgb), texAlpha ? p.a * t.a : p.a);\n");
+				WRITE(p, "  } else if (texFunc == %du) {\n", GE_TEXFUNC_REPLACE);
+				WRITE(p, "    v = vec4(t.rgb, texAlpha ? t.a : p.a);\n");
+				WRITE(p, "  } else {\n");
+				WRITE(p, "    v = vec4(p.rgb + t.rgb, texAlpha ? p.a * t.a : p.a);\n");
+				WRITE(p, "  }\n");
+				if (lmode)
+					WRITE(p, "  v = v%s;\n", secondary);
+				WRITE(p, "  if ((base.fsUberState & %uu) != 0u)\n", (uint32_t)FS_UBER_COLOR_DOUBLE);
+				WRITE(p, "    v.rgb = clamp(v.rgb * 2.0, 0.0, 1.0);\n");
+			} else if (texFunc != GE_TEXFUNC_REPLACE || !doTextureAlpha) {
+				WRITE(p, "  vec4 p = v_color0;\n");
+			}
 
-			if (doTextureAlpha) { // texfmt == RGBA
+			if (ubershader) {
+				// Already done above.
+			} else if (doTextureAlpha) { // texfmt == RGBA
 				switch (texFunc) {
 				case GE_TEXFUNC_MODULATE:
 					WRITE(p, "  vec4 v = p * t%s;\n", secondary);
@@ -380,6 +419,13 @@ bool GenerateVulkanGLSLFragmentShader(const FShaderID &id, char *buffer, uint32_
 			}
 		}
 
+		if (ubershader) {
+			WRITE(p, "  if ((base.fsUberState & %uu) != 0u) {\n", (uint32_t)FS_UBER_ALPHA_TEST);
+			WRITE(p, "    uint alphaFunc = (base.fsUberState >> %d) & 7u;\n", (int)FS_UBER_ALPHA_TEST_FUNC_SHIFT);
+			WRITE(p, "    if (!uberCompare(alphaFunc, roundAndScaleTo255i(v.a) & base.alphacolormask.a, base.alphacolorref.a)) discard;\n");
+			WRITE(p, "  }\n");
+		}
+
 		if (enableFog) {
 			WRITE(p, "  float fogCoef = clamp(v_fogdepth, 0.0, 1.0);\n");
 			WRITE(p, "  v = mix(vec4(base.fogcolor, v.a), v, fogCoef);\n");
@@ -412,6 +458,15 @@ bool GenerateVulkanGLSLFragmentShader(const FShaderID &id, char *buffer, uint32_
 			}
 		}
 
+		if (ubershader) {
+			WRITE(p, "  if ((base.fsUberState & %uu) != 0u) {\n", (uint32_t)FS_UBER_COLOR_TEST);
+			// The color test only has NEVER, ALWAYS, EQUAL and NOTEQUAL, so compare a 0/1 mismatch against 0.
+			WRITE(p, "    uint colorFunc = (base.fsUberState >> %d) & 3u;\n", (int)FS_UBER_COLOR_TEST_FUNC_SHIFT);
+			WRITE(p, "    bool colorEqual = (roundAndScaleTo255iv(v.rgb) & base.alphacolormask.rgb) == (base.alphacolorref.rgb & base.alphacolormask.rgb);\n");
+			WRITE(p, "    if (!uberCompare(colorFunc, colorEqual ? 0 : 1, 0)) discard;\n");
+			WRITE(p, "  }\n");
+		}
+
 		if (replaceBlend == REPLACE_BLEND_2X_SRC) {
 			WRITE(p, "  v.rgb = v.rgb * 2.0;\n");
 		}
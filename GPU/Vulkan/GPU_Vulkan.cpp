@@ -137,8 +137,10 @@ void GPU_Vulkan::LoadCache(std::string filename) {
 	// it can just memcpy the finished shader binaries out of the pipeline cache file.
 	bool result = shaderManagerVulkan_->LoadCache(f);
 	if (result) {
-		// WARNING: See comment in LoadCache if you are tempted to flip the second parameter to true.
-		result = pipelineManager_->LoadCache(f, false, shaderManagerVulkan_, draw_, drawEngine_.GetPipelineLayout());
+		result = drawEngine_.LoadVertexDecoderCache(f);
+	}
+	if (result) {
+		result = pipelineManager_->LoadCache(f, true, shaderManagerVulkan_, draw_, drawEngine_.GetPipelineLayout());
 	}
 	fclose(f);
 	if (!result) {
@@ -161,8 +163,8 @@ void GPU_Vulkan::SaveCache(std::string filename) {
 	if (!f)
 		return;
 	shaderManagerVulkan_->SaveCache(f);
-	// WARNING: See comment in LoadCache if you are tempted to flip the second parameter to true.
-	pipelineManager_->SaveCache(f, false, shaderManagerVulkan_, draw_);
+	drawEngine_.SaveVertexDecoderCache(f);
+	pipelineManager_->SaveCache(f, true, shaderManagerVulkan_, draw_);
 	INFO_LOG(G3D, "Saved Vulkan pipeline cache");
 	fclose(f);
 }
@@ -567,6 +569,7 @@ void GPU_Vulkan::GetStats(char *buffer, size_t bufsize) {
 		"Textures active: %i, decoded: %i  invalidated: %i\n"
 		"Readbacks: %d, uploads: %d\n"
 		"Vertex, Fragment, Pipelines loaded: %i, %i, %i\n"
+		"Pipelines compiling: %i, draws skipped: %i\n"
 		"Pushbuffer space used: UBO %d, Vtx %d, Idx %d\n"
 		"%s\n",
 		gpuStats.msProcessingDisplayLists * 1000.0f,
@@ -590,6 +593,8 @@ void GPU_Vulkan::GetStats(char *buffer, size_t bufsize) {
 		shaderManagerVulkan_->GetNumVertexShaders(),
 		shaderManagerVulkan_->GetNumFragmentShaders(),
 		pipelineManager_->GetNumPipelines(),
+		pipelineManager_->GetNumPendingPipelines(),
+		gpuStats.numPendingPipelineDraws,
 		drawStats.pushUBOSpaceUsed,
 		drawStats.pushVertexSpaceUsed,
 		drawStats.pushIndexSpaceUsed,
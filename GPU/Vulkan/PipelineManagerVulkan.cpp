@@ -3,24 +3,35 @@
 #include <set>
 
 #include "profiler/profiler.h"
+#include "thread/threadutil.h"
 
 #include "Common/Log.h"
 #include "Common/StringUtils.h"
 #include "Common/Vulkan/VulkanContext.h"
+#include "GPU/GPU.h"
 #include "GPU/Vulkan/VulkanUtil.h"
 #include "GPU/Vulkan/PipelineManagerVulkan.h"
 #include "GPU/Vulkan/ShaderManagerVulkan.h"
 #include "GPU/Common/DrawEngineCommon.h"
+#include "ext/xxhash.h"
 #include "ext/native/thin3d/thin3d.h"
 #include "ext/native/thin3d/VulkanRenderManager.h"
 #include "ext/native/thin3d/VulkanQueueRunner.h"
 
-PipelineManagerVulkan::PipelineManagerVulkan(VulkanContext *vulkan) : vulkan_(vulkan), pipelines_(256) {
+PipelineManagerVulkan::PipelineManagerVulkan(VulkanContext *vulkan) : vulkan_(vulkan), pipelines_(256), hasCompiled_(false) {
 	// The pipeline cache is created on demand (or explicitly through Load).
 }
 
 PipelineManagerVulkan::~PipelineManagerVulkan() {
 	Clear();
+	if (compileThread_.joinable()) {
+		{
+			std::lock_guard<std::mutex> guard(compileMutex_);
+			compileExit_ = true;
+		}
+		compileWake_.notify_one();
+		compileThread_.join();
+	}
 	if (pipelineCache_ != VK_NULL_HANDLE)
 		vulkan_->Delete().QueueDeletePipelineCache(pipelineCache_);
 }
@@ -29,6 +40,7 @@ void PipelineManagerVulkan::Clear() {
 	// This should kill off all the shaders at once.
 	// This could also be an opportunity to store the whole cache to disk. Will need to also
 	// store the keys.
+	WaitForPendingPipelines();
 
 	pipelines_.Iterate([&](const VulkanPipelineKey &key, VulkanPipeline *value) {
 		if (value->pipeline)
@@ -327,7 +339,7 @@ static VulkanPipeline *CreateVulkanPipeline(VkDevice device, VkPipelineCache pip
 	return vulkanPipeline;
 }
 
-VulkanPipeline *PipelineManagerVulkan::GetOrCreatePipeline(VkPipelineLayout layout, VkRenderPass renderPass, const VulkanPipelineRasterStateKey &rasterKey, const DecVtxFormat *decFmt, VulkanVertexShader *vs, VulkanFragmentShader *fs, bool useHwTransform) {
+VulkanPipeline *PipelineManagerVulkan::GetOrCreatePipeline(VkPipelineLayout layout, VkRenderPass renderPass, const VulkanPipelineRasterStateKey &rasterKey, const DecVtxFormat *decFmt, VulkanVertexShader *vs, VulkanFragmentShader *fs, bool useHwTransform, bool async) {
 	if (!pipelineCache_) {
 		VkPipelineCacheCreateInfo pc{ VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO };
 		VkResult res = vkCreatePipelineCache(vulkan_->GetDevice(), &pc, nullptr, &pipelineCache_);
@@ -344,9 +356,38 @@ VulkanPipeline *PipelineManagerVulkan::GetOrCreatePipeline(VkPipelineLayout layo
 	key.fShader = fs->GetModule();
 	key.vtxFmtId = useHwTransform ? decFmt->id : 0;
 
+	ProcessFinishedPipelines();
 	auto iter = pipelines_.Get(key);
-	if (iter)
+	if (iter) {
+		if (iter->IsPending()) {
+			gpuStats.numPendingPipelineDraws++;
+			return nullptr;
+		}
 		return iter;
+	}
+
+	if (async) {
+		VulkanPipeline *placeholder = new VulkanPipeline();
+		placeholder->pipeline = VK_NULL_HANDLE;
+		placeholder->flags = PIPELINE_FLAG_PENDING;
+		pipelines_.Insert(key, placeholder);
+
+		PipelineJob job{};
+		job.target = placeholder;
+		job.layout = layout;
+		job.renderPass = renderPass;
+		job.rasterKey = rasterKey;
+		if (useHwTransform)
+			job.decFmt = *decFmt;
+		job.vs = vs;
+		job.fs = fs;
+		job.useHwTransform = useHwTransform;
+		job.lineWidth = lineWidth_;
+		QueuePipeline(job);
+
+		gpuStats.numPendingPipelineDraws++;
+		return nullptr;
+	}
 
 	VulkanPipeline *pipeline = CreateVulkanPipeline(
 		vulkan_->GetDevice(), pipelineCache_, layout, renderPass, 
@@ -361,6 +402,78 @@ VulkanPipeline *PipelineManagerVulkan::GetOrCreatePipeline(VkPipelineLayout layo
 	}
 }
 
+void PipelineManagerVulkan::QueuePipeline(const PipelineJob &job) {
+	if (!compileThread_.joinable()) {
+		compileThread_ = std::thread([this] { CompileThread(); });
+	}
+
+	{
+		std::lock_guard<std::mutex> guard(compileMutex_);
+		compileQueue_.push_back(job);
+	}
+	numPending_++;
+	compileWake_.notify_one();
+}
+
+void PipelineManagerVulkan::ProcessFinishedPipelines() {
+	if (!hasCompiled_)
+		return;
+
+	std::vector<PipelineJob> finished;
+	{
+		std::lock_guard<std::mutex> guard(compileMutex_);
+		finished.swap(compiled_);
+		hasCompiled_ = false;
+	}
+	// Only the emu thread touches the pipelines in the map, so fill them in here.
+	for (const PipelineJob &job : finished) {
+		job.target->pipeline = job.result->pipeline;
+		job.target->flags = job.result->flags;
+		delete job.result;
+		numPending_--;
+	}
+}
+
+void PipelineManagerVulkan::WaitForPendingPipelines() {
+	if (numPending_ == 0)
+		return;
+
+	{
+		std::unique_lock<std::mutex> guard(compileMutex_);
+		while (!compileQueue_.empty() || compiling_)
+			compileDone_.wait(guard);
+	}
+	ProcessFinishedPipelines();
+}
+
+void PipelineManagerVulkan::CompileThread() {
+	setCurrentThreadName("PipelineCompile");
+
+	std::unique_lock<std::mutex> guard(compileMutex_);
+	while (!compileExit_) {
+		if (compileQueue_.empty()) {
+			compileWake_.wait(guard);
+			continue;
+		}
+
+		PipelineJob job = compileQueue_.front();
+		compileQueue_.pop_front();
+		compiling_ = true;
+		guard.unlock();
+
+		// vkCreateGraphicsPipelines and the pipeline cache are safe to use from any thread.
+		job.result = CreateVulkanPipeline(
+			vulkan_->GetDevice(), pipelineCache_, job.layout, job.renderPass,
+			job.rasterKey, &job.decFmt, job.vs, job.fs, job.useHwTransform, job.lineWidth);
+
+		guard.lock();
+		compiled_.push_back(job);
+		hasCompiled_ = true;
+		compiling_ = false;
+		compileDone_.notify_all();
+	}
+}
+
 std::vector<std::string> PipelineManagerVulkan::DebugGetObjectIDs(DebugShaderType type) {
 	std::vector<std::string> ids;
 	switch (type) {
@@ -546,6 +659,8 @@ void PipelineManagerVulkan::SetLineWidth(float lineWidth) {
 	if (lineWidth_ == lineWidth)
 		return;
 	lineWidth_ = lineWidth;
+	// Pending pipelines don't know yet whether they draw lines.
+	WaitForPendingPipelines();
 
 	// Wipe all line-drawing pipelines.
 	pipelines_.Iterate([&](const VulkanPipelineKey &key, VulkanPipeline *value) {
@@ -567,6 +682,25 @@ struct VkPipelineCacheHeader {
 	uint8_t uuid[VK_UUID_SIZE];
 };
 
+// Drivers keep everything ever compiled in the cache, so cap what we'll write and read back.
+static const size_t MAX_RAW_PIPELINE_CACHE_SIZE = 64 * 1024 * 1024;
+
+bool PipelineManagerVulkan::ValidatePipelineCacheData(const uint8_t *data, size_t size) const {
+	VkPipelineCacheHeader header;
+	if (size < sizeof(header))
+		return false;
+	memcpy(&header, data, sizeof(header));
+	if (header.headerSize < sizeof(header) || header.headerSize > size)
+		return false;
+	if (header.version != VK_PIPELINE_CACHE_HEADER_VERSION_ONE)
+		return false;
+
+	const VkPhysicalDeviceProperties &props = vulkan_->GetPhysicalDeviceProperties().properties;
+	if (header.vendorId != props.vendorID || header.deviceId != props.deviceID)
+		return false;
+	return memcmp(header.uuid, props.pipelineCacheUUID, VK_UUID_SIZE) == 0;
+}
+
 struct StoredVulkanPipelineKey {
 	VulkanPipelineRasterStateKey raster;
 	VShaderID vShaderID;
@@ -590,20 +724,24 @@ void PipelineManagerVulkan::SaveCache(FILE *file, bool saveRawPipelineCache, Sha
 	uint32_t size;
 
 	if (saveRawPipelineCache) {
-		// WARNING: See comment in LoadCache before using this path.
+		// Stored with our own size and checksum in front, see LoadCache.
+		std::unique_ptr<uint8_t[]> buffer;
 		VkResult result = vkGetPipelineCacheData(vulkan_->GetDevice(), pipelineCache_, &dataSize, nullptr);
-		uint32_t size = (uint32_t)dataSize;
-		if (result != VK_SUCCESS) {
-			size = 0;
-			fwrite(&size, sizeof(size), 1, file);
-			return;
+		if (result == VK_SUCCESS && dataSize != 0 && dataSize <= MAX_RAW_PIPELINE_CACHE_SIZE) {
+			buffer.reset(new uint8_t[dataSize]);
+			result = vkGetPipelineCacheData(vulkan_->GetDevice(), pipelineCache_, &dataSize, buffer.get());
+		}
+		if (result != VK_SUCCESS || !buffer) {
+			dataSize = 0;
 		}
-		std::unique_ptr<uint8_t[]> buffer(new uint8_t[dataSize]);
-		vkGetPipelineCacheData(vulkan_->GetDevice(), pipelineCache_, &dataSize, buffer.get());
 		size = (uint32_t)dataSize;
+		uint32_t checksum = size ? XXH32(buffer.get(), size, 0) : 0;
 		fwrite(&size, sizeof(size), 1, file);
-		fwrite(buffer.get(), 1, size, file);
-		NOTICE_LOG(G3D, "Saved Vulkan pipeline cache (%d bytes).", (int)size);
+		fwrite(&checksum, sizeof(checksum), 1, file);
+		if (size) {
+			fwrite(buffer.get(), 1, size, file);
+			NOTICE_LOG(G3D, "Saved Vulkan pipeline cache (%d bytes).", (int)size);
+		}
 	}
 
 	size_t seekPosOnFailure = ftell(file);
@@ -679,48 +817,52 @@ bool PipelineManagerVulkan::LoadCache(FILE *file, bool loadRawPipelineCache, Sha
 
 	uint32_t size = 0;
 	if (loadRawPipelineCache) {
-		// WARNING: Do not use this path until after reading and implementing https://zeux.io/2019/07/17/serializing-pipeline-cache/ !
-		bool success = fread(&size, sizeof(size), 1, file) == 1;
-		if (!size || !success) {
-			WARN_LOG(G3D, "Zero-sized Vulkan pipeline cache.");
-			return true;
-		}
-		std::unique_ptr<uint8_t[]> buffer(new uint8_t[size]);
-		success = fread(buffer.get(), 1, size, file) == size;
-		// Verify header.
-		VkPipelineCacheHeader *header = (VkPipelineCacheHeader *)buffer.get();
-		if (!success || header->version != VK_PIPELINE_CACHE_HEADER_VERSION_ONE) {
-			// Bad header, don't do anything.
-			WARN_LOG(G3D, "Bad Vulkan pipeline cache header - ignoring");
+		// The driver is supposed to reject data it can't use, but many don't check properly,
+		// so validate the header ourselves and checksum the data against truncation and corruption.
+		uint32_t checksum = 0;
+		bool success = fread(&size, sizeof(size), 1, file) == 1 && fread(&checksum, sizeof(checksum), 1, file) == 1;
+		if (!success || size > MAX_RAW_PIPELINE_CACHE_SIZE) {
+			WARN_LOG(G3D, "Bad Vulkan pipeline cache size");
 			return false;
 		}
-		if (0 != memcmp(header->uuid, vulkan_->GetPhysicalDeviceProperties().properties.pipelineCacheUUID, VK_UUID_SIZE)) {
-			// Wrong hardware/driver/etc.
-			WARN_LOG(G3D, "Bad Vulkan pipeline cache UUID - ignoring");
-			return false;
+		std::unique_ptr<uint8_t[]> buffer;
+		if (size) {
+			buffer.reset(new uint8_t[size]);
+			success = fread(buffer.get(), 1, size, file) == size;
 		}
-
-		VkPipelineCacheCreateInfo pc{ VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO };
-		pc.pInitialData = buffer.get();
-		pc.initialDataSize = size;
-		pc.flags = 0;
-		VkPipelineCache cache;
-		VkResult res = vkCreatePipelineCache(vulkan_->GetDevice(), &pc, nullptr, &cache);
-		if (res != VK_SUCCESS) {
+		if (!success || (size && XXH32(buffer.get(), size, 0) != checksum)) {
+			WARN_LOG(G3D, "Corrupt Vulkan pipeline cache");
 			return false;
 		}
-		if (!pipelineCache_) {
-			pipelineCache_ = cache;
-		} else {
-			vkMergePipelineCaches(vulkan_->GetDevice(), pipelineCache_, 1, &cache);
+
+		if (size && !ValidatePipelineCacheData(buffer.get(), size)) {
+			// Written by a different GPU or driver version.  The pipeline keys below are still fine.
+			WARN_LOG(G3D, "Vulkan pipeline cache is from a different device or driver - ignoring");
+			size = 0;
 		}
-		NOTICE_LOG(G3D, "Loaded Vulkan pipeline cache (%d bytes).", (int)size);
-	} else {
-		if (!pipelineCache_) {
+		if (size) {
 			VkPipelineCacheCreateInfo pc{ VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO };
-			VkResult res = vkCreatePipelineCache(vulkan_->GetDevice(), &pc, nullptr, &pipelineCache_);
+			pc.pInitialData = buffer.get();
+			pc.initialDataSize = size;
+			pc.flags = 0;
+			VkPipelineCache cache;
+			VkResult res = vkCreatePipelineCache(vulkan_->GetDevice(), &pc, nullptr, &cache);
+			if (res != VK_SUCCESS) {
+				return false;
+			}
+			if (!pipelineCache_) {
+				pipelineCache_ = cache;
+			} else {
+				vkMergePipelineCaches(vulkan_->GetDevice(), pipelineCache_, 1, &cache);
+				vkDestroyPipelineCache(vulkan_->GetDevice(), cache, nullptr);
+			}
+			NOTICE_LOG(G3D, "Loaded Vulkan pipeline cache (%d bytes).", (int)size);
 		}
 	}
+	if (!pipelineCache_) {
+		VkPipelineCacheCreateInfo pc{ VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO };
+		VkResult res = vkCreatePipelineCache(vulkan_->GetDevice(), &pc, nullptr, &pipelineCache_);
+	}
 
 	// Read the number of pipelines.
 	bool failed = fread(&size, sizeof(size), 1, file) != 1;
@@ -755,7 +897,7 @@ bool PipelineManagerVulkan::LoadCache(FILE *file, bool loadRawPipelineCache, Sha
 		fmt.InitializeFromID(key.vtxFmtId);
 		GetOrCreatePipeline(layout, rp, key.raster,
 			key.useHWTransform ? &fmt : 0,
-			vs, fs, key.useHWTransform);
+			vs, fs, key.useHWTransform, false);
 	}
 	NOTICE_LOG(G3D, "Recreated Vulkan pipeline cache (%d pipelines).", (int)size);
 	return true;
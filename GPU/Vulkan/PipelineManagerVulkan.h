@@ -17,7 +17,14 @@
 
 #pragma once
 
+#include <atomic>
+#include <condition_variable>
 #include <cstring>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+
 #include "Common/Hashmaps.h"
 
 #include "GPU/Common/VertexDecoderCommon.h"
@@ -59,6 +66,8 @@ struct VulkanPipelineKey {
 enum PipelineFlags {
 	PIPELINE_FLAG_USES_LINES = (1 << 2),
 	PIPELINE_FLAG_USES_BLEND_CONSTANT = (1 << 3),
+	// Still being created on the compile thread.  The pipeline is VK_NULL_HANDLE until then.
+	PIPELINE_FLAG_PENDING = (1 << 4),
 };
 
 // Simply wraps a Vulkan pipeline, providing some metadata.
@@ -69,6 +78,7 @@ struct VulkanPipeline {
 	// Convenience.
 	bool UsesBlendConstant() const { return (flags & PIPELINE_FLAG_USES_BLEND_CONSTANT) != 0; }
 	bool UsesLines() const { return (flags & PIPELINE_FLAG_USES_LINES) != 0; }
+	bool IsPending() const { return (flags & PIPELINE_FLAG_PENDING) != 0; }
 };
 
 class VulkanContext;
@@ -82,8 +92,11 @@ class PipelineManagerVulkan {
 	PipelineManagerVulkan(VulkanContext *ctx);
 	~PipelineManagerVulkan();
 
-	VulkanPipeline *GetOrCreatePipeline(VkPipelineLayout layout, VkRenderPass renderPass, const VulkanPipelineRasterStateKey &rasterKey, const DecVtxFormat *decFmt, VulkanVertexShader *vs, VulkanFragmentShader *fs, bool useHwTransform);
+	// If async is set, a new pipeline is created on the compile thread and this returns nullptr
+	// until it's ready, so the draw can be skipped.
+	VulkanPipeline *GetOrCreatePipeline(VkPipelineLayout layout, VkRenderPass renderPass, const VulkanPipelineRasterStateKey &rasterKey, const DecVtxFormat *decFmt, VulkanVertexShader *vs, VulkanFragmentShader *fs, bool useHwTransform, bool async);
 	int GetNumPipelines() const { return (int)pipelines_.size(); }
+	int GetNumPendingPipelines() const { return numPending_; }
 
 	void Clear();
 
@@ -101,9 +114,42 @@ class PipelineManagerVulkan {
 	void CancelCache();
 
 private:
+	struct PipelineJob {
+		// The placeholder in pipelines_ that gets filled in when done.
+		VulkanPipeline *target;
+		VkPipelineLayout layout;
+		VkRenderPass renderPass;
+		VulkanPipelineRasterStateKey rasterKey;
+		DecVtxFormat decFmt;
+		VulkanVertexShader *vs;
+		VulkanFragmentShader *fs;
+		bool useHwTransform;
+		float lineWidth;
+		VulkanPipeline *result;
+	};
+
+	bool ValidatePipelineCacheData(const uint8_t *data, size_t size) const;
+
+	void QueuePipeline(const PipelineJob &job);
+	void ProcessFinishedPipelines();
+	// Jobs point at shaders and placeholders, so this must be called before deleting either.
+	void WaitForPendingPipelines();
+	void CompileThread();
+
 	DenseHashMap<VulkanPipelineKey, VulkanPipeline *, nullptr> pipelines_;
 	VkPipelineCache pipelineCache_ = VK_NULL_HANDLE;
 	VulkanContext *vulkan_;
 	float lineWidth_ = 1.0f;
 	bool cancelCache_ = false;
+
+	std::thread compileThread_;
+	std::mutex compileMutex_;
+	std::condition_variable compileWake_;
+	std::condition_variable compileDone_;
+	std::deque<PipelineJob> compileQueue_;
+	std::vector<PipelineJob> compiled_;
+	std::atomic<bool> hasCompiled_;
+	bool compiling_ = false;
+	bool compileExit_ = false;
+	int numPending_ = 0;
 };
@@ -240,7 +240,11 @@ void ShaderManagerVulkan::GetShaders(int prim, u32 vertType, VulkanVertexShader
 	FShaderID FSID;
 	if (gstate_c.IsDirty(DIRTY_FRAGMENTSHADER_STATE)) {
 		gstate_c.Clean(DIRTY_FRAGMENTSHADER_STATE);
-		ComputeFragmentShaderID(&FSID, draw_->GetBugs());
+		ComputeFragmentShaderID(&FSID, draw_->GetBugs(), g_Config.bFragmentUbershader);
+		if (FSID.Bit(FS_BIT_UBERSHADER)) {
+			// The same state changes now go into the uniform instead.
+			gstate_c.Dirty(DIRTY_FS_UBERSTATE);
+		}
 	} else {
 		FSID = lastFSID_;
 	}
@@ -358,10 +362,11 @@ VulkanFragmentShader *ShaderManagerVulkan::GetFragmentShaderFromModule(VkShaderM
 // the same game, we simply compile all the shaders from the start, so we don't have to
 // compile them on the fly later. We also store the Vulkan pipeline cache, so if it contains
 // pipelines compiled from SPIR-V matching these shaders, pipeline creation will be practically
-// instantaneous.
+// instantaneous.  The vertex types seen are stored in between, so the decoders get JIT compiled
+// up front too.
 
 #define CACHE_HEADER_MAGIC 0xff51f420 
-#define CACHE_VERSION 17
+#define CACHE_VERSION 18
 struct VulkanCacheHeader {
 	uint32_t magic;
 	uint32_t version;
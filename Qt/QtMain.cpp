@@ -461,7 +461,7 @@ bool MainUI::event(QEvent *e) {
 
 	default:
 		if (e->type() == browseFileEvent) {
-			QString fileName = QFileDialog::getOpenFileName(nullptr, "Load ROM", g_Config.currentDirectory.c_str(), "PSP ROMs (*.iso *.cso *.pbp *.elf *.zip *.ppdmp)");
+			QString fileName = QFileDialog::getOpenFileName(nullptr, "Load ROM", g_Config.currentDirectory.c_str(), "PSP ROMs (*.iso *.cso *.szo *.pbp *.elf *.zip *.ppdmp)");
 			if (QFile::exists(fileName)) {
 				QDir newPath;
 				g_Config.currentDirectory = newPath.filePath(fileName).toStdString();
@@ -142,7 +142,7 @@ void MainWindow::bootDone()
 /* SIGNALS */
 void MainWindow::openAct()
 {
-	QString filename = QFileDialog::getOpenFileName(NULL, "Load File", g_Config.currentDirectory.c_str(), "PSP ROMs (*.pbp *.elf *.iso *.cso *.prx)");
+	QString filename = QFileDialog::getOpenFileName(NULL, "Load File", g_Config.currentDirectory.c_str(), "PSP ROMs (*.pbp *.elf *.iso *.cso *.szo *.prx)");
 	if (QFile::exists(filename))
 	{
 		QFileInfo info(filename);
@@ -354,6 +354,7 @@ static const JitDisableFlag jitDisableFlags[] = {
 	{ MIPSComp::JitDisable::LSU_VFPU, "LSU_VFPU" },
 	{ MIPSComp::JitDisable::SIMD, "SIMD" },
 	{ MIPSComp::JitDisable::BLOCKLINK, "Block Linking" },
+	{ MIPSComp::JitDisable::SUPERBLOCKS, "IR superblocks" },
 	{ MIPSComp::JitDisable::POINTERIFY, "Pointerify" },
 	{ MIPSComp::JitDisable::STATIC_ALLOC, "Static regalloc" },
 	{ MIPSComp::JitDisable::CACHE_POINTERS, "Cached pointers" },
@@ -213,6 +213,7 @@ void EmuScreen::bootGame(const std::string &filename) {
 
 	CoreParameter coreParam{};
 	coreParam.cpuCore = (CPUCore)g_Config.iCpuCore;
+	coreParam.irBackend = (IRBackend)g_Config.iIRBackend;
 	coreParam.gpuCore = GPUCORE_GLES;
 	switch (GetGPUBackend()) {
 	case GPUBackend::DIRECT3D11:
@@ -416,6 +416,7 @@ void System_SendMessage(const char *command, const char *parameter) {
 
 		// These are single files that can be loaded directly using StorageFileLoader.
 		picker->FileTypeFilter->Append(".cso");
+		picker->FileTypeFilter->Append(".szo");
 		picker->FileTypeFilter->Append(".iso");
 
 		// Can't load these this way currently, they require mounting the underlying folder.
@@ -87,6 +87,7 @@ bool RunTests() {
 
 	CoreParameter coreParam;
 	coreParam.cpuCore = (CPUCore)g_Config.iCpuCore;
+	coreParam.irBackend = (IRBackend)g_Config.iIRBackend;
 	coreParam.gpuCore = GPUCORE_NULL;
 	coreParam.enableSound = g_Config.bEnableSound;
 	coreParam.graphicsContext = nullptr;
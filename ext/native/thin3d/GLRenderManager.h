@@ -287,6 +287,12 @@ class GLPushBuffer {
 		return writePtr_ + off;
 	}
 
+	// Gives back the end of the latest allocation, when less of it was used than reserved.
+	void Rewind(size_t offset) {
+		assert(offset <= offset_);
+		offset_ = (offset + 3) & ~3;
+	}
+
 	size_t GetTotalSize() const;
 
 	void Destroy(bool onRenderThread);
@@ -5,6 +5,7 @@
 #include <cstdio>
 #include <cstdlib>
 #include <limits>
+#include <memory>
 
 #include "file/zip_read.h"
 #include "profiler/profiler.h"
@@ -15,9 +16,12 @@
 #include "Core/Core.h"
 #include "Core/CoreTiming.h"
 #include "Core/System.h"
+#include "Core/FileSystems/BlockDevices.h"
 #include "Core/HLE/sceUtility.h"
 #include "Core/Host.h"
+#include "Core/Loaders.h"
 #include "Core/SaveState.h"
+#include "Core/TextureReplacer.h"
 #include "GPU/Common/FramebufferCommon.h"
 #include "Log.h"
 #include "LogManager.h"
@@ -109,8 +113,13 @@ int printUsage(const char *progname, const char *reason)
 	fprintf(stderr, "  -v, --verbose         show the full passed/failed result\n");
 	fprintf(stderr, "  -i                    use the interpreter\n");
 	fprintf(stderr, "  --ir                  use ir interpreter\n");
+	fprintf(stderr, "  --irnative            use ir with the native backend\n");
+	fprintf(stderr, "  --irthreaded          use ir with the threaded interpreter\n");
 	fprintf(stderr, "  -j                    use jit (default)\n");
 	fprintf(stderr, "  -c, --compare         compare with output in file.expected\n");
+	fprintf(stderr, "  --pack-textures=DIR   write DIR/textures.pak from the texture replacements in DIR\n");
+	fprintf(stderr, "  --compress-iso=FILE   write an .szo (snappy compressed) copy of an ISO or CSO next to it\n");
+	fprintf(stderr, "  --szo-frame-size=N    compress in frames of N bytes (default 16384)\n");
 	fprintf(stderr, "\nSee headless.txt for details.\n");
 
 	return 1;
@@ -130,6 +139,26 @@ static HeadlessHost *getHost(GPUCore gpuCore) {
 	}
 }
 
+static bool CompressISO(const std::string &filename, u32 frameSize, std::string *outFilename, std::string *error) {
+	std::unique_ptr<FileLoader> fileLoader(ConstructFileLoader(filename));
+	std::unique_ptr<BlockDevice> blockDevice(constructBlockDevice(fileLoader.get()));
+	if (!blockDevice) {
+		*error = "Unable to open " + filename;
+		return false;
+	}
+
+	size_t dot = filename.find_last_of('.');
+	if (dot == std::string::npos || filename.find_first_of("/\\", dot) != std::string::npos) {
+		dot = filename.size();
+	}
+	*outFilename = filename.substr(0, dot) + ".szo";
+	if (*outFilename == filename) {
+		*error = "Already an .szo file: " + filename;
+		return false;
+	}
+	return WriteSZSOImage(blockDevice.get(), *outFilename, frameSize, error);
+}
+
 bool RunAutoTest(HeadlessHost *headlessHost, CoreParameter &coreParameter, bool autoCompare, bool verbose, double timeout)
 {
 	if (teamCityMode) {
@@ -228,11 +257,15 @@ int main(int argc, const char* argv[])
 	const char *stateToLoad = 0;
 	GPUCore gpuCore = GPUCORE_NULL;
 	CPUCore cpuCore = CPUCore::JIT;
+	IRBackend irBackend = IRBackend::INTERPRETER;
 
 	std::vector<std::string> testFilenames;
 	const char *mountIso = 0;
 	const char *mountRoot = 0;
 	const char *screenshotFilename = 0;
+	const char *packTexturesDir = 0;
+	const char *compressIsoFile = 0;
+	u32 szoFrameSize = 16384;
 	float timeout = std::numeric_limits<float>::infinity();
 
 	for (int i = 1; i < argc; i++)
@@ -257,6 +290,16 @@ int main(int argc, const char* argv[])
 			cpuCore = CPUCore::JIT;
 		else if (!strcmp(argv[i], "--ir"))
 			cpuCore = CPUCore::IR_JIT;
+		else if (!strcmp(argv[i], "--irnative"))
+		{
+			cpuCore = CPUCore::IR_JIT;
+			irBackend = IRBackend::NATIVE;
+		}
+		else if (!strcmp(argv[i], "--irthreaded"))
+		{
+			cpuCore = CPUCore::IR_JIT;
+			irBackend = IRBackend::THREADED;
+		}
 		else if (!strcmp(argv[i], "-c") || !strcmp(argv[i], "--compare"))
 			autoCompare = true;
 		else if (!strcmp(argv[i], "-v") || !strcmp(argv[i], "--verbose"))
@@ -290,6 +333,12 @@ int main(int argc, const char* argv[])
 			screenshotFilename = argv[i] + strlen("--screenshot=");
 		else if (!strncmp(argv[i], "--timeout=", strlen("--timeout=")) && strlen(argv[i]) > strlen("--timeout="))
 			timeout = strtod(argv[i] + strlen("--timeout="), NULL);
+		else if (!strncmp(argv[i], "--pack-textures=", strlen("--pack-textures=")) && strlen(argv[i]) > strlen("--pack-textures="))
+			packTexturesDir = argv[i] + strlen("--pack-textures=");
+		else if (!strncmp(argv[i], "--compress-iso=", strlen("--compress-iso=")) && strlen(argv[i]) > strlen("--compress-iso="))
+			compressIsoFile = argv[i] + strlen("--compress-iso=");
+		else if (!strncmp(argv[i], "--szo-frame-size=", strlen("--szo-frame-size=")) && strlen(argv[i]) > strlen("--szo-frame-size="))
+			szoFrameSize = (u32)strtoul(argv[i] + strlen("--szo-frame-size="), NULL, 10);
 		else if (!strcmp(argv[i], "--teamcity"))
 			teamCityMode = true;
 		else if (!strncmp(argv[i], "--state=", strlen("--state=")) && strlen(argv[i]) > strlen("--state="))
@@ -311,6 +360,31 @@ int main(int argc, const char* argv[])
 			testFilenames.push_back(temp);
 	}
 
+	if (packTexturesDir != 0)
+	{
+		std::string error;
+		if (!TextureReplacer::GeneratePack(packTexturesDir, &error))
+		{
+			fprintf(stderr, "Failed to pack textures: %s\n", error.c_str());
+			return 1;
+		}
+		printf("Wrote %s/textures.pak\n", packTexturesDir);
+		return 0;
+	}
+
+	if (compressIsoFile != 0)
+	{
+		std::string outFilename;
+		std::string error;
+		if (!CompressISO(compressIsoFile, szoFrameSize, &outFilename, &error))
+		{
+			fprintf(stderr, "Failed to compress %s: %s\n", compressIsoFile, error.c_str());
+			return 1;
+		}
+		printf("Wrote %s\n", outFilename.c_str());
+		return 0;
+	}
+
 	if (testFilenames.empty())
 		return printUsage(argv[0], argc <= 1 ? NULL : "No executables specified");
 
@@ -336,6 +410,7 @@ int main(int argc, const char* argv[])
 
 	CoreParameter coreParameter;
 	coreParameter.cpuCore = cpuCore;
+	coreParameter.irBackend = irBackend;
 	coreParameter.gpuCore = glWorking ? gpuCore : GPUCORE_NULL;
 	coreParameter.graphicsContext = graphicsContext;
 	coreParameter.enableSound = false;
@@ -30,6 +30,7 @@
 #include <cmath>
 #include <string>
 #include <sstream>
+#include <vector>
 
 #include "base/NativeApp.h"
 #include "base/logging.h"
@@ -41,10 +42,15 @@
 #include "Common/ArmEmitter.h"
 #include "Common/BitScan.h"
 #include "Common/CPUDetect.h"
+#include "Common/FileUtil.h"
 #include "Core/Config.h"
+#include "Core/FileLoaders/LocalFileLoader.h"
+#include "Core/FileSystems/BlockDevices.h"
 #include "Core/FileSystems/ISOFileSystem.h"
+#include "Core/Host.h"
 #include "Core/MemMap.h"
 #include "Core/MIPS/MIPSVFPUUtils.h"
+#include "Core/TexturePack.h"
 #include "GPU/Common/TextureDecoder.h"
 
 #include "unittest/JitHarness.h"
@@ -534,6 +540,224 @@ static bool TestMemMap() {
 	return true;
 }
 
+// Read errors get reported to the user through the host.
+class UnitTestHost : public Host {
+public:
+	bool InitGraphics(std::string *error_string, GraphicsContext **ctx) override { return false; }
+	void ShutdownGraphics() override {}
+	void InitSound() override {}
+	void ShutdownSound() override {}
+};
+
+static UnitTestHost unitTestHost;
+
+class MemoryBlockDevice : public BlockDevice {
+public:
+	MemoryBlockDevice(const std::vector<u8> &data) : data_(data) {}
+	bool ReadBlock(int blockNumber, u8 *outPtr, bool uncached = false) override {
+		memcpy(outPtr, &data_[blockNumber * GetBlockSize()], GetBlockSize());
+		return true;
+	}
+	u32 GetNumBlocks() override { return (u32)(data_.size() / GetBlockSize()); }
+
+private:
+	const std::vector<u8> &data_;
+};
+
+static bool WriteTestFile(const std::string &filename, const std::vector<u8> &data) {
+	FILE *f = File::OpenCFile(filename, "wb");
+	if (!f) {
+		return false;
+	}
+	bool success = fwrite(&data[0], 1, data.size(), f) == data.size();
+	fclose(f);
+	return success;
+}
+
+static bool ReadTestFile(const std::string &filename, std::vector<u8> *data) {
+	FILE *f = File::OpenCFile(filename, "rb");
+	if (!f) {
+		return false;
+	}
+	fseek(f, 0, SEEK_END);
+	data->resize(ftell(f));
+	fseek(f, 0, SEEK_SET);
+	bool success = fread(&(*data)[0], 1, data->size(), f) == data->size();
+	fclose(f);
+	return success;
+}
+
+static bool CheckSZSOReads(const std::string &filename, const std::vector<u8> &iso) {
+	const int blockSize = 2048;
+	const u32 numBlocks = (u32)(iso.size() / blockSize);
+	LocalFileLoader loader(filename);
+	SZSOFileBlockDevice device(&loader);
+	EXPECT_EQ_INT(device.GetNumBlocks(), numBlocks);
+
+	std::vector<u8> buf((numBlocks + 4) * blockSize);
+	for (u32 b = 0; b < numBlocks; ++b) {
+		EXPECT_TRUE(device.ReadBlock(b, &buf[0]));
+		EXPECT_TRUE(memcmp(&buf[0], &iso[b * blockSize], blockSize) == 0);
+	}
+
+	// Whole frames, parts of frames at either end, across plain frames, and everything at once.
+	static const u32 ranges[][2] = {
+		{ 0, 4 }, { 4, 8 }, { 1, 2 }, { 3, 6 }, { 6, 11 }, { 2, 21 }, { 0, 30 },
+	};
+	for (const auto &range : ranges) {
+		EXPECT_TRUE(device.ReadBlocks(range[0], range[1], &buf[0]));
+		EXPECT_TRUE(memcmp(&buf[0], &iso[range[0] * blockSize], range[1] * blockSize) == 0);
+	}
+
+	// Past the end is zero filled.
+	memset(&buf[0], 0xFF, buf.size());
+	device.ReadBlocks(numBlocks - 2, 4, &buf[0]);
+	EXPECT_TRUE(memcmp(&buf[0], &iso[(numBlocks - 2) * blockSize], 2 * blockSize) == 0);
+	for (int i = 2 * blockSize; i < 4 * blockSize; ++i) {
+		EXPECT_EQ_INT(buf[i], 0);
+	}
+	EXPECT_FALSE(device.ReadBlock(numBlocks, &buf[0]));
+	return true;
+}
+
+static bool TestSZSO() {
+	const int blockSize = 2048;
+	const u32 frameSize = 8192;
+	// 7 frames and a partial one.  Frames 1, 3 and 5 are noise, which snappy stores plain.
+	const u32 numBlocks = 30;
+	std::vector<u8> iso(numBlocks * blockSize);
+	u32 seed = 0x1234567;
+	for (size_t i = 0; i < iso.size(); ++i) {
+		const size_t frame = i / frameSize;
+		seed = seed * 1103515245 + 12345;
+		iso[i] = (frame & 1) && frame < 7 ? (u8)(seed >> 16) : (u8)(i / 97);
+	}
+
+	const std::string filename = "unittest_szso.tmp";
+	// Put things back however the test exits.
+	struct Restore {
+		Host *oldHost;
+		bool oldMemoryMap;
+		const std::string &filename;
+		~Restore() {
+			host = oldHost;
+			g_Config.bMemoryMapIso = oldMemoryMap;
+			File::Delete(filename);
+		}
+	} restore{ host, g_Config.bMemoryMapIso, filename };
+	host = &unitTestHost;
+
+	MemoryBlockDevice source(iso);
+	std::string error;
+	EXPECT_FALSE(WriteSZSOImage(&source, filename, 3000, &error));
+	EXPECT_TRUE(WriteSZSOImage(&source, filename, frameSize, &error));
+
+	std::vector<u8> image;
+	EXPECT_TRUE(ReadTestFile(filename, &image));
+	EXPECT_TRUE(image.size() < iso.size());
+
+	for (bool memoryMap : { false, true }) {
+		g_Config.bMemoryMapIso = memoryMap;
+		EXPECT_TRUE(CheckSZSOReads(filename, iso));
+	}
+
+	// The header is 0x18 bytes, then the index of 9 offsets.
+	const size_t indexOffset = 0x18;
+	std::vector<u8> corrupt;
+	std::vector<u8> buf(numBlocks * blockSize);
+	for (bool memoryMap : { false, true }) {
+		g_Config.bMemoryMapIso = memoryMap;
+
+		// Truncated in the last frame: the start still reads, the end fails without crashing.
+		corrupt.assign(image.begin(), image.end() - 10);
+		EXPECT_TRUE(WriteTestFile(filename, corrupt));
+		{
+			LocalFileLoader loader(filename);
+			SZSOFileBlockDevice device(&loader);
+			EXPECT_TRUE(device.ReadBlocks(0, 8, &buf[0]));
+			EXPECT_TRUE(memcmp(&buf[0], &iso[0], 8 * blockSize) == 0);
+			EXPECT_FALSE(device.ReadBlock(28, &buf[0]));
+			device.ReadBlocks(0, numBlocks, &buf[0]);
+		}
+
+		// Index going backwards: that frame fails, the others still read.
+		corrupt = image;
+		u64 offset;
+		memcpy(&offset, &corrupt[indexOffset + 8 * 2], sizeof(offset));
+		offset += 0x100000;
+		memcpy(&corrupt[indexOffset + 8 * 2], &offset, sizeof(offset));
+		EXPECT_TRUE(WriteTestFile(filename, corrupt));
+		{
+			LocalFileLoader loader(filename);
+			SZSOFileBlockDevice device(&loader);
+			EXPECT_FALSE(device.ReadBlock(9, &buf[0]));
+			EXPECT_FALSE(device.ReadBlocks(0, numBlocks, &buf[0]));
+			EXPECT_TRUE(memcmp(&buf[0], &iso[0], 8 * blockSize) == 0);
+			EXPECT_TRUE(device.ReadBlock(20, &buf[0]));
+			EXPECT_TRUE(memcmp(&buf[0], &iso[20 * blockSize], blockSize) == 0);
+		}
+
+		// Index truncated away.
+		corrupt.assign(image.begin(), image.begin() + indexOffset + 8 * 3);
+		EXPECT_TRUE(WriteTestFile(filename, corrupt));
+		{
+			LocalFileLoader loader(filename);
+			SZSOFileBlockDevice device(&loader);
+			EXPECT_EQ_INT(device.GetNumBlocks(), 0);
+			EXPECT_FALSE(device.ReadBlock(0, &buf[0]));
+		}
+	}
+
+	return true;
+}
+
+static bool TestTexturePack() {
+	const std::string filename = "unittest_textures.tmp";
+	static const char *const names[] = { "a.png", "sub/b.png", "c.png" };
+	static const int sizes[][2] = { { 4, 4 }, { 16, 2 }, { 1, 1 } };
+
+	std::vector<std::vector<u8>> images;
+	{
+		TexturePackWriter writer;
+		EXPECT_TRUE(writer.Begin(filename));
+		for (int i = 0; i < ARRAY_SIZE(names); ++i) {
+			std::vector<u8> data(sizes[i][0] * sizes[i][1] * 4);
+			for (size_t j = 0; j < data.size(); ++j) {
+				data[j] = (u8)(j * 13 + i);
+			}
+			EXPECT_TRUE(writer.Add(names[i], sizes[i][0], sizes[i][1], i, &data[0]));
+			images.push_back(data);
+		}
+		EXPECT_TRUE(writer.Finish());
+	}
+
+	TexturePack pack;
+	EXPECT_TRUE(pack.Open(filename));
+	for (int i = 0; i < ARRAY_SIZE(names); ++i) {
+		const TexturePackEntry *entry = pack.Find(names[i]);
+		EXPECT_TRUE(entry != nullptr);
+		EXPECT_EQ_INT(entry->w, (u32)sizes[i][0]);
+		EXPECT_EQ_INT(entry->h, (u32)sizes[i][1]);
+		EXPECT_EQ_INT(entry->alphaStatus, (u32)i);
+		EXPECT_TRUE(((uintptr_t)pack.GetData(entry) & 15) == 0);
+		EXPECT_TRUE(memcmp(pack.GetData(entry), &images[i][0], images[i].size()) == 0);
+	}
+	EXPECT_TRUE(pack.Find("missing.png") == nullptr);
+	EXPECT_TRUE(pack.Find("b.png") == nullptr);
+	pack.Close();
+
+	// A truncated pack must be refused, not read past the end.
+	std::vector<u8> data;
+	EXPECT_TRUE(ReadTestFile(filename, &data));
+	data.resize(data.size() - sizeof(TexturePackEntry));
+	EXPECT_TRUE(WriteTestFile(filename, data));
+	EXPECT_FALSE(pack.Open(filename));
+	EXPECT_FALSE(pack.IsOpen());
+
+	File::Delete(filename);
+	return true;
+}
+
 typedef bool (*TestFunc)();
 struct TestItem {
 	const char *name;
@@ -568,6 +792,8 @@ TestItem availableTests[] = {
 	TEST_ITEM(QuickTexHash),
 	TEST_ITEM(CLZ),
 	TEST_ITEM(MemMap),
+	TEST_ITEM(TexturePack),
+	TEST_ITEM(SZSO),
 };
 
 int main(int argc, const char *argv[]) {